@@ -0,0 +1,59 @@
+#include "cpudispatch.h"
+#include "logger.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPUDISPATCH_X86
+#endif
+
+bool cpuSupports(CpuFeature feature) {
+#ifdef CPUDISPATCH_X86
+  static const bool initialized = (__builtin_cpu_init(), true);
+  (void)initialized;
+#endif
+
+  switch (feature) {
+  case CPU_SCALAR:
+    return true;
+#ifdef CPUDISPATCH_X86
+  case CPU_SSE2:
+    return __builtin_cpu_supports("sse2");
+  case CPU_POPCNT:
+    return __builtin_cpu_supports("popcnt");
+  case CPU_AVX:
+    return __builtin_cpu_supports("avx");
+  case CPU_AVX2:
+    return __builtin_cpu_supports("avx2");
+  case CPU_AVX2_FMA:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#ifdef __ARM_NEON
+  case CPU_NEON:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+const char *cpuFeatureName(CpuFeature feature) {
+  switch (feature) {
+  case CPU_SSE2:
+    return "sse2";
+  case CPU_POPCNT:
+    return "popcnt";
+  case CPU_AVX:
+    return "avx";
+  case CPU_AVX2:
+    return "avx2";
+  case CPU_AVX2_FMA:
+    return "avx2/fma";
+  case CPU_NEON:
+    return "neon";
+  default:
+    return "scalar";
+  }
+}
+
+void reportKernel(const char *kernel, CpuFeature feature) {
+  DBG("Using the %s %s kernel", cpuFeatureName(feature), kernel);
+}
@@ -0,0 +1,59 @@
+#ifndef CPUDISPATCH_H
+#define CPUDISPATCH_H
+
+#include <initializer_list>
+#include <vector>
+
+// Instruction set extensions a SIMD kernel can be built for
+enum CpuFeature {
+  CPU_SCALAR, // plain C++, always available
+  CPU_SSE2,
+  CPU_POPCNT,
+  CPU_AVX,
+  CPU_AVX2,
+  CPU_AVX2_FMA,
+  CPU_NEON
+};
+
+// Checked once per process, false for features of another architecture
+bool cpuSupports(CpuFeature feature);
+const char *cpuFeatureName(CpuFeature feature);
+
+// Logs the variant picked for a kernel when running verbose
+void reportKernel(const char *kernel, CpuFeature feature);
+
+template <typename Kernel> struct KernelVariant {
+  CpuFeature feature;
+  Kernel kernel;
+};
+
+// The builds of one kernel, listed widest first and ending with the scalar
+// one. Only those the CPU can run are kept and the first of them is used.
+// Modules hold one in a function local static so the CPU is only checked,
+// and the choice only reported, once.
+template <typename Kernel> class KernelDispatch {
+public:
+  KernelDispatch(const char *name,
+                 std::initializer_list<KernelVariant<Kernel>> variants) {
+    for (const KernelVariant<Kernel> &variant : variants)
+      if (cpuSupports(variant.feature))
+        supported.push_back(variant);
+    reportKernel(name, supported.front().feature);
+  }
+
+  Kernel best() const { return supported.front().kernel; }
+  const char *bestName() const {
+    return cpuFeatureName(supported.front().feature);
+  }
+
+  // every variant this CPU can run, best first, for checking one against
+  // another
+  const std::vector<KernelVariant<Kernel>> &variants() const {
+    return supported;
+  }
+
+private:
+  std::vector<KernelVariant<Kernel>> supported;
+};
+
+#endif // CPUDISPATCH_H
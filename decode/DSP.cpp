@@ -2,6 +2,7 @@
 
 #include "DSP.h"
 #include <QDebug>
+#include <algorithm>
 
 //---------------------------------------------------------------------------
 
@@ -96,7 +97,37 @@ cpx_type WaveTable::WTCISValue_conj() {
   return std::conj(tringlookup.CISWT[tint]);
 }
 
-double WaveTable::WTSinValue() {
+void WaveTable::WTCISBlock(cpx_type *out, int n) {
+  for (int i = 0; i < n; i++) {
+    out[i] = WTCISValue();
+    WTnextFrame();
+  }
+}
+
+void MixBlock(const dsp_t *in, const cpx_type *phasor, cpx_type *out, int n) {
+  const dsp_t *p = reinterpret_cast<const dsp_t *>(phasor);
+  dsp_t *o = reinterpret_cast<dsp_t *>(out);
+  for (int i = 0; i < n; i++) {
+    const dsp_t x = in[i];
+    o[2 * i] = p[2 * i] * x;
+    o[2 * i + 1] = p[2 * i + 1] * x;
+  }
+}
+
+void MixConjBlock(const cpx_type *in, const cpx_type *phasor, cpx_type *out,
+                  int n) {
+  const dsp_t *x = reinterpret_cast<const dsp_t *>(in);
+  const dsp_t *p = reinterpret_cast<const dsp_t *>(phasor);
+  dsp_t *o = reinterpret_cast<dsp_t *>(out);
+  for (int i = 0; i < n; i++) {
+    const dsp_t re = x[2 * i], im = x[2 * i + 1];
+    const dsp_t pre = p[2 * i], pim = p[2 * i + 1];
+    o[2 * i] = re * pre + im * pim;
+    o[2 * i + 1] = im * pre - re * pim;
+  }
+}
+
+dsp_t WaveTable::WTSinValue() {
   tint = (int)WTptr;
   if (tint >= WTSIZE)
     tint = 0;
@@ -105,7 +136,7 @@ double WaveTable::WTSinValue() {
   return tringlookup.SinWT[tint];
 }
 
-double WaveTable::WTSinValue(double PlusFractOfSample) {
+dsp_t WaveTable::WTSinValue(double PlusFractOfSample) {
   double ts = WTptr;
   ts += PlusFractOfSample * WTstep;
   if (((int)ts) >= WTSIZE)
@@ -118,7 +149,7 @@ double WaveTable::WTSinValue(double PlusFractOfSample) {
   return tringlookup.SinWT[tint];
 }
 
-double WaveTable::WTCosValue() {
+dsp_t WaveTable::WTCosValue() {
   tint = (int)WTptr;
   if (tint >= WTSIZE)
     tint = 0;
@@ -127,7 +158,7 @@ double WaveTable::WTCosValue() {
   return tringlookup.CosWT[tint];
 }
 
-double WaveTable::WTCosValue(double PlusFractOfSample) {
+dsp_t WaveTable::WTCosValue(double PlusFractOfSample) {
   double ts = WTptr;
   ts += PlusFractOfSample * WTstep;
   if (((int)ts) >= WTSIZE)
@@ -263,6 +294,22 @@ void WaveTable::SetWTptr(double FractionOfWave, double PlusNumberOfFrames) {
 
 //---------------------------------------------------------------------------
 
+// Dot product split over FIR_LANES independent sums so the compiler can
+// vectorize it without reassociating the additions
+static inline dsp_t FIRDot(const dsp_t *points, const dsp_t *window, int n) {
+  dsp_t lane[FIR_LANES] = {0};
+  int i = 0;
+  for (; i + FIR_LANES <= n; i += FIR_LANES)
+    for (int k = 0; k < FIR_LANES; k++)
+      lane[k] += points[i + k] * window[i + k];
+  dsp_t sum = 0;
+  for (; i < n; i++)
+    sum += points[i] * window[i];
+  for (int k = 0; k < FIR_LANES; k++)
+    sum += lane[k];
+  return sum;
+}
+
 FIR::FIR(int _NumberOfPoints) {
   int i;
   points = 0;
@@ -270,11 +317,14 @@ FIR::FIR(int _NumberOfPoints) {
 
   NumberOfPoints = _NumberOfPoints;
   buffsize = NumberOfPoints + 1;
-  points = new double[NumberOfPoints];
+  points = new dsp_t[NumberOfPoints];
   for (i = 0; i < NumberOfPoints; i++)
     points[i] = 0;
-  buff = new double[buffsize];
-  for (i = 0; i < buffsize; i++)
+
+  // every sample is stored twice, buffsize apart, so the window starting at
+  // ptr is always contiguous
+  buff = new dsp_t[2 * buffsize];
+  for (i = 0; i < 2 * buffsize; i++)
     buff[i] = 0;
   ptr = 0;
   outsum = 0;
@@ -287,63 +337,62 @@ FIR::~FIR() {
     delete[] buff;
 }
 
-double FIR::FIRUpdateAndProcess(double sig) {
-  buff[ptr] = sig;
-  ptr++;
-  if (ptr >= buffsize)
-    ptr = 0; // ptr%=buffsize;
-  int tptr = ptr;
-  outsum = 0;
-  for (int i = 0; i < NumberOfPoints; i++) {
-    outsum += points[i] * buff[tptr];
-    tptr++;
-    if (tptr >= buffsize)
-      tptr = 0; // tptr%=buffsize;
-  }
+dsp_t FIR::FIRUpdateAndProcess(dsp_t sig) {
+  FIRUpdate(sig);
+  outsum = FIRDot(points, buff + ptr, NumberOfPoints);
   return outsum;
 }
 
-void FIR::FIRUpdate(double sig) {
+void FIR::FIRUpdateAndProcessBlock(const dsp_t *in, dsp_t *out, int n) {
+  // the last NumberOfPoints samples followed by the block so every output
+  // window is contiguous
+  blockbuff.resize(NumberOfPoints + n);
+  dsp_t *x = blockbuff.data();
+  std::copy(buff + ptr + 1, buff + ptr + 1 + NumberOfPoints, x);
+  std::copy(in, in + n, x + NumberOfPoints);
+
+  // FIR_LANES outputs at a time kept in registers across all the taps
+  int q = 0;
+  for (; q + FIR_LANES <= n; q += FIR_LANES) {
+    dsp_t acc[FIR_LANES] = {0};
+    for (int i = 0; i < NumberOfPoints; i++) {
+      const dsp_t p = points[i];
+      for (int k = 0; k < FIR_LANES; k++)
+        acc[k] += p * x[q + i + k];
+    }
+    for (int k = 0; k < FIR_LANES; k++)
+      out[q + k] = acc[k];
+  }
+  for (; q < n; q++)
+    out[q] = FIRDot(points, x + q, NumberOfPoints);
+
+  for (int j = std::max(0, n - buffsize); j < n; j++)
+    FIRUpdate(x[NumberOfPoints + j]);
+  if (n)
+    outsum = out[n - 1];
+}
+
+void FIR::FIRUpdate(dsp_t sig) {
   buff[ptr] = sig;
+  buff[ptr + buffsize] = sig;
   ptr++;
-  ptr %= buffsize;
+  if (ptr >= buffsize)
+    ptr = 0;
 }
 
-double FIR::FIRProcess(double FractionOfSampleOffset) {
-  double nextp = FractionOfSampleOffset;
-  double thisp = 1 - nextp;
-  int tptr = ptr;
-  int nptr = ptr;
+dsp_t FIR::FIRProcess(double FractionOfSampleOffset) {
+  dsp_t nextp = FractionOfSampleOffset;
+  dsp_t thisp = 1 - nextp;
+  const dsp_t *window = buff + ptr;
   outsum = 0;
-  nptr++;
-  nptr %= buffsize;
-  for (int i = 0; i < NumberOfPoints; i++) {
-    outsum += points[i] * (buff[tptr] * thisp + buff[nptr] * nextp);
-    tptr = nptr;
-    nptr++;
-    nptr %= buffsize;
-  }
+  for (int i = 0; i < NumberOfPoints; i++)
+    outsum += points[i] * (window[i] * thisp + window[i + 1] * nextp);
   return outsum;
 }
 
-double FIR::FIRUpdateAndProcess(double sig, double FractionOfSampleOffset) {
-  buff[ptr] = sig;
-  ptr++;
-  ptr %= buffsize;
-  double nextp = FractionOfSampleOffset;
-  double thisp = 1 - nextp;
-  int tptr = ptr;
-  int nptr = ptr;
-  outsum = 0;
-  nptr++;
-  nptr %= buffsize;
-  for (int i = 0; i < NumberOfPoints; i++) {
-    outsum += points[i] * (buff[tptr] * thisp + buff[nptr] * nextp);
-    tptr = nptr;
-    nptr++;
-    nptr %= buffsize;
-  }
-  return outsum;
+dsp_t FIR::FIRUpdateAndProcess(dsp_t sig, double FractionOfSampleOffset) {
+  FIRUpdate(sig);
+  return FIRProcess(FractionOfSampleOffset);
 }
 
 void FIR::FIRSetPoint(int point, double value) {
@@ -361,17 +410,17 @@ AGC::AGC(double _SecondsToAveOver, double _Fs) {
   AGCMASz = round(_SecondsToAveOver * _Fs);
   JASSERT(AGCMASz > 0);
   AGCMASum = 0;
-  AGCMABuffer = new double[AGCMASz];
+  AGCMABuffer = new dsp_t[AGCMASz];
   for (int i = 0; i < AGCMASz; i++)
     AGCMABuffer[i] = 0;
   AGCMAPtr = 0;
   AGCVal = 0;
 }
 
-double AGC::Update(double sig) {
+dsp_t AGC::Update(dsp_t sig) {
   AGCMASum = AGCMASum - AGCMABuffer[AGCMAPtr];
-  AGCMASum = AGCMASum + fabs(sig);
-  AGCMABuffer[AGCMAPtr] = fabs(sig);
+  AGCMASum = AGCMASum + std::fabs(sig);
+  AGCMABuffer[AGCMAPtr] = std::fabs(sig);
   AGCMAPtr++;
   AGCMAPtr %= AGCMASz;
   AGCVal = 1.414213562 / fmax(AGCMASum / ((double)AGCMASz), 0.000001);
@@ -391,7 +440,7 @@ MovingAverage::MovingAverage(int number) {
   MASz = number;
   JASSERT(MASz > 0);
   MASum = 0;
-  MABuffer = new double[MASz];
+  MABuffer = new dsp_t[MASz];
   for (int i = 0; i < MASz; i++)
     MABuffer[i] = 0;
   MAPtr = 0;
@@ -407,9 +456,10 @@ void MovingAverage::Zero() {
 }
 
 double MovingAverage::Update(double sig) {
+  dsp_t val = fabs(sig);
   MASum = MASum - MABuffer[MAPtr];
-  MASum = MASum + fabs(sig);
-  MABuffer[MAPtr] = fabs(sig);
+  MASum = MASum + val;
+  MABuffer[MAPtr] = val;
   MAPtr++;
   MAPtr %= MASz;
   Val = MASum / ((double)MASz);
@@ -417,9 +467,10 @@ double MovingAverage::Update(double sig) {
 }
 
 double MovingAverage::UpdateSigned(double sig) {
+  dsp_t val = sig;
   MASum = MASum - MABuffer[MAPtr];
-  MASum = MASum + (sig);
-  MABuffer[MAPtr] = (sig);
+  MASum = MASum + val;
+  MABuffer[MAPtr] = val;
   MAPtr++;
   MAPtr %= MASz;
   Val = MASum / ((double)MASz);
@@ -453,7 +504,7 @@ double MSEcalc::Update(cpx_type pt_qpsk) {
   double mu = pointmean->Val;
   if (mu < 0.000001)
     mu = 0.000001;
-  tcpx = sqrt(2) * pt_qpsk / mu;
+  tcpx = (dsp_t)sqrt(2) * pt_qpsk / (dsp_t)mu;
   tda = (fabs(tcpx.real()) - 1.0);
   tdb = (fabs(tcpx.imag()) - 1.0);
   mse = msema->Update((tda * tda) + (tdb * tdb));
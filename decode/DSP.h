@@ -22,13 +22,26 @@
 #define WTSIZE_3_4 3.0 * WTSIZE / 4.0
 #define WTSIZE_1_4 1.0 * WTSIZE / 4.0
 
-typedef std::complex<double> cpx_type;
+// Sample type of the demodulation chain, single precision when built with
+// AERO_DSP_FLOAT. Oscillator phase, IIR loop filters and running sums stay in
+// double so tracking and averaging don't drift over long runs.
+#ifdef AERO_DSP_FLOAT
+typedef float dsp_t;
+#else
+typedef double dsp_t;
+#endif
+
+typedef std::complex<dsp_t> cpx_type;
+
+// Independent partial sums in the FIR dot product, wide enough to fill an
+// AVX register of floats
+#define FIR_LANES 8
 
 class TrigLookUp {
 public:
   TrigLookUp();
-  std::vector<double> SinWT;
-  std::vector<double> CosWT;
+  std::vector<dsp_t> SinWT;
+  std::vector<dsp_t> CosWT;
   std::vector<double> CosINV;
   std::vector<cpx_type> CISWT;
 };
@@ -42,10 +55,12 @@ public:
   void WTnextFrame();
   cpx_type WTCISValue();
   cpx_type WTCISValue_conj();
-  double WTSinValue();
-  double WTSinValue(double PlusFractOfSample);
-  double WTCosValue();
-  double WTCosValue(double PlusFractOfSample);
+  // the next n values of WTCISValue, advancing as n WTnextFrame calls would
+  void WTCISBlock(cpx_type *out, int n);
+  dsp_t WTSinValue();
+  dsp_t WTSinValue(double PlusFractOfSample);
+  dsp_t WTCosValue();
+  dsp_t WTCosValue(double PlusFractOfSample);
   void WTsetFreq(int freq, int samplerate);
   void SetFreq(double freq, int samplerate);
   double GetFreqTest();
@@ -95,21 +110,33 @@ private:
   double last_WTptr;
 };
 
+// out = in * phasor and out = in * conj(phasor) over a block, written out on
+// the real and imaginary parts so they vectorize. in may equal out
+void MixBlock(const dsp_t *in, const cpx_type *phasor, cpx_type *out, int n);
+void MixConjBlock(const cpx_type *in, const cpx_type *phasor, cpx_type *out,
+                  int n);
+
 class FIR {
 public:
   FIR(int _NumberOfPoints);
   ~FIR();
-  double FIRUpdateAndProcess(double sig);
-  void FIRUpdate(double sig);
-  double FIRProcess(double FractionOfSampleOffset);
-  double FIRUpdateAndProcess(double sig, double FractionOfSampleOffset);
+  dsp_t FIRUpdateAndProcess(dsp_t sig);
+  void FIRUpdate(dsp_t sig);
+  dsp_t FIRProcess(double FractionOfSampleOffset);
+  dsp_t FIRUpdateAndProcess(dsp_t sig, double FractionOfSampleOffset);
+  // same response as calling FIRUpdateAndProcess on each sample, in may
+  // equal out
+  void FIRUpdateAndProcessBlock(const dsp_t *in, dsp_t *out, int n);
   void FIRSetPoint(int point, double value);
-  double *points;
-  double *buff;
+  dsp_t *points;
+  dsp_t *buff;
   int NumberOfPoints;
   int buffsize;
   int ptr;
-  double outsum;
+  dsp_t outsum;
+
+private:
+  std::vector<dsp_t> blockbuff;
 };
 
 //--C-band
@@ -130,13 +157,13 @@ class AGC {
 public:
   AGC(double _SecondsToAveOver, double _Fs);
   ~AGC();
-  double Update(double sig);
+  dsp_t Update(dsp_t sig);
   double AGCVal;
 
 private:
   int AGCMASz;
   double AGCMASum;
-  double *AGCMABuffer;
+  dsp_t *AGCMABuffer;
   int AGCMAPtr;
 };
 
@@ -152,7 +179,7 @@ public:
 private:
   int MASz;
   double MASum;
-  double *MABuffer;
+  dsp_t *MABuffer;
   int MAPtr;
 };
 
@@ -380,7 +407,7 @@ public:
     iptr %= buff.size();
     T newer = buff.at(iptr);
 
-    return (weighting * newer + (1.0 - weighting) * older);
+    return ((dsp_t)weighting * newer + (dsp_t)(1.0 - weighting) * older);
   }
 
 private:
@@ -325,6 +325,8 @@ bool ACARSDefragmenter::defragment(ACARSItem &acarsitem) {
 
 ParserISU::ParserISU(QObject *parent) : QObject(parent) {
   downlink = false;
+  frameSink = nullptr;
+  frameSinkFragments = false;
   // dblookup
   dbtu = new DataBaseTextUser(this);
   connect(dbtu, SIGNAL(result(bool, int, QStringList)), this,
@@ -454,7 +456,8 @@ bool ParserISU::parse(ISUItem &isuitem) {
     // mark as valid
     anacarsitem.valid = true;
 
-    emit ACARSfragmentsignal(anacarsitem);
+    if (frameSink != nullptr && frameSinkFragments)
+      frameSink->processFrame(anacarsitem);
     
     // send acars message to lookup if fully defraged
     if (acarsdefragmenter.defragment(anacarsitem)) {
@@ -519,7 +522,7 @@ void ParserISU::acarslookupresult(bool ok, int ref, const QStringList &result) {
   }
   panacarsitem->dblookupresult = result;
 
-  emit ACARSsignal(*panacarsitem);
+  deliver(*panacarsitem);
   delete panacarsitem;
 }
 
@@ -546,6 +549,22 @@ void AeroLInterleaver::setSize(int _N) {
   for (int a = 0; a < matrix_ba.length(); a++) {
     matrix_ba[a] = 0;
   }
+
+  // built on first use as the number of cols can vary
+  deleavecols = 0;
+
+  // the first 5 cols deinterleave together then 3 cols at a time
+  mskdeleavetable.resize(M * N);
+  int k = 0;
+  for (int procblocks = 0, cols = 5; k < M * N; procblocks += cols, cols = 3) {
+    for (int j = 0; j < cols; j++) {
+      for (int i = 0; i < M && k < M * N; i++) {
+        mskdeleavetable[k] =
+            (M * procblocks) + (interleaverowdepermute[i] * cols + j);
+        k++;
+      }
+    }
+  }
 }
 QVector<int> &AeroLInterleaver::interleave(QVector<int> &block) {
   assert(block.size() == (M * N));
@@ -591,7 +610,8 @@ QVector<int> &AeroLInterleaver::deinterleave(QVector<int> &block, int cols) {
   return matrix;
 }
 
-QByteArray &AeroLInterleaver::deinterleave_ba(QVector<int> &block, int cols) {
+QByteArray &AeroLInterleaver::deinterleave_ba(const QVector<SoftBit> &block,
+                                              int cols) {
 
   // default to MSK settings if zero
   if (cols == 0) {
@@ -599,16 +619,23 @@ QByteArray &AeroLInterleaver::deinterleave_ba(QVector<int> &block, int cols) {
   }
   assert(cols <= N);
   assert(block.size() >= (M * cols));
-  int k = 0;
-  for (int j = 0; j < cols; j++) {
-    for (int i = 0; i < M; i++) {
-      int entry = interleaverowdepermute[i] * cols + j;
-      assert(entry < block.size());
-      assert(k < matrix_ba.size());
-      matrix_ba[k] = block[entry];
-      k++;
+  if (cols != deleavecols) {
+    deleavetable.resize(M * cols);
+    int k = 0;
+    for (int j = 0; j < cols; j++) {
+      for (int i = 0; i < M; i++) {
+        deleavetable[k] = interleaverowdepermute[i] * cols + j;
+        k++;
+      }
     }
+    deleavecols = cols;
   }
+
+  const SoftBit *in = block.constData();
+  const int *table = deleavetable.constData();
+  char *out = matrix_ba.data();
+  for (int k = 0; k < M * cols; k++)
+    out[k] = (char)in[table[k]];
   return matrix_ba;
 }
 
@@ -648,39 +675,22 @@ QVector<int> &AeroLInterleaver::deinterleaveMSK(QVector<int> &block,
   return matrix;
 }
 
-QByteArray &AeroLInterleaver::deinterleaveMSK_ba(QVector<int> &block,
+QByteArray &AeroLInterleaver::deinterleaveMSK_ba(const QVector<SoftBit> &block,
                                                  int blocks) {
   assert(block.size() >= (M * blocks));
 
   // we need to first deinterleave 5 cols for the first block then 3 cols for
   // the remaining blocks
-  int k = 0;
-
-  for (int j = 0; j < 5; j++) {
-    for (int i = 0; i < M; i++) {
-      int entry = interleaverowdepermute[i] * 5 + j;
-      assert(entry < 5 * M);
-      assert(k < matrix_ba.size());
-      matrix_ba[k] = (char)block[entry];
-      k++;
-    }
-  }
-
-  int procblocks = 5;
-
-  while (k < blocks * M) {
+  int size = 5 * M;
+  while (size < blocks * M)
+    size += 3 * M;
+  assert(size <= mskdeleavetable.size());
 
-    for (int j = 0; j < 3; j++) {
-      for (int i = 0; i < M; i++) {
-        int entry = (M * procblocks) + (interleaverowdepermute[i] * 3 + j);
-        assert(entry < block.size());
-        assert(k < matrix_ba.size());
-        matrix_ba[k] = (char)block[entry];
-        k++;
-      }
-    }
-    procblocks += 3;
-  }
+  const SoftBit *in = block.constData();
+  const int *table = mskdeleavetable.constData();
+  char *out = matrix_ba.data();
+  for (int k = 0; k < size; k++)
+    out[k] = (char)in[table[k]];
 
   return matrix_ba;
 }
@@ -724,154 +734,6 @@ bool PreambleDetector::Update(int val) {
   return false;
 }
 
-PreambleDetectorPhaseInvariant::PreambleDetectorPhaseInvariant() {
-  inverted = false;
-  preamble.resize(1);
-  buffer.resize(1);
-  buffer_ptr = 0;
-  tollerence = 0;
-}
-void PreambleDetectorPhaseInvariant::setPreamble(QVector<int> _preamble) {
-  preamble = _preamble;
-  if (preamble.size() < 1)
-    preamble.resize(1);
-  buffer.fill(0, preamble.size());
-  buffer_ptr = 0;
-}
-bool PreambleDetectorPhaseInvariant::setPreamble(quint64 bitpreamble, int len) {
-  if (len < 1 || len > 64)
-    return false;
-  preamble.clear();
-  for (int i = len - 1; i >= 0; i--) {
-    if ((bitpreamble >> i) & 1)
-      preamble.push_back(1);
-    else
-      preamble.push_back(0);
-  }
-  if (preamble.size() < 1)
-    preamble.resize(1);
-  buffer.fill(0, preamble.size());
-  buffer_ptr = 0;
-  return true;
-}
-int PreambleDetectorPhaseInvariant::Update(int val) {
-  assert(buffer.size() == preamble.size());
-  int xorsum = 0;
-  for (int i = 0; i < (buffer.size() - 1); i++) {
-    buffer[i] = buffer.at(i + 1);
-    xorsum += buffer.at(i) ^ preamble.at(i);
-  }
-  xorsum += val ^ preamble.at(buffer.size() - 1);
-  buffer[buffer.size() - 1] = val;
-  if (xorsum >= (buffer.size() - tollerence)) {
-
-    inverted = true;
-    return true;
-  }
-  if (xorsum <= tollerence) {
-    inverted = false;
-
-    return true;
-  }
-  return false;
-}
-void PreambleDetectorPhaseInvariant::setTollerence(int _tollerence) {
-  tollerence = _tollerence;
-}
-
-/* for C Channels*/
-OQPSKPreambleDetectorAndAmbiguityCorrection::
-    OQPSKPreambleDetectorAndAmbiguityCorrection() {
-  inverted = false;
-  preamble1.resize(1);
-  buffer1.resize(1);
-  preamble2.resize(1);
-  buffer2.resize(1);
-
-  buffer_ptr = 0;
-  tollerence = 0;
-}
-
-bool OQPSKPreambleDetectorAndAmbiguityCorrection::setPreamble(
-    quint64 bitpreamble1, quint64 bitpreamble2, int len) {
-  if (len < 1 || len > 64)
-    return false;
-  preamble1.clear();
-  preamble2.clear();
-
-  for (int i = len - 1; i >= 0; i--) {
-    if ((bitpreamble1 >> i) & 1)
-      preamble1.push_back(1);
-    else
-      preamble1.push_back(0);
-
-    if ((bitpreamble2 >> i) & 1)
-      preamble2.push_back(1);
-    else
-      preamble2.push_back(0);
-  }
-  if (preamble1.size() < 1)
-    preamble1.resize(1);
-  buffer1.fill(0, preamble1.size());
-
-  if (preamble2.size() < 1)
-    preamble2.resize(1);
-  buffer2.fill(0, preamble2.size());
-
-  buffer_ptr = 0;
-
-  return true;
-}
-int OQPSKPreambleDetectorAndAmbiguityCorrection::Update(int val) {
-  assert(buffer1.size() == preamble1.size());
-  assert(buffer2.size() == preamble2.size());
-
-  /* check the first buffer and preamble */
-  int xorsum = 0;
-  for (int i = 0; i < (buffer1.size() - 1); i++) {
-    buffer1[i] = buffer1[i + 1];
-    xorsum += buffer1[i] ^ preamble1[i];
-  }
-  xorsum += val ^ preamble1[buffer1.size() - 1];
-  buffer1[buffer1.size() - 1] = val;
-  if (xorsum >= (buffer1.size() - tollerence)) {
-
-    inverted = true;
-
-    return true;
-  }
-  if (xorsum <= tollerence) {
-
-    inverted = false;
-
-    return true;
-  }
-
-  xorsum = 0;
-  for (int i = 0; i < (buffer2.size() - 1); i++) {
-    buffer2[i] = buffer2[i + 1];
-    xorsum += buffer2[i] ^ preamble2[i];
-  }
-  xorsum += val ^ preamble2[buffer2.size() - 1];
-  buffer2[buffer2.size() - 1] = val;
-  if (xorsum >= (buffer2.size() - tollerence)) {
-
-    inverted = true;
-    return true;
-  }
-  if (xorsum <= tollerence) {
-
-    inverted = false;
-    return true;
-  }
-
-  return false;
-}
-void OQPSKPreambleDetectorAndAmbiguityCorrection::setTollerence(
-    int _tollerence) {
-  tollerence = _tollerence;
-}
-
 AeroL::AeroL(QObject *parent) : QObject(parent) {
 
   cntr = 1000000000;
@@ -884,9 +746,6 @@ AeroL::AeroL(QObject *parent) : QObject(parent) {
 
   // install parser
   parserisu = new ParserISU(this);
-  connect(parserisu, SIGNAL(ACARSsignal(ACARSItem &)), this,
-          SIGNAL(ACARSsignal(ACARSItem &)));
-  connect(parserisu, SIGNAL(ACARSfragmentsignal(ACARSItem &)), this, SIGNAL(ACARSfragmentsignal(ACARSItem &)));
   connect(parserisu, SIGNAL(Errorsignal(QString &)), this,
           SIGNAL(Errorsignal(QString &)));
 
@@ -897,11 +756,10 @@ AeroL::AeroL(QObject *parent) : QObject(parent) {
   datacd = false;
   emit DataCarrierDetect(datacd);
 
-  QTimer *dcdtimer = new QTimer(this);
+  dcdtimer = new QTimer(this);
   connect(dcdtimer, SIGNAL(timeout()), this, SLOT(updateDCD()));
   dcdtimer->start(1000);
 
-  sbits.reserve(1000);
   decodedbytes.reserve(1000);
 
   // new viterbi decoder (this is a qobject and has us as perent so is deleted
@@ -915,29 +773,9 @@ AeroL::AeroL(QObject *parent) : QObject(parent) {
   dl1.setLength(12);      // delay for decode encode BER check
   dl2.setLength(576 - 6); // delay's data to next frame
 
-  preambledetector.setPreamble(
-      3780831379LL, 32); // 0x3780831379,0b11100001010110101110100010010011
-
-  // I	1010 1011 0011 0111 0110 1001 0011 1000 1011 1100 1010 0011 0000 =
-  // 0xAB376938BCA30 hex = 3012071630031408 decimal Q	0000 1100 0101 0011 1101
-  // 0001 1100 1001 0110 1110 1100 1101 0101 = 0xC53D1C96ECD5 hex =
-  // 216866263330005 decimal
-
-  // doual preamble detectors for C Channel
-  preambledetectorreal.setPreamble(216866263330005LL, 3012071630031408LL, 52);
-  preambledetectorimag.setPreamble(216866263330005LL, 3012071630031408LL, 52);
-
   index = 0;
-
-  // Preamble detector for OQPSK
-  preambledetectorphaseinvariantimag.setPreamble(
-      3780831379LL, 32); // 0x3780831379,0b11100001010110101110100010010011
-  preambledetectorphaseinvariantreal.setPreamble(
-      3780831379LL, 32); // 0x3780831379,0b11100001010110101110100010010011
-
-  // MSK burst preamble detector
-  mskBurstDetector.setPreamble(
-      3780831379LL, 32); // 0x3780831379,0b11100001010110101110100010010011
+  realimag = 0;
+  uwinverted[0] = uwinverted[1] = false;
 
   // Preamble for start of burst
   QVector<int> pre;
@@ -962,19 +800,6 @@ void AeroL::setSettings(double fb, bool _burstmode) {
   risudata.reset();
   burstmode = _burstmode;
 
-  if (burstmode) {
-    preambledetectorphaseinvariantimag.setTollerence(4);
-    preambledetectorphaseinvariantreal.setTollerence(4);
-    preambledetectorimag.setTollerence(0);
-    preambledetectorreal.setTollerence(0);
-    mskBurstDetector.setTollerence(4);
-  } else {
-    preambledetectorphaseinvariantimag.setTollerence(0);
-    preambledetectorphaseinvariantreal.setTollerence(0);
-    preambledetectorimag.setTollerence(6);
-    preambledetectorreal.setTollerence(6);
-    mskBurstDetector.setTollerence(0);
-  }
   ifb = qRound(fb);
   switch (ifb) {
   case 600:
@@ -1036,10 +861,37 @@ void AeroL::setSettings(double fb, bool _burstmode) {
       AERO_SPEC_TotalNumberOfBits = ifb * 3; // 3 sec countdown for burst modes
     }
   }
+
+  // unique word search. OQPSK looks for it on the I and Q bits apart and all
+  // but continuous MSK resolve the phase ambiguity from its polarity
+  uwcorrelator.setArms(useingOQPSK ? 2 : 1);
+  if (ifb == 8400) {
+    // I	1010 1011 0011 0111 0110 1001 0011 1000 1011 1100 1010 0011 0000 =
+    // 0xAB376938BCA30 hex = 3012071630031408 decimal Q	0000 1100 0101 0011
+    // 1101 0001 1100 1001 0110 1110 1100 1101 0101 = 0xC53D1C96ECD5 hex =
+    // 216866263330005 decimal
+    uwcorrelator.setPatterns(216866263330005LL, 3012071630031408LL, 52);
+    uwcorrelator.setTollerence(burstmode ? 0 : 6);
+    uwcorrelator.setPhaseInvariant(true);
+    uwcorrelator.setClearOnHit(false);
+  } else {
+    uwcorrelator.setPattern(
+        3780831379LL, 32); // 0x3780831379,0b11100001010110101110100010010011
+    uwcorrelator.setTollerence(burstmode ? 4 : 0);
+    uwcorrelator.setPhaseInvariant(useingOQPSK || burstmode);
+    uwcorrelator.setClearOnHit(!useingOQPSK && !burstmode);
+  }
 }
 
 AeroL::~AeroL() {}
 
+void AeroL::setDCDTimerEnabled(bool enabled) {
+  if (enabled)
+    dcdtimer->start(1000);
+  else
+    dcdtimer->stop();
+}
+
 void AeroL::updateDCD() {
   // qDebug()<<datacdcountdown;
 
@@ -1057,28 +909,30 @@ void AeroL::updateDCD() {
   }
 }
 
-QByteArray &AeroL::Decode(QVector<short> &bits,
-                          bool soft) // 0 bit --> oldest bit
+QByteArray &AeroL::Decode(const SoftBit *bits,
+                          int count) // 0 bit --> oldest bit
 {
   decodedbytes.clear();
 
   quint16 bit = 0;
   quint16 soft_bit = 0;
 
-  for (int i = 0; i < bits.size(); i++) {
+  // every unique word in the buffer in one go, in bit order. For OQPSK the
+  // first bit goes to the arm after realimag's
+  const QVector<UWHit> &uwhits =
+      uwcorrelator.search(bits, count, (realimag + 1) % 2);
+  int nextuw = 0;
 
-    if (soft) {
-      if (((uchar)bits[i]) >= 128)
-        bit = 1;
-      else
-        bit = 0;
-    } else {
-      bit = bits[i];
-    }
+  for (int i = 0; i < count; i++) {
+
+    if (bits[i] >= 128)
+      bit = 1;
+    else
+      bit = 0;
     soft_bit = bits[i];
 
     // for burst mode to allow tolerance of UW
-    if (bits[i] < 0) {
+    if (bits[i] == SOFT_BIT_BURST_START) {
       // qDebug()<<"start of packet";
       muw = 0;
       continue;
@@ -1086,37 +940,29 @@ QByteArray &AeroL::Decode(QVector<short> &bits,
     if (muw < 100000)
       muw++;
 
+    // unique word ending at this bit, if the search found one
+    const UWHit *uw = 0;
+    if (nextuw < uwhits.size() && uwhits.at(nextuw).pos == i)
+      uw = &uwhits.at(nextuw++);
+
     // Preamble detector and ambiguity corrector for OQPSK
     int gotsync;
     if (useingOQPSK) {
       realimag++;
       realimag %= 2;
-      if (realimag) {
 
-        if (cntr > AERO_SPEC_NumberOfBits - 68 || cntr <= 0 || !datacd) {
-          gotsync = preambledetectorphaseinvariantimag.Update(bit);
-          if (!gotsync_last) {
-            gotsync_last = gotsync;
-            gotsync = 0;
-          } else
-            gotsync_last = 0;
-        } else {
-          gotsync = false;
-          gotsync_last = false;
-        }
+      if (cntr > AERO_SPEC_NumberOfBits - 68 || cntr <= 0 || !datacd) {
+        gotsync = (uw != 0);
+        if (uw)
+          uwinverted[realimag] = uw->inverted;
+        if (!gotsync_last) {
+          gotsync_last = gotsync;
+          gotsync = 0;
+        } else
+          gotsync_last = 0;
       } else {
-        if (cntr > AERO_SPEC_NumberOfBits - 68 || cntr <= 0 || !datacd) {
-          gotsync = preambledetectorphaseinvariantreal.Update(bit);
-          if (!gotsync_last) {
-            gotsync_last = gotsync;
-            gotsync = 0;
-          } else
-            gotsync_last = 0;
-
-        } else {
-          gotsync = false;
-          gotsync_last = false;
-        }
+        gotsync = false;
+        gotsync_last = false;
       }
 
       // for 10500 UW should be about 80 samples after start of packet signal
@@ -1128,45 +974,34 @@ QByteArray &AeroL::Decode(QVector<short> &bits,
         }
       }
 
-      if (realimag) {
-        if (preambledetectorphaseinvariantimag.inverted) {
-          bit = 1 - bit;
-
-          if (soft_bit > 128) {
-            soft_bit = 255 - soft_bit;
-          } else if (soft_bit < 128) {
-            soft_bit = 255 - soft_bit;
-          }
-        }
-
-      } else {
-        if (preambledetectorphaseinvariantreal.inverted) {
-          bit = 1 - bit;
+      if (uwinverted[realimag]) {
+        bit = 1 - bit;
 
-          if (soft_bit > 128) {
-            soft_bit = 255 - soft_bit;
-          } else if (soft_bit < 128) {
-            soft_bit = 255 - soft_bit;
-          }
+        if (soft_bit > 128) {
+          soft_bit = 255 - soft_bit;
+        } else if (soft_bit < 128) {
+          soft_bit = 255 - soft_bit;
         }
       }
 
     } // non 10500 burst mode use a phase invariant preamble detector
     else if (burstmode) {
 
-      bool inverted = mskBurstDetector.inverted;
+      bool inverted = uwinverted[0];
 
-      gotsync = mskBurstDetector.Update(bit);
+      gotsync = (uw != 0);
+      if (uw)
+        uwinverted[0] = uw->inverted;
 
       if (muw > 250 && gotsync) {
 
-        if (inverted != mskBurstDetector.inverted) {
-          mskBurstDetector.inverted = inverted;
+        if (inverted != uwinverted[0]) {
+          uwinverted[0] = inverted;
         }
         gotsync = false;
       }
 
-      if (mskBurstDetector.inverted) {
+      if (uwinverted[0]) {
 
         bit = 1 - bit;
 
@@ -1177,7 +1012,7 @@ QByteArray &AeroL::Decode(QVector<short> &bits,
         }
       }
     } else {
-      gotsync = preambledetector.Update(bit);
+      gotsync = (uw != 0);
     }
 
     if (cntr < 1000000000)
@@ -1238,17 +1073,10 @@ QByteArray &AeroL::Decode(QVector<short> &bits,
 
         RTChannelDeleaveFECScram::ReturnResult result;
 
-        if (useingOQPSK) {
-          if (soft)
-            result = rtchanneldeleavefecscram.update(soft_bit);
-          else
-            result = rtchanneldeleavefecscram.update(bit);
-        } else {
-          if (soft)
-            result = rtchanneldeleavefecscram.updateMSK(soft_bit);
-          else
-            result = rtchanneldeleavefecscram.updateMSK(bit);
-        }
+        if (useingOQPSK)
+          result = rtchanneldeleavefecscram.update(soft_bit);
+        else
+          result = rtchanneldeleavefecscram.updateMSK(soft_bit);
 
         switch (result) {
         case RTChannelDeleaveFECScram::OK_R_Packet: {
@@ -1495,29 +1323,20 @@ QByteArray &AeroL::Decode(QVector<short> &bits,
           // deinterleaver
           QByteArray deleaveredblockBA = leaver.deinterleave_ba(block, 0);
 
-          QVector<int> deconvol =
+          PackedBits &deconvol =
               jconvolcodec->Decode_Continuous(deleaveredblockBA);
 
           // delay line for frame alignment for non burst modes. This is needed
           // for the scrambler
           dl2.update(deconvol);
 
-          // scrambler
-          scrambler.update(deconvol);
+          // actual data of information field in bytearray
+          int infofieldstart = infofield.size();
+          infofield.append((const char *)deconvol.constData(),
+                           deconvol.size() / 8);
 
-          // pack the bits into bytes
-          int charptr = 0;
-          uchar ch = 0;
-          for (int h = 0; h < deconvol.size(); h++) {
-            ch |= deconvol[h] * 128;
-            charptr++;
-            charptr %= 8;
-            if (charptr == 0) {
-              infofield += ch; // actual data of information field in bytearray
-              ch = 0;
-            } else
-              ch >>= 1;
-          }
+          // scrambler
+          scrambler.update(infofield, infofieldstart, deconvol.size());
 
           if ((cntr - AERO_SPEC_BitsInHeader) ==
               (AERO_SPEC_NumberOfBits - 1)) // frame is done when this is true
@@ -2037,16 +1856,11 @@ QByteArray &AeroL::Decode(QVector<short> &bits,
   return decodedbytes;
 }
 
-void AeroL::processDemodulatedSoftBits(const QVector<short> &soft_bits) {
-
-  sbits.clear();
-
-  sbits.append(soft_bits);
-
+void AeroL::processSoftBits(const SoftBit *bits, int count) {
   if (this->ifb == 8400) {
-    DecodeC(sbits);
+    DecodeC(bits, count);
   } else {
-    Decode(sbits, true);
+    Decode(bits, count);
   }
 }
 
@@ -2124,7 +1938,7 @@ void AeroL::SendCAssignment(int k, QString decline) {
 
   item.message = "Receive Freq: " + receive + beam + "Transmit " + transmit +
                  "\r\n" + decline;
-  emit ACARSsignal(item);
+  parserisu->deliver(item);
 }
 void AeroL::SendLogOnOff(int k, QString text) {
   ACARSItem item;
@@ -2139,10 +1953,10 @@ void AeroL::SendLogOnOff(int k, QString text) {
   item.valid = true;
 
   item.message = text;
-  emit ACARSsignal(item);
+  parserisu->deliver(item);
 }
 
-QByteArray &AeroL::DecodeC(QVector<short> &bits) {
+QByteArray &AeroL::DecodeC(const SoftBit *bits, int count) {
 
   decodedbytes.clear();
 
@@ -2151,70 +1965,56 @@ QByteArray &AeroL::DecodeC(QVector<short> &bits) {
 
   QString hex = "000000";
 
-  for (int i = 0; i < bits.size(); i++) {
+  // every unique word in the buffer in one go, in bit order, the first bit
+  // going to the arm after realimag's
+  const QVector<UWHit> &uwhits =
+      uwcorrelator.search(bits, count, (realimag + 1) % 2);
+  int nextuw = 0;
+
+  for (int i = 0; i < count; i++) {
+
+    // not a bit, and the search skipped it too
+    if (bits[i] == SOFT_BIT_BURST_START)
+      continue;
 
     // hard bits for preamble
-    if (((uchar)bits[i]) >= 128)
+    if (bits[i] >= 128)
       bit = 1;
     else
       bit = 0;
     soft_bit = bits[i];
     int gotsync = 0;
 
+    const UWHit *uw = 0;
+    if (nextuw < uwhits.size() && uwhits.at(nextuw).pos == i)
+      uw = &uwhits.at(nextuw++);
+
     realimag++;
     realimag %= 2;
-    if (realimag) {
 
-      if (cntr > AERO_SPEC_NumberOfBits - 112 || cntr <= 0) {
+    if (cntr > AERO_SPEC_NumberOfBits - 112 || cntr <= 0) {
 
-        gotsync = preambledetectorreal.Update(bit);
-        if (!gotsync_last) {
-          gotsync_last = gotsync;
-          gotsync = 0;
-        } else
-          gotsync_last = 0;
-
-      } else {
+      gotsync = (uw != 0);
+      if (uw)
+        uwinverted[realimag] = uw->inverted;
+      if (!gotsync_last) {
+        gotsync_last = gotsync;
         gotsync = 0;
+      } else
         gotsync_last = 0;
-      }
 
     } else {
-
-      if (cntr > AERO_SPEC_NumberOfBits - 112 || cntr <= 0) {
-
-        gotsync = preambledetectorimag.Update(bit);
-        if (!gotsync_last) {
-          gotsync_last = gotsync;
-          gotsync = 0;
-        } else
-          gotsync_last = 0;
-      } else {
-        gotsync = 0;
-        gotsync_last = 0;
-      }
+      gotsync = 0;
+      gotsync_last = 0;
     }
 
-    if (realimag) {
-      if (preambledetectorreal.inverted) {
-        bit = 1 - bit;
-
-        if (soft_bit > 128) {
-          soft_bit = 255 - soft_bit;
-        } else if (soft_bit < 128) {
-          soft_bit = 255 - soft_bit;
-        }
-      }
-
-    } else {
-      if (preambledetectorimag.inverted) {
-        bit = 1 - bit;
+    if (uwinverted[realimag]) {
+      bit = 1 - bit;
 
-        if (soft_bit > 128) {
-          soft_bit = 255 - soft_bit;
-        } else if (soft_bit < 128) {
-          soft_bit = 255 - soft_bit;
-        }
+      if (soft_bit > 128) {
+        soft_bit = 255 - soft_bit;
+      } else if (soft_bit < 128) {
+        soft_bit = 255 - soft_bit;
       }
     }
     if (gotsync) {
@@ -2252,7 +2052,7 @@ QByteArray &AeroL::DecodeC(QVector<short> &bits) {
         puncturedCode.depunture_soft_block(deleaveredBlock, depuncturedBlock, 4,
                                            true);
 
-        QVector<int> deconvol =
+        PackedBits &deconvol =
             jconvolcodec->Decode_Continuous(depuncturedBlock);
 
         // resize to drop trailing dummy bits
@@ -2277,7 +2077,7 @@ QByteArray &AeroL::DecodeC(QVector<short> &bits) {
           int offset = y * (1 + 96 + 12);
 
           for (int h = offset + 97; h < offset + 109; h++) {
-            ch |= deconvol[h] * 128;
+            ch |= deconvol.at(h) * 128;
             charptr++;
             charptr %= 8;
             if (charptr == 0) {
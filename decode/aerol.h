@@ -2,9 +2,11 @@
 #define AEROL_H
 
 #include "jconvolutionalcodec.h"
+#include "packedbits.h"
+#include "uwcorrelator.h"
+#include "pipeline.h"
 #include <QDateTime>
 #include <QDebug>
-#include <QJsonObject>
 #include <QList>
 #include <QObject>
 #include <QPointer>
@@ -177,7 +179,8 @@ public:
   bool hastext;
   bool moretocome;
   QString message;
-  QJsonObject parsed;
+  // libacars' decode of the message as a serialized JSON object
+  QByteArray parsedJson;
   
   void clear() {
     isuitem.clear();
@@ -191,6 +194,7 @@ public:
     PLANEREG.clear();
     LABEL.clear();
     message.clear();
+    parsedJson.clear();
     downlink = false;
   }
   explicit ACARSItem() { clear(); }
@@ -249,9 +253,19 @@ public:
   explicit ParserISU(QObject *parent = 0);
   bool parse(ISUItem &isuitem);
   bool downlink;
+
+  // Complete messages, or every fragment if fragments is true, are handed to
+  // the sink once parsed
+  void setFrameSink(FrameSink *sink, bool fragments) {
+    frameSink = sink;
+    frameSinkFragments = fragments;
+  }
+  // a complete message, dropped if the sink only wants fragments
+  void deliver(ACARSItem &item) {
+    if (frameSink != nullptr && !frameSinkFragments)
+      frameSink->processFrame(item);
+  }
 signals:
-  void ACARSsignal(ACARSItem &acarsitem);
-  void ACARSfragmentsignal(ACARSItem &acarsitem);
   void Errorsignal(QString &error);
 public slots:
   void setDataBaseDir(const QString &dir);
@@ -262,6 +276,8 @@ private:
   QString anerror;
   QString databasedir;
   DataBaseTextUser *dbtu;
+  FrameSink *frameSink;
+  bool frameSinkFragments;
 private slots:
   void acarslookupresult(bool ok, int ref, const QStringList &result);
 };
@@ -279,92 +295,48 @@ public:
     }
     numberofbits -= 16;
 
-    quint16 crc = 0xFFFF;
-    int crc_bit;
-    for (int i = 0; i < numberofbits;
-         i++) // we are finished when all bits of the message are looked at
-    {
-      // crc_bit = (crc >> 15) & 1;//bit of crc we are working on. 15=poly
-      // order-1 crc <<= 1;//shift to next crc bit (have to do this here before
-      // Gate A does its thing) if(crc_bit ^ bits[i])crc = crc ^ 0x1021;//add to
-      // the crc the poly mod2 if crc_bit + block_bit = 1 mod2 (0x1021 is the
-      // ploy with the first bit missing so this means x^16+x^12+x^5+1)
-
-      // differnt endiness
-      crc_bit = crc & 1; // bit of crc we are working on. 15=poly order-1
-      crc >>= 1; // shift to next crc bit (have to do this here before Gate A
-                 // does its thing)
-      if (crc_bit ^ bits[i])
-        crc = crc ^
-              0x8408; //(0x8408 is reversed 0x1021)add to the crc the poly mod2
-                      //if crc_bit + block_bit = 1 mod2 (0x1021 is the ploy with
-                      //the first bit missing so this means x^16+x^12+x^5+1)
-    }
-    crc = ~crc;
+    quint16 crc = calcusingbits(bits, numberofbits);
     if (crc_rec == crc)
       return true;
     return false;
   }
   quint16 calcusingbits(int *bits, int numberofbits) {
+    // whole bytes go through the tables packed LSB first, the same order the
+    // bits enter the crc in
     quint16 crc = 0xFFFF;
-    int crc_bit;
-    for (int i = 0; i < numberofbits;
-         i++) // we are finished when all bits of the message are looked at
-    {
-      // crc_bit = (crc >> 15) & 1;//bit of crc we are working on. 15=poly
-      // order-1 crc <<= 1;//shift to next crc bit (have to do this here before
-      // Gate A does its thing) if(crc_bit ^ bits[i])crc = crc ^ 0x1021;//add to
-      // the crc the poly mod2 if crc_bit + block_bit = 1 mod2 (0x1021 is the
-      // ploy with the first bit missing so this means x^16+x^12+x^5+1)
-
-      // differnt endiness
-      crc_bit = crc & 1; // bit of crc we are working on. 15=poly order-1
-      crc >>= 1; // shift to next crc bit (have to do this here before Gate A
-                 // does its thing)
-      if (crc_bit ^ bits[i])
-        crc = crc ^
-              0x8408; //(0x8408 is reversed 0x1021)add to the crc the poly mod2
-                      //if crc_bit + block_bit = 1 mod2 (0x1021 is the ploy with
-                      //the first bit missing so this means x^16+x^12+x^5+1)
+    uchar bytes[64];
+    while (numberofbits >= 8) {
+      int nbytes = qMin(numberofbits / 8, (int)sizeof(bytes));
+      for (int i = 0; i < nbytes; i++, bits += 8) {
+        uchar byte = 0;
+        for (int k = 0; k < 8; k++)
+          byte |= bits[k] << k;
+        bytes[i] = byte;
+      }
+      crc = updatebytes(crc, bytes, nbytes);
+      numberofbits -= 8 * nbytes;
     }
-    return ~crc;
-  }
-  quint16 calcusingbytes(char *bytes, int numberofbytes) {
-    quint16 crc = 0xFFFF;
-    int crc_bit;
-    int message_bit;
-    int message_byte;
-    for (int i = 0; i < numberofbytes;
-         i++) // we are finished when all bits of the message are looked at
-    {
-      message_byte = bytes[i];
-      for (int k = 0; k < 8; k++) {
-
-        // message_bit=(message_byte>>7)&1;
-        // message_byte<<=1;
-        // crc_bit = (crc >> 15) & 1;//bit of crc we are working on. 15=poly
-        // order-1 crc <<= 1;//shift to next crc bit (have to do this here
-        // before Gate A does its thing) if(crc_bit ^ message_bit)crc = crc ^
-        // 0x1021;//add to the crc the poly mod2 if crc_bit + block_bit = 1 mod2
-        // (0x1021 is the ploy with the first bit missing so this means
-        // x^16+x^12+x^5+1)
 
-        // differnt endiness
-        message_bit = message_byte & 1;
-        message_byte >>= 1;
-        crc_bit = crc & 1; // bit of crc we are working on. 15=poly order-1
-        crc >>= 1; // shift to next crc bit (have to do this here before Gate A
-                   // does its thing)
-        if (crc_bit ^ message_bit)
-          crc =
-              crc ^
-              0x8408; //(0x8408 is reversed 0x1021)add to the crc the poly mod2
-                      //if crc_bit + block_bit = 1 mod2 (0x1021 is the ploy with
-                      //the first bit missing so this means x^16+x^12+x^5+1)
-      }
+    // differnt endiness, 0x8408 is reversed 0x1021 which is the poly with the
+    // first bit missing so this means x^16+x^12+x^5+1
+    for (int i = 0; i < numberofbits; i++) {
+      int crc_bit = crc & 1;
+      crc >>= 1;
+      if (crc_bit ^ bits[i])
+        crc = crc ^ 0x8408;
     }
     return ~crc;
   }
+  quint16 calcusingbytes(const char *bytes, int numberofbytes) {
+    return ~updatebytes(0xFFFF, (const uchar *)bytes, numberofbytes);
+  }
+  // true when the last two bytes, low byte first, are the crc of the rest
+  bool calcusingbytesandcheck(const char *bytes, int numberofbytes) {
+    numberofbytes -= 2;
+    quint16 crc_rec = (((uchar)bytes[numberofbytes + 1]) << 8) |
+                      ((uchar)bytes[numberofbytes]);
+    return calcusingbytes(bytes, numberofbytes) == crc_rec;
+  }
   quint16 calcusingbytesotherendines(char *bytes, int numberofbytes) {
     quint16 crc = 0xFFFF;
     int crc_bit;
@@ -401,6 +373,37 @@ public:
     }
     return ~crc;
   }
+
+private:
+  // slice by 4 tables of the reflected crc, t[0] being the usual byte table
+  // and t[k] the byte followed by k zero bytes
+  static const quint16 (*tables())[256] {
+    static const struct Tables {
+      quint16 t[4][256];
+      Tables() {
+        for (int b = 0; b < 256; b++) {
+          quint16 crc = b;
+          for (int k = 0; k < 8; k++)
+            crc = (crc & 1) ? ((crc >> 1) ^ 0x8408) : (crc >> 1);
+          t[0][b] = crc;
+        }
+        for (int k = 1; k < 4; k++)
+          for (int b = 0; b < 256; b++)
+            t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFF];
+      }
+    } tables;
+    return tables.t;
+  }
+  static quint16 updatebytes(quint16 crc, const uchar *bytes, int n) {
+    const quint16(*t)[256] = tables();
+    for (; n >= 4; n -= 4, bytes += 4) {
+      quint16 x = crc ^ (bytes[0] | (bytes[1] << 8));
+      crc = t[3][x & 0xFF] ^ t[2][x >> 8] ^ t[1][bytes[2]] ^ t[0][bytes[3]];
+    }
+    for (; n > 0; n--, bytes++)
+      crc = (crc >> 8) ^ t[0][(crc ^ *bytes) & 0xFF];
+    return crc;
+  }
 };
 
 class AeroLScrambler {
@@ -424,18 +427,41 @@ public:
       }
       state[0] = val0;
     }
+
+    // and packed LSB first like the information field bytes, with a spare
+    // byte so unaligned positions can always read two
+    pre_state_packed.fill(0, 5000 / 8 + 2);
+    for (int a = 0; a < 5000; a++)
+      if (pre_state[a])
+        pre_state_packed[a >> 3] = pre_state_packed[a >> 3] | (1 << (a & 7));
   }
 
-  void update(QVector<int> &data) {
-    for (int j = 0; j < data.size(); j++) {
-      data[j] = data.at(j) ^ pre_state.at(position);
-      position++;
-    }
+  void update(PackedBits &data) {
+    update(data.data(), (data.size() + 7) / 8, data.size());
+    data.resize(data.size()); // clear the scrambled bits past the end
+  }
+  // scrambles the bytes of data from index from on, packed LSB first. nbits
+  // is how many bits they were packed from when that left a partial byte off
+  // the end
+  void update(QByteArray &data, int from = 0, int nbits = -1) {
+    if (nbits < 0)
+      nbits = 8 * (data.size() - from);
+    update((uchar *)data.data() + from, data.size() - from, nbits);
   }
   void reset() { position = 0; }
 
 private:
+  void update(uchar *d, int nbytes, int nbits) {
+    assert(position + nbits <= pre_state.size());
+    const uchar *s = (const uchar *)pre_state_packed.constData();
+    const int shift = position & 7;
+    for (int j = 0, i = position >> 3; j < nbytes; j++, i++)
+      d[j] ^= (uchar)((s[i] | (s[i + 1] << 8)) >> shift);
+    position += nbits;
+  }
+
   QVector<int> pre_state;
+  QByteArray pre_state_packed;
   int position;
 };
 
@@ -455,24 +481,22 @@ class DelayLine {
 public:
   DelayLine() { setLength(12); }
   void setLength(int length) {
-    length++;
-    assert(length > 0);
+    assert(length >= 0);
+    buffer.resize(0);
     buffer.resize(length);
-    buffer_ptr = 0;
-    buffer_sz = buffer.size();
+    buffer_sz = length;
   }
-  void update(QVector<int> &data) {
-    for (int i = 0; i < data.size(); i++) {
-      buffer[buffer_ptr] = data[i];
-      buffer_ptr++;
-      buffer_ptr %= buffer_sz;
-      data[i] = buffer[buffer_ptr];
-    }
+  void update(PackedBits &data) {
+    // the held bits go out first and the last buffer_sz bits are held back
+    buffer.append(data);
+    buffer.mid(0, data.size(), data);
+    buffer.mid(data.size(), buffer_sz, held);
+    buffer = held;
   }
 
 private:
-  QVector<int> buffer;
-  int buffer_ptr;
+  PackedBits buffer;
+  PackedBits held;
   int buffer_sz;
 };
 
@@ -483,8 +507,8 @@ public:
   QVector<int> &interleave(QVector<int> &block);
   QVector<int> &deinterleave(QVector<int> &block);
   QVector<int> &deinterleaveMSK(QVector<int> &block, int blocks);
-  QByteArray &deinterleaveMSK_ba(QVector<int> &block, int blocks);
-  QByteArray &deinterleave_ba(QVector<int> &block, int blocks);
+  QByteArray &deinterleaveMSK_ba(const QVector<SoftBit> &block, int blocks);
+  QByteArray &deinterleave_ba(const QVector<SoftBit> &block, int blocks);
 
   QVector<int> &deinterleave(
       QVector<int> &block,
@@ -496,6 +520,12 @@ private:
   int N;
   QVector<int> interleaverowpermute;
   QVector<int> interleaverowdepermute;
+
+  // block indices in deinterleaved order, for deleavecols cols and for the 5
+  // then 3 cols at a time MSK bursts
+  QVector<int> deleavetable;
+  int deleavecols;
+  QVector<int> mskdeleavetable;
 };
 
 class PreambleDetector {
@@ -511,40 +541,6 @@ private:
   int buffer_ptr;
 };
 
-class PreambleDetectorPhaseInvariant {
-public:
-  PreambleDetectorPhaseInvariant();
-  void setPreamble(QVector<int> _preamble);
-  bool setPreamble(quint64 bitpreamble, int len);
-  void setTollerence(int tollerence);
-  int Update(int val);
-  bool inverted;
-
-private:
-  QVector<int> preamble;
-  QVector<int> buffer;
-  int buffer_ptr;
-  int tollerence;
-};
-
-class OQPSKPreambleDetectorAndAmbiguityCorrection {
-public:
-  OQPSKPreambleDetectorAndAmbiguityCorrection();
-  bool setPreamble(quint64 bitpreamble1, quint64 bitpreamble2, int len);
-  void setTollerence(int tollerence);
-  int Update(int val);
-  bool inverted;
-
-private:
-  QVector<int> preamble1;
-  QVector<int> buffer1;
-  QVector<int> preamble2;
-  QVector<int> buffer2;
-
-  int buffer_ptr;
-  int tollerence;
-};
-
 class RTChannelDeleaveFECScram {
 public:
   int targetSUSize = 0;
@@ -585,33 +581,7 @@ public:
     lastpacketstate = Nothing;
     return Nothing;
   }
-  void packintobytes() {
-    infofield.clear();
-    int charptr = 0;
-    uchar ch = 0;
-    // int ctt=0;
-    // QString str2;
-    for (int h = 0; h < deconvol.size(); h++) // take one for flushing
-    {
-      ch |= deconvol[h] * 128;
-      charptr++;
-      charptr %= 8;
-      if (charptr == 0) {
-        infofield += ch;
-
-        // ctt++;
-        // str2+=((QString)"0x%1 ").arg(((QString)"").sprintf("%02X", ch));
-        // if((ctt-6)%12==0)str2+="\n";
-
-        ch = 0;
-      } else
-        ch >>= 1;
-    }
-
-    // qDebug()<<str2.toLatin1().data();
-  }
-
-  ReturnResult updateMSK(int bit) {
+  ReturnResult updateMSK(SoftBit bit) {
     if (blockptr >= block.size()) {
       return FULL;
     }
@@ -647,7 +617,8 @@ public:
       deconvol = jconvolcodec->Decode_soft(delBlock, blockptr);
 
       // scrambler
-      scrambler.update(deconvol);
+      infofield = deconvol.wholeBytes();
+      scrambler.update(infofield);
 
       // test for R or packet
       if (blockptr == (64 * 5)) {
@@ -655,12 +626,9 @@ public:
         targetBlocks = 0;
 
         // test crc
-        bool crcok = crc16.calcusingbitsandcheck(deconvol.data(), 8 * 19);
+        bool crcok = crc16.calcusingbytesandcheck(infofield.constData(), 19);
         if (crcok) {
 
-          // pack into bytes
-          packintobytes();
-
           blockptr = block.size(); // stop further testing
           lastpacketstate = OK_R_Packet;
 
@@ -673,7 +641,7 @@ public:
 
       // Test for T packet
       // test header crc
-      bool crcok = crc16.calcusingbitsandcheck(deconvol.data(), 8 * 6);
+      bool crcok = crc16.calcusingbytesandcheck(infofield.constData(), 6);
       if (!crcok) {
 
         lastpacketstate = Bad_Packet;
@@ -688,11 +656,8 @@ public:
           // we should be able to peek at the SU after the initial SU and figure
           // out the number of SU's in this burst
 
-          QVector<int> isu = deconvol.mid((8 * 6) + (8 * 12) * 1, 8 * 12);
-
           int bin = 2;
-          bin += ((isu[0] * 1) + (isu[1] * 2) + (isu[2] * 4) + (isu[3] * 8) +
-                  (isu[4] * 16) + (isu[5] * 32));
+          bin += ((uchar)infofield[6 + 12 * 1]) & 0x3F;
 
           targetSUSize = bin;
 
@@ -708,8 +673,8 @@ public:
         // this should be the target blocks for this T packet
         if (blockptr / 64 == targetBlocks) {
           for (int i = 0; i < targetSUSize - 3; i++) {
-            crcok = crc16.calcusingbitsandcheck(
-                deconvol.data() + (8 * 6) + (8 * 12) * i, 8 * 12);
+            crcok = crc16.calcusingbytesandcheck(
+                infofield.constData() + 6 + 12 * i, 12);
 
             if (crcok) {
               ok++;
@@ -726,8 +691,6 @@ public:
 
           if (ok <= targetSUSize) {
 
-            // pack into bytes
-            packintobytes();
             infofield.chop(1);
             numberofsus = targetSUSize;
             blockptr = block.size(); // stop further testing
@@ -741,8 +704,6 @@ public:
         return Nothing;
       }
 
-      // pack into bytes
-      packintobytes();
       infofield.chop(1);
 
       blockptr = block.size(); // stop further testing
@@ -752,7 +713,7 @@ public:
     return Nothing;
   }
 
-  ReturnResult update(int bit) {
+  ReturnResult update(SoftBit bit) {
     if (blockptr >= block.size())
       return FULL;
     block[blockptr] = bit;
@@ -774,19 +735,18 @@ public:
       deconvol = jconvolcodec->Decode_soft(delBlock, blockptr);
 
       // scrambler
-      scrambler.update(deconvol);
+      infofield = deconvol.wholeBytes();
+      scrambler.update(infofield);
 
       // test for R packet
       if (blockptr == (64 * 5)) {
         // test crc
-        bool crcok = crc16.calcusingbitsandcheck(deconvol.data(), 8 * 19);
+        bool crcok = crc16.calcusingbytesandcheck(infofield.constData(), 19);
         if (!crcok) {
           lastpacketstate = Test_Failed;
           return Test_Failed;
         }
 
-        // pack into bytes
-        packintobytes();
 
         // qDebug()<<"CRC OK R packet";
 
@@ -797,7 +757,7 @@ public:
 
       // Test for T packet
       // test header crc
-      bool crcok = crc16.calcusingbitsandcheck(deconvol.data(), 8 * 6);
+      bool crcok = crc16.calcusingbytesandcheck(infofield.constData(), 6);
       if (!crcok) {
         if (blockptr >= block.size()) {
           lastpacketstate = Bad_Packet;
@@ -810,8 +770,8 @@ public:
       // test all the SU crcs
       numberofsus = 1 + (blockptr - (64 * 5)) / (64 * 3);
       for (int i = 0; i < numberofsus; i++) {
-        crcok = crc16.calcusingbitsandcheck(
-            deconvol.data() + (8 * 6) + (8 * 12) * i, 8 * 12);
+        crcok = crc16.calcusingbytesandcheck(
+            infofield.constData() + 6 + 12 * i, 12);
         if (!crcok) {
           if (blockptr >= block.size()) {
             lastpacketstate = Bad_Packet;
@@ -822,8 +782,6 @@ public:
         }
       }
 
-      // pack into bytes
-      packintobytes();
       infofield.chop(1);
 
       // qDebug()<<"CRC OK T packet with"<<numberofsus<<"SUs\n";
@@ -835,10 +793,9 @@ public:
     return Nothing;
   }
 
-  QVector<int> deleaveredblock;
   QByteArray delBlock;
-  QVector<int> deconvol;
-  QVector<int> block;
+  PackedBits deconvol;
+  QVector<SoftBit> block;
   int blockptr;
   AeroLInterleaver leaver;
   AeroLScrambler scrambler;
@@ -849,17 +806,29 @@ public:
   int numberofsus;
 };
 
-class AeroL : public QObject {
+class AeroL : public QObject, public SoftBitSink {
   Q_OBJECT
 public:
   enum ChannelType { PChannel, RChannel, TChannel };
 
   explicit AeroL(QObject *parent = 0);
   ~AeroL();
+
+  void processSoftBits(const SoftBit *bits, int count);
+
+  // Where decoded messages go, every fragment rather than reassembled
+  // messages if fragments is true
+  void setFrameSink(FrameSink *sink, bool fragments) {
+    parserisu->setFrameSink(sink, fragments);
+  }
+
+  // DCD times out off a 1 s wall clock timer; offline replay runs faster
+  // than real time so it disables the timer and calls tickDCD once per
+  // second of samples instead
+  void setDCDTimerEnabled(bool enabled);
+  void tickDCD() { updateDCD(); }
 signals:
   void DataCarrierDetect(bool status);
-  void ACARSfragmentsignal(ACARSItem &acarsitem);
-  void ACARSsignal(ACARSItem &acarsitem);
   void Errorsignal(QString &error);
   void Voicesignal(QByteArray &data, QString &hex);
   void Voicesignal(const QByteArray &data);
@@ -881,25 +850,25 @@ public slots:
   }
   void setDoNotDisplaySUs(QVector<int> &list) { donotdisplaysus = list; }
   void setDataBaseDir(const QString &dir) { parserisu->setDataBaseDir(dir); }
-  void processDemodulatedSoftBits(const QVector<short> &soft_bits);
 
 private:
   void SendCAssignment(int k, QString decline);
   void SendLogOnOff(int k, QString text);
 
   CChannelAssignmentItem CreateCAssignmentItem(QByteArray su);
-  QByteArray &Decode(QVector<short> &bits, bool soft = false);
-  QByteArray &DecodeC(QVector<short> &bits);
+  QByteArray &Decode(const SoftBit *bits, int count);
+  QByteArray &DecodeC(const SoftBit *bits, int count);
 
-  QVector<short> sbits;
   QByteArray decodedbytes;
-  PreambleDetector preambledetector;
 
   // burstmode really not sure this is used
   PreambleDetector preambledetectorburst;
 
-  // 600 / 1200 MSK phase invariant burst detector
-  PreambleDetectorPhaseInvariant mskBurstDetector;
+  // unique word search of each buffer, set up for the bit rate and burst mode
+  // by setSettings. For OQPSK the I and Q bits are separate arms, indexed by
+  // realimag, and each has its own phase ambiguity
+  UWCorrelator uwcorrelator;
+  bool uwinverted[UW_MAX_ARMS];
 
   int muw;
   bool burstmode;
@@ -907,21 +876,13 @@ private:
   RTChannelDeleaveFECScram rtchanneldeleavefecscram;
   //
 
-  // OQPSK
-  PreambleDetectorPhaseInvariant preambledetectorphaseinvariantimag;
-  PreambleDetectorPhaseInvariant preambledetectorphaseinvariantreal;
-
-  // C Channel OQPSK
-  OQPSKPreambleDetectorAndAmbiguityCorrection preambledetectorreal;
-  OQPSKPreambleDetectorAndAmbiguityCorrection preambledetectorimag;
-
   bool useingOQPSK;
   int AERO_SPEC_NumberOfBits;      // info only
   int AERO_SPEC_TotalNumberOfBits; // info and header and uw
   int AERO_SPEC_BitsInHeader;
   int realimag;
 
-  QVector<int> block;
+  QVector<SoftBit> block;
   AeroLInterleaver leaver;
   AeroLScrambler scrambler;
 
@@ -959,6 +920,8 @@ private:
   QByteArray depuncturedBlock;
   PuncturedCode puncturedCode;
 
+  QTimer *dcdtimer;
+
 private slots:
   void updateDCD();
 };
@@ -0,0 +1,121 @@
+#include <QtEndian>
+#include <cstring>
+
+#include "audiofile.h"
+#include "logger.h"
+
+AudioFile::AudioFile() {
+  wav = false;
+  sampleRate = 0;
+  remaining = -1;
+}
+
+AudioFile::~AudioFile() { close(); }
+
+bool AudioFile::open(const QString &path, quint32 defaultSampleRate) {
+  char magic[4] = {0};
+
+  close();
+
+  file.setFileName(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    CRIT("Failed to open %s: %s", path.toStdString().c_str(),
+         file.errorString().toStdString().c_str());
+    return false;
+  }
+
+  sampleRate = defaultSampleRate;
+  remaining = -1;
+  wav = file.peek(magic, sizeof(magic)) == sizeof(magic) &&
+        ::memcmp(magic, "RIFF", sizeof(magic)) == 0;
+
+  if (wav && !parseWavHeader()) {
+    CRIT("%s is not a mono 16-bit PCM WAV file", path.toStdString().c_str());
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void AudioFile::close() {
+  if (file.isOpen()) {
+    file.close();
+  }
+}
+
+bool AudioFile::parseWavHeader() {
+  uchar header[12];
+  uchar chunk[8];
+  uchar fmt[16];
+  bool haveFmt = false;
+
+  if (file.read((char *)header, sizeof(header)) != sizeof(header) ||
+      ::memcmp(header + 8, "WAVE", 4) != 0)
+    return false;
+
+  while (file.read((char *)chunk, sizeof(chunk)) == sizeof(chunk)) {
+    quint32 chunkSize = qFromLittleEndian<quint32>(chunk + 4);
+
+    if (::memcmp(chunk, "fmt ", 4) == 0) {
+      if (chunkSize < sizeof(fmt) ||
+          file.read((char *)fmt, sizeof(fmt)) != sizeof(fmt))
+        return false;
+
+      quint16 format = qFromLittleEndian<quint16>(fmt);
+      quint16 channels = qFromLittleEndian<quint16>(fmt + 2);
+      quint16 bitsPerSample = qFromLittleEndian<quint16>(fmt + 14);
+
+      // 1 is plain PCM, 0xFFFE is WAVE_FORMAT_EXTENSIBLE
+      if ((format != 1 && format != 0xFFFE) || channels != 1 ||
+          bitsPerSample != 16)
+        return false;
+
+      sampleRate = qFromLittleEndian<quint32>(fmt + 4);
+      haveFmt = true;
+
+      chunkSize -= sizeof(fmt);
+    } else if (::memcmp(chunk, "data", 4) == 0) {
+      if (!haveFmt)
+        return false;
+
+      // streamed recordings leave the size unset
+      remaining = (chunkSize == 0 || chunkSize == 0xFFFFFFFF)
+                      ? file.size() - file.pos()
+                      : (qint64)chunkSize;
+      return true;
+    }
+
+    // chunks are padded to an even size
+    if (!file.seek(file.pos() + chunkSize + (chunkSize & 1)))
+      return false;
+  }
+
+  return false;
+}
+
+qint64 AudioFile::read(char *data, qint64 maxSize) {
+  qint64 size = maxSize & ~((qint64)sizeof(short) - 1);
+  qint64 readSize = 0;
+
+  if (remaining >= 0 && size > remaining)
+    size = remaining & ~((qint64)sizeof(short) - 1);
+
+  if (size <= 0)
+    return 0;
+
+  readSize = file.read(data, size);
+  if (readSize < 0) {
+    CRIT("Failed to read samples: %s",
+         file.errorString().toStdString().c_str());
+    return -1;
+  }
+
+  // drop a trailing odd byte of a truncated file
+  readSize &= ~((qint64)sizeof(short) - 1);
+
+  if (remaining >= 0)
+    remaining -= readSize;
+
+  return readSize;
+}
@@ -0,0 +1,37 @@
+#ifndef AUDIOFILE_H
+#define AUDIOFILE_H
+
+#include <QFile>
+#include <QString>
+
+// Reads mono signed 16-bit little endian PCM for offline replay, either raw
+// or wrapped in a RIFF/WAVE container. For WAV files the sample rate comes
+// from the header, raw files use the rate given to open().
+class AudioFile {
+public:
+  AudioFile();
+  AudioFile(const AudioFile &) = delete;
+  ~AudioFile();
+
+  AudioFile &operator=(const AudioFile &) = delete;
+
+  bool open(const QString &path, quint32 defaultSampleRate);
+  void close();
+
+  // Returns the number of bytes read, always a whole number of samples, 0 at
+  // the end of the samples and -1 on error
+  qint64 read(char *data, qint64 maxSize);
+
+  bool isWav() const { return wav; }
+  quint32 getSampleRate() const { return sampleRate; }
+
+private:
+  bool parseWavHeader();
+
+  QFile file;
+  bool wav;
+  quint32 sampleRate;
+  qint64 remaining;
+};
+
+#endif
@@ -3,13 +3,14 @@
 #include <QDebug>
 
 #include <QTimerEvent>
+#include <algorithm>
 #include <complex.h>
 #include <math.h>
 
 BurstMskDemodulator::BurstMskDemodulator(QObject *parent) : QObject(parent) {
 
   afc = true;
-  timer.start();
+  peak = 0;
 
   Fs = 48000;
 
@@ -22,8 +23,6 @@ BurstMskDemodulator::BurstMskDemodulator(QObject *parent) : QObject(parent) {
 
   SamplesPerSymbol = Fs / fb;
 
-  scatterpointtype = SPT_constellation;
-
   matchedfilter_re = new FIR(2 * SamplesPerSymbol);
   matchedfilter_im = new FIR(2 * SamplesPerSymbol);
   for (int i = 0; i < 2 * SamplesPerSymbol; i++) {
@@ -44,13 +43,6 @@ BurstMskDemodulator::BurstMskDemodulator(QObject *parent) : QObject(parent) {
   mixer_center.SetFreq(freq_center, Fs);
   mixer2.SetFreq(freq_center, Fs);
 
-  spectrumnfft = pow(2, 13);
-  spectrumcycbuff.resize(spectrumnfft);
-  spectrumcycbuff_ptr = 0;
-  spectrumtmpbuff.resize(spectrumnfft);
-
-  pointbuff.resize(100);
-  pointbuff_ptr = 0;
   mse = 10.0;
 
   RxDataBits.reserve(1000); // unpacked
@@ -103,14 +95,21 @@ BurstMskDemodulator::BurstMskDemodulator(QObject *parent) : QObject(parent) {
 void BurstMskDemodulator::setAFC(bool state) { afc = state; }
 
 void BurstMskDemodulator::setCPUReduce(bool state) { cpuReduce = state; }
-void BurstMskDemodulator::setScatterPointType(ScatterPointType type) {
-  scatterpointtype = type;
-}
 
 double BurstMskDemodulator::getCurrentFreq() {
   return mixer_center.GetFreqHz();
 }
 
+DemodMetrics BurstMskDemodulator::getMetrics() {
+  DemodMetrics metrics;
+  metrics.peak = peak;
+  metrics.ebno = ebnomeasure->EbNo;
+  metrics.mse = mse;
+  metrics.freq = mixer2.GetFreqHz();
+  peak = 0;
+  return metrics;
+}
+
 void BurstMskDemodulator::invalidatesettings() {
   Fs = -1;
   fb = -1;
@@ -159,13 +158,8 @@ void BurstMskDemodulator::setSettings(Settings _settings) {
 
   hfir.setSize(2048);
 
-  pointbuff.resize(100);
-
-  pointbuff_ptr = 0;
   mse = 10.0;
 
-  emit Plottables(mixer2.GetFreqHz(), mixer_center.GetFreqHz(), lockingbw);
-
   a1.setdelay(SamplesPerSymbol / 2);
 
   symboltone_averotator = 1;
@@ -313,7 +307,6 @@ void BurstMskDemodulator::CenterFreqChangedSlot(
   if ((mixer2.GetFreqHz() - mixer_center.GetFreqHz()) < (-lockingbw / 2.0)) {
     mixer2.SetFreq(mixer_center.GetFreqHz() - (lockingbw / 2.0));
   }
-  emit Plottables(mixer2.GetFreqHz(), mixer_center.GetFreqHz(), lockingbw);
 }
 
 BurstMskDemodulator::~BurstMskDemodulator() {
@@ -333,35 +326,20 @@ qint64 BurstMskDemodulator::writeData(const char *data, qint64 len) {
   // make analytical signal
   hfirbuff.resize(numofsamples);
 
+  int blockpeak = 0;
   for (int i = 0; i < numofsamples; i++) {
-    hfirbuff[i] = cpx_type(((double)(*ptr)) / 32768.0, 0);
+    hfirbuff[i] = JFFT::cpx_type(((double)(*ptr)) / 32768.0, 0);
+    blockpeak = std::max(blockpeak, std::abs((int)*ptr));
     ptr++;
   }
+  peak = std::max(peak, blockpeak / 32768.0);
 
   hfir.update(hfirbuff);
 
   // run through each sample of analyitical signal
   for (int i = 0; i < hfirbuff.size(); i++) {
 
-    cpx_type cval = hfirbuff[i];
-
-    // take orginal arm
-    double dval = cval.real();
-
-    // spectrum display for looks
-    if (fabs(dval) > maxval)
-      maxval = fabs(dval);
-    spectrumcycbuff[spectrumcycbuff_ptr] = dval;
-    spectrumcycbuff_ptr++;
-    spectrumcycbuff_ptr %= spectrumnfft;
-    // if(timer.elapsed()>150)
-    if ((!cpuReduce && timer.elapsed() > 150) ||
-        (cpuReduce && timer.elapsed() > 1000)) {
-      timer.start();
-      emit OrgOverlapedBuffer(spectrumcycbuff);
-      emit PeakVolume(maxval);
-      maxval = 0;
-    }
+    cpx_type cval = cpx_type(hfirbuff[i]);
 
     // agc
     agc->Update(std::abs(cval));
@@ -491,18 +469,14 @@ qint64 BurstMskDemodulator::writeData(const char *data, qint64 len) {
 
         CenterFreqChangedSlot(((maxtopposhigh + maxtoppos) / 2) * hzperbin);
 
-        emit Plottables(mixer2.GetFreqHz(), mixer2.GetFreqHz(), lockingbw);
-
-        pointbuff.fill(0);
         pointmean->Zero();
-        pointbuff_ptr = 0;
         startstop = startstopstart;
         cntr = 0;
         emit SignalStatus(true);
 
         RxDataBits.clear();
         // indicate start of burst
-        RxDataBits.push_back(-1);
+        RxDataBits.push_back(SOFT_BIT_BURST_START);
 
         mse = 0;
         msema->Zero();
@@ -546,7 +520,7 @@ qint64 BurstMskDemodulator::writeData(const char *data, qint64 len) {
 
     if (startstop > 0 || mse < signalthreshold) {
 
-      cval = mixer2.WTCISValue() * (val_to_demod)*vol_gain;
+      cval = mixer2.WTCISValue() * (dsp_t)(val_to_demod) * (dsp_t)vol_gain;
 
       cpx_type sig2 =
           cpx_type(matchedfilter_re->FIRUpdateAndProcess(cval.real()),
@@ -556,9 +530,10 @@ qint64 BurstMskDemodulator::writeData(const char *data, qint64 len) {
 
         cpx_type symboltone_pt = sig2 * symboltone_rotator * imag;
         double er = std::tanh(symboltone_pt.imag()) * (symboltone_pt.real());
-        symboltone_rotator = symboltone_rotator * std::exp(imag * er * 0.5);
-        symboltone_averotator =
-            symboltone_averotator * 0.999 + 0.001 * symboltone_rotator;
+        symboltone_rotator =
+            symboltone_rotator * std::exp(imag * (dsp_t)er * (dsp_t)0.5);
+        symboltone_averotator = symboltone_averotator * (dsp_t)0.999 +
+                                (dsp_t)0.001 * symboltone_rotator;
 
         symboltone_pt =
             cpx_type((symboltone_pt.real()), a1.update(symboltone_pt.real()));
@@ -578,7 +553,7 @@ qint64 BurstMskDemodulator::writeData(const char *data, qint64 len) {
       }
 
       sig2 *= symboltone_averotator;
-      rotator = rotator * std::exp(imag * rotator_freq);
+      rotator = rotator * std::exp(imag * (dsp_t)rotator_freq);
       sig2 *= rotator;
 
       // Measure ebno
@@ -593,9 +568,9 @@ qint64 BurstMskDemodulator::writeData(const char *data, qint64 len) {
       sig2 *= agc2->Update(std::abs(sig2));
 
       // clipping
-      double abval = std::abs(sig2);
+      dsp_t abval = std::abs(sig2);
       if (abval > 2.84)
-        sig2 = (2.84 / abval) * sig2;
+        sig2 = (dsp_t)(2.84 / abval) * sig2;
 
       // normal symbol timer
       cpx_type pt_d = delayedsmpl.update_dont_touch(sig2);
@@ -630,34 +605,18 @@ qint64 BurstMskDemodulator::writeData(const char *data, qint64 len) {
         if (ct_ec < -M_PI_2)
           ct_ec = -M_PI_2;
         if (cntr > (startProcessing * SamplesPerSymbol)) {
-          rotator =
-              rotator * std::exp(imag * ct_ec * 0.25); // correct carrier phase
+          rotator = rotator * std::exp(imag * (dsp_t)ct_ec *
+                                       (dsp_t)0.25); // correct carrier phase
           if (cntr > endRotation) {
             rotator_freq =
                 rotator_freq + ct_ec * 0.0001; // correct carrier frequency
           }
         }
 
-        // gui feedback
-        if (cntr >= (endRotation + 100 * SamplesPerSymbol) &&
-            pointbuff_ptr < pointbuff.size()) {
-          if (pointbuff_ptr < pointbuff.size()) {
-            ASSERTCH(pointbuff, pointbuff_ptr);
-            pointbuff[pointbuff_ptr] = pt_msk * 0.75;
-            if (pointbuff_ptr < pointbuff.size())
-              pointbuff_ptr++;
-          }
-          if (scatterpointtype == SPT_constellation &&
-              (pointbuff_ptr == pointbuff.size())) {
-            pointbuff_ptr++;
-            emit ScatterPoints(pointbuff);
-          }
-        }
-
         // calc MSE of the points
         if (cntr > (startProcessing * SamplesPerSymbol)) {
-          double tda = (fabs((pt_msk * 0.75).real()) - 1.0);
-          double tdb = (fabs((pt_msk * 0.75).imag()) - 1.0);
+          double tda = (fabs((pt_msk * (dsp_t)0.75).real()) - 1.0);
+          double tdb = (fabs((pt_msk * (dsp_t)0.75).imag()) - 1.0);
           mse = msema->Update((tda * tda) + (tdb * tdb));
         }
 
@@ -667,10 +626,10 @@ qint64 BurstMskDemodulator::writeData(const char *data, qint64 len) {
         int ibit = qRound((imagin) * 127.0 + 128.0);
         if (ibit > 255)
           ibit = 255;
-        if (ibit < 0)
-          ibit = 0;
+        if (ibit < 1)
+          ibit = 1;
 
-        RxDataBits.push_back((uchar)ibit);
+        RxDataBits.push_back((SoftBit)ibit);
 
         double real = diffdecode.UpdateSoft(pt_msk.real());
 
@@ -680,14 +639,16 @@ qint64 BurstMskDemodulator::writeData(const char *data, qint64 len) {
 
         if (ibit > 255)
           ibit = 255;
-        if (ibit < 0)
-          ibit = 0;
+        if (ibit < 1)
+          ibit = 1;
 
-        RxDataBits.push_back((uchar)ibit);
+        RxDataBits.push_back((SoftBit)ibit);
 
         // push them out to decode
         if (RxDataBits.size() >= 12) {
-          emit processDemodulatedSoftBits(RxDataBits);
+          if (softBitSink != nullptr)
+            softBitSink->processSoftBits(RxDataBits.constData(),
+                                         RxDataBits.size());
           RxDataBits.clear();
         }
       }
@@ -705,10 +666,10 @@ qint64 BurstMskDemodulator::writeData(const char *data, qint64 len) {
 
 void BurstMskDemodulator::DCDstatSlot(bool _dcd) { dcd = _dcd; }
 
-void BurstMskDemodulator::dataReceived(const QByteArray &audio,
+void BurstMskDemodulator::processAudio(const char *data, qint64 len,
                                        quint32 sampleRate) {
   if (sampleRate != Fs) {
     qDebug() << "Sample rate not supported by demodulator";
   }
-  writeData(audio, audio.length());
+  writeData(data, len);
 }
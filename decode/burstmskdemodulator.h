@@ -2,6 +2,7 @@
 #define BURSTMSKDEMODULATOR_H
 
 #include "DSP.h"
+#include "pipeline.h"
 #include <QObject>
 
 #include <QVector>
@@ -9,24 +10,15 @@
 
 #include <QPointer>
 
-#include <QElapsedTimer>
-
 #include "fftrwrapper.h"
 
 typedef FFTrWrapper<double> FFTr;
-typedef std::complex<double> cpx_type;
 
 class CoarseFreqEstimate;
 
-class BurstMskDemodulator : public QObject {
+class BurstMskDemodulator : public QObject, public DemodulatorStage {
   Q_OBJECT
 public:
-  enum ScatterPointType {
-    SPT_constellation,
-    SPT_phaseoffseterror,
-    SPT_phaseoffsetest,
-    SPT_None
-  };
   struct Settings {
     int coarsefreqest_fft_power;
     double freq_center;
@@ -51,22 +43,19 @@ public:
   ~BurstMskDemodulator();
 
   qint64 writeData(const char *data, qint64 len);
+  void processAudio(const char *data, qint64 len, quint32 sampleRate);
   void setSettings(Settings settings);
   void invalidatesettings();
   void setAFC(bool state);
   void setCPUReduce(bool state);
-  void setScatterPointType(ScatterPointType type);
   double getCurrentFreq();
+  DemodMetrics getMetrics();
 
 private:
   WaveTable mixer_center;
   WaveTable mixer2;
 
-  int spectrumnfft, bbnfft;
-
-  QVector<double> spectrumcycbuff;
-  QVector<double> spectrumtmpbuff;
-  int spectrumcycbuff_ptr;
+  int bbnfft;
 
   double Fs;
   double freq_center;
@@ -87,14 +76,11 @@ private:
 
   MovingAverage *pointmean;
 
-  QVector<cpx_type> pointbuff;
-  int pointbuff_ptr;
-
   QList<int> tixd;
 
   DiffDecode diffdecode;
 
-  QVector<short> RxDataBits; // unpacked
+  QVector<SoftBit> RxDataBits; // unpacked
 
   double mse;
 
@@ -102,19 +88,15 @@ private:
 
   bool afc;
 
-  int scatterpointtype;
-
   BaceConverter bc;
 
   QPointer<QIODevice> pdatasinkdevice;
 
-  QElapsedTimer timer;
-
   // trident detector stuff
 
   // hilbert
   QJHilbertFilter hfir;
-  QVector<cpx_type> hfirbuff;
+  QVector<JFFT::cpx_type> hfirbuff;
 
   // delay lines
   Delay<cpx_type> bt_d1;
@@ -143,10 +125,10 @@ private:
 
   // fft for trident
   FFTr *fftr;
-  QVector<cpx_type> out_base, out_top;
+  QVector<JFFT::cpx_type> out_base, out_top;
   QVector<double> out_abs_diff;
   QVector<double> in;
-  double maxval;
+  double peak;
   double vol_gain;
   int cntr;
 
@@ -183,12 +165,8 @@ private:
   bool cpuReduce;
 
 signals:
-  void ScatterPoints(const QVector<cpx_type> &buffer);
   void SymbolPhase(double phase_rad);
   void BBOverlapedBuffer(const QVector<cpx_type> &buffer);
-  void OrgOverlapedBuffer(const QVector<double> &buffer);
-  void Plottables(double freq_est, double freq_center, double bandwidth);
-  void PeakVolume(double Volume);
   void RxData(QByteArray &data); // packed in bytes
   void MSESignal(double mse);
   void SignalStatus(bool gotasignal);
@@ -196,12 +174,10 @@ signals:
   void EbNoMeasurmentSignal(double EbNo);
   void SampleRateChanged(double Fs);
   void BitRateChanged(double fb, bool burstmode);
-  void processDemodulatedSoftBits(const QVector<short> &soft_bits);
 
 public slots:
   void CenterFreqChangedSlot(double freq_center);
   void DCDstatSlot(bool dcd);
-  void dataReceived(const QByteArray &audio, quint32 sampleRate);
 };
 
 #endif // BURSTMSKDEMODULATOR_H
@@ -1,16 +1,10 @@
 #include "burstoqpskdemodulator.h"
 
-#define SPECTRUM_FFT_POWER 13
+#include <algorithm>
 
 BurstOqpskDemodulator::BurstOqpskDemodulator(QObject *parent)
     : QObject(parent) {
 
-  timer.start();
-
-  spectrumnfft = pow(2, SPECTRUM_FFT_POWER);
-  spectrumcycbuff.resize(spectrumnfft);
-  spectrumcycbuff_ptr = 0;
-
   mse = 100;
 
   insertpreamble = false;
@@ -101,9 +95,6 @@ BurstOqpskDemodulator::BurstOqpskDemodulator(QObject *parent)
 
   msema = new MovingAverage(128);
 
-  phasepointbuff.resize(1);
-  phasepointbuff_ptr = 0;
-
   //--
 
   pt_d = 0;
@@ -113,7 +104,7 @@ BurstOqpskDemodulator::BurstOqpskDemodulator(QObject *parent)
   startstop = -1;
   vol_gain = 1;
   cntr = 0;
-  maxval = 0;
+  peak = 0;
   channel_select_other = false;
 
   //--
@@ -139,10 +130,6 @@ void BurstOqpskDemodulator::setAFC(bool state) { afc = state; }
 
 void BurstOqpskDemodulator::setCPUReduce(bool state) { cpuReduce = state; }
 
-void BurstOqpskDemodulator::setScatterPointType(ScatterPointType type) {
-  scatterpointtype = type;
-}
-
 void BurstOqpskDemodulator::invalidatesettings() {
   Fs = -1;
   fb = -1;
@@ -179,9 +166,6 @@ void BurstOqpskDemodulator::setSettings(Settings _settings) {
 
   hfir.setSize(2048);
 
-  pointbuff.resize(128);
-  pointbuff_ptr = 0;
-
   bt_d1.setdelay(1.0 * SamplesPerSymbol);
   bt_ma1.setLength(qRound(128.0 * SamplesPerSymbol)); // not sure whats best
 
@@ -228,11 +212,20 @@ void BurstOqpskDemodulator::setSettings(Settings _settings) {
 
   insertpreamble = false;
 
-  emit Plottables(mixer2.GetFreqHz(), mixer2.GetFreqHz(), lockingbw);
 }
 
 double BurstOqpskDemodulator::getCurrentFreq() { return mixer2.GetFreqHz(); }
 
+DemodMetrics BurstOqpskDemodulator::getMetrics() {
+  DemodMetrics metrics;
+  metrics.peak = peak;
+  metrics.ebno = ebnomeasure->EbNo;
+  metrics.mse = mse;
+  metrics.freq = mixer2.GetFreqHz();
+  peak = 0;
+  return metrics;
+}
+
 void BurstOqpskDemodulator::CenterFreqChangedSlot(
     double freq_center) // spectrum display calls this when user changes the
                         // center freq
@@ -251,18 +244,17 @@ qint64 BurstOqpskDemodulator::writeData(const char *data, qint64 len) {
   return len;
 }
 
-void BurstOqpskDemodulator::dataReceived(const QByteArray &audio,
+void BurstOqpskDemodulator::processAudio(const char *data, qint64 len,
                                          quint32 sampleRate) {
   if (sampleRate != Fs) {
     qDebug() << "Sample rate not supported by demodulator";
   }
-  writeData(audio, audio.length());
+  writeData(data, len);
 }
 
 void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
 
   double lastmse = mse;
-  bool sendscatterpoints = false;
 
   int numofsamples = (len / sizeof(short));
   if (channel_stereo)
@@ -271,46 +263,29 @@ void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
   // make analytical signal
   hfirbuff.resize(numofsamples);
   const short *ptr = reinterpret_cast<const short *>(data);
+  int blockpeak = 0;
   if (channel_stereo) {
     if (channel_select_other)
       ptr++;
     for (int i = 0; i < numofsamples; i++) {
-      hfirbuff[i] = cpx_type(((double)(*ptr)) / 32768.0, 0);
+      hfirbuff[i] = JFFT::cpx_type(((double)(*ptr)) / 32768.0, 0);
+      blockpeak = std::max(blockpeak, std::abs((int)*ptr));
       ptr += 2;
     }
   } else {
     for (int i = 0; i < numofsamples; i++) {
-      hfirbuff[i] = cpx_type(((double)(*ptr)) / 32768.0, 0);
+      hfirbuff[i] = JFFT::cpx_type(((double)(*ptr)) / 32768.0, 0);
+      blockpeak = std::max(blockpeak, std::abs((int)*ptr));
       ptr++;
     }
   }
+  peak = std::max(peak, blockpeak / 32768.0);
   hfir.update(hfirbuff);
 
   // run through each sample of analyitical signal
   for (int i = 0; i < hfirbuff.size(); i++) {
 
-    std::complex<double> cval = hfirbuff[i];
-
-    // take orginal arm
-    double dval = cval.real();
-
-    // spectrum display for looks
-    if (fabs(dval) > maxval)
-      maxval = fabs(dval);
-    spectrumcycbuff[spectrumcycbuff_ptr] = dval;
-    spectrumcycbuff_ptr++;
-    spectrumcycbuff_ptr %= spectrumnfft;
-
-    if ((!cpuReduce && timer.elapsed() > 150) ||
-        (cpuReduce && timer.elapsed() > 1000))
-
-    {
-      sendscatterpoints = true;
-      timer.start();
-      emit OrgOverlapedBuffer(spectrumcycbuff);
-      emit PeakVolume(maxval);
-      maxval = 0;
-    }
+    cpx_type cval = cpx_type(hfirbuff[i]);
 
     // agc
     agc->Update(std::abs(cval));
@@ -422,24 +397,16 @@ void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
         double carrierphase = std::arg(out_base[minvalbin]) - (M_PI / 4.0);
         mixer2.SetFreq(hzperbin * minvalbin);
         mixer2.SetPhaseDeg((180.0 / M_PI) * carrierphase);
-        emit Plottables(mixer2.GetFreqHz(), mixer2.GetFreqHz(), lockingbw);
 
         // set gain given estimate
         vol_gain = 1.4142 * 500.0 / minval;
 
-        // set when we want to store points for display
-        // if using rotation bias correction
-        // pointbuff_ptr=-128-128-256;//-128-128;//-400;//-500;//-100;
-        // else
-        pointbuff_ptr = -128 - 128;
-
         // reset the rest
         st_osc.SetFreq(st_osc_ref.GetFreqHz());
         st_osc.SetPhaseDeg(0);
         st_osc_ref.SetPhaseDeg(0);
         st_iir_resonator.init();
         ct_iir_loopfilter.init();
-        pointbuff.fill(0);
         startstop = startstopstart;
         cntr = 0;
         rotator = 1;
@@ -456,7 +423,7 @@ void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
     } // end of trident check
 
     // mix
-    cpx_type cval_dd = mixer2.WTCISValue() * (vol_gain * val_to_demod);
+    cpx_type cval_dd = mixer2.WTCISValue() * (dsp_t)(vol_gain * val_to_demod);
 
     // rrc
     cpx_type sig2 = cpx_type(fir_re->FIRUpdateAndProcess(cval_dd.real()),
@@ -477,7 +444,7 @@ void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
     }
 
     if ((cntr > ((256 - 10) * SamplesPerSymbol)) && insertpreamble) {
-      RxDataBits.push_back(-1);
+      RxDataBits.push_back(SOFT_BIT_BURST_START);
       insertpreamble = false;
     }
 
@@ -493,9 +460,10 @@ void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
       // produce symbol tone circle (symboltone_pt) and calc carrier rotation
       cpx_type symboltone_pt = sig2 * symboltone_rotator * imag;
       double er = std::tanh(symboltone_pt.imag()) * (symboltone_pt.real());
-      symboltone_rotator = symboltone_rotator * std::exp(imag * er * 0.01);
-      symboltone_averotator =
-          symboltone_averotator * 0.95 + 0.05 * symboltone_rotator;
+      symboltone_rotator =
+          symboltone_rotator * std::exp(imag * (dsp_t)er * (dsp_t)0.01);
+      symboltone_averotator = symboltone_averotator * (dsp_t)0.95 +
+                              (dsp_t)0.05 * symboltone_rotator;
       symboltone_pt =
           cpx_type((symboltone_pt.real()), a1.update(symboltone_pt.real()));
       carrier_rotation_est = std::arg(symboltone_averotator);
@@ -513,10 +481,10 @@ void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
 
     sig2 *= symboltone_averotator;
 
-    rotator = rotator * std::exp(imag * rotator_freq);
+    rotator = rotator * std::exp(imag * (dsp_t)rotator_freq);
     sig2 *= rotator;
 
-    double sig2abs = std::abs(sig2);
+    dsp_t sig2abs = std::abs(sig2);
 
     // Measure ebno
     ebnomeasure->Update(sig2abs);
@@ -529,9 +497,9 @@ void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
     sig2 *= agc2->Update(sig2abs);
 
     // clipping
-    double abval = std::abs(sig2);
+    dsp_t abval = std::abs(sig2);
     if (abval > 2.84)
-      sig2 = (2.84 / abval) * sig2;
+      sig2 = (dsp_t)(2.84 / abval) * sig2;
 
     // normal symbol timer
     double st_diff = delays.update(abval * abval) - (abval * abval);
@@ -562,8 +530,8 @@ void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
     {
 
       // interpol
-      double pt_last = st_osc.FractionOfSampleItPassesBy;
-      double pt_this = 1.0 - pt_last;
+      dsp_t pt_last = st_osc.FractionOfSampleItPassesBy;
+      dsp_t pt_this = 1.0 - pt_last;
       cpx_type pt = pt_this * sig2 + pt_last * sig2_last;
 
       // for arm ambiguity resolution. bias calibrated for current settings
@@ -607,8 +575,8 @@ void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
 
         if (cntr > ((128 + 10) * SamplesPerSymbol)) //???
         {
-          rotator =
-              rotator * std::exp(imag * ct_ec * 0.1); // correct carrier phase
+          rotator = rotator * std::exp(imag * (dsp_t)ct_ec *
+                                       (dsp_t)0.1); // correct carrier phase
           if (cntr > ((128 + 10) * SamplesPerSymbol))
             rotator_freq =
                 rotator_freq + ct_ec * 0.0001; // correct carrier frequency
@@ -621,38 +589,6 @@ void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
         rotation_bias_delay.update(pt_qpsk);
         pt_qpsk*=std::exp(-imag*rotation_bias_ma->Val);*/
 
-        // gui feedback
-        if (pointbuff_ptr > 0) {
-          if (pointbuff_ptr < pointbuff.size()) {
-            ASSERTCH(pointbuff, pointbuff_ptr);
-            pointbuff[pointbuff_ptr] = pt_qpsk;
-            if (pointbuff_ptr < pointbuff.size())
-              pointbuff_ptr++;
-          }
-          if (scatterpointtype == SPT_constellation &&
-              (pointbuff_ptr == pointbuff.size()) && (sendscatterpoints)) {
-            pointbuff_ptr++;
-            emit ScatterPoints(pointbuff);
-          }
-        } else
-          pointbuff_ptr++;
-
-        // for looks show symbol phase offset. whats the point?
-        if (scatterpointtype == SPT_phaseoffsetest) {
-          if (pointbuff_ptr > pointbuff.size())
-            pointbuff_ptr = pointbuff.size();
-          if (fabs(cntr - ((128.0 + 128.0 + 128.0) * SamplesPerSymbol)) <
-              SamplesPerSymbol) {
-            cpx_type st_phase_offset_pt =
-                st_osc_ref.WTCISValue() * std::conj(st_osc.WTCISValue());
-            ASSERTCH(phasepointbuff, phasepointbuff_ptr);
-            phasepointbuff[phasepointbuff_ptr] = st_phase_offset_pt;
-            phasepointbuff_ptr++;
-            phasepointbuff_ptr %= phasepointbuff.size();
-            emit ScatterPoints(phasepointbuff);
-          }
-        }
-
         // calc MSE of the points
         if (cntr > ((128 + 10) * SamplesPerSymbol)) {
           double tda = (fabs(pt_qpsk.real()) - 1.0);
@@ -666,25 +602,27 @@ void BurstOqpskDemodulator::writeDataSlot(const char *data, qint64 len) {
           int ibit = qRound(0.75 * pt_qpsk.imag() * 127.0 + 128.0);
           if (ibit > 255)
             ibit = 255;
-          if (ibit < 0)
-            ibit = 0;
+          if (ibit < 1)
+            ibit = 1;
 
-          RxDataBits.push_back((uchar)ibit);
+          RxDataBits.push_back((SoftBit)ibit);
 
           ibit = qRound(0.75 * pt_qpsk.real() * 127.0 + 128.0);
           if (ibit > 255)
             ibit = 255;
-          if (ibit < 0)
-            ibit = 0;
+          if (ibit < 1)
+            ibit = 1;
 
-          RxDataBits.push_back((uchar)ibit);
+          RxDataBits.push_back((SoftBit)ibit);
 
           // return the demodulated data (soft bit)
 
           if (RxDataBits.size() >= 32) {
             if (mse < signalthreshold || lastmse < signalthreshold) {
 
-              emit processDemodulatedSoftBits(RxDataBits);
+              if (softBitSink != nullptr)
+                softBitSink->processSoftBits(RxDataBits.constData(),
+                                             RxDataBits.size());
             }
             RxDataBits.clear();
           }
@@ -2,7 +2,7 @@
 #define BURSTOQPSKDEMODULATOR_H
 
 #include "DSP.h"
-#include <QElapsedTimer>
+#include "pipeline.h"
 #include <QObject>
 #include <QPointer>
 #include <QVector>
@@ -12,17 +12,10 @@
 #include "fftrwrapper.h"
 
 typedef FFTrWrapper<double> FFTr;
-typedef std::complex<double> cpx_type;
 
-class BurstOqpskDemodulator : public QObject {
+class BurstOqpskDemodulator : public QObject, public DemodulatorStage {
   Q_OBJECT
 public:
-  enum ScatterPointType {
-    SPT_constellation,
-    SPT_phaseoffseterror,
-    SPT_phaseoffsetest,
-    SPT_None
-  };
   struct Settings {
     int coarsefreqest_fft_power;
     double freq_center;
@@ -50,33 +43,28 @@ public:
   void setSettings(Settings settings);
   void invalidatesettings();
   qint64 writeData(const char *data, qint64 len);
+  void processAudio(const char *data, qint64 len, quint32 sampleRate);
   double getCurrentFreq();
-  void setScatterPointType(ScatterPointType type);
+  DemodMetrics getMetrics();
 
   //--L/R channel selection
   bool channel_select_other;
 
 signals:
-  void ScatterPoints(const QVector<cpx_type> &buffer);
-  void OrgOverlapedBuffer(const QVector<double> &buffer);
-  void PeakVolume(double Volume);
   void SampleRateChanged(double Fs);
   void BitRateChanged(double fb, bool burstmode);
-  void Plottables(double freq_est, double freq_center, double bandwidth);
   void BBOverlapedBuffer(const QVector<cpx_type> &buffer);
   void MSESignal(double mse);
   void SignalStatus(bool gotasignal);
   void WarningTextSignal(const QString &str);
   void EbNoMeasurmentSignal(double EbNo);
   void writeDataSignal(const char *data, qint64 len);
-  void processDemodulatedSoftBits(const QVector<short> &soft_bits);
 
 private:
   const cpx_type imag = cpx_type(0, 1);
 
   QPointer<QIODevice> pdatasinkdevice;
   bool afc;
-  int scatterpointtype;
 
   double Fs;
   double freq_center;
@@ -89,26 +77,17 @@ private:
 
   WaveTable mixer2;
 
-  QVector<double> spectrumcycbuff;
-  int spectrumcycbuff_ptr;
-  int spectrumnfft;
-
   QVector<cpx_type> bbcycbuff;
   QVector<cpx_type> bbtmpbuff;
   int bbcycbuff_ptr;
   int bbnfft;
 
-  QVector<cpx_type> pointbuff;
-  int pointbuff_ptr;
-
-  QElapsedTimer timer;
-
   //--symbol timing detection
   AGC *agc;
 
   // hilbert
   QJHilbertFilter hfir;
-  QVector<cpx_type> hfirbuff;
+  QVector<JFFT::cpx_type> hfirbuff;
 
   // delay lines
   Delay<cpx_type> bt_d1;
@@ -134,7 +113,7 @@ private:
 
   // fft for trident
   FFTr *fftr;
-  QVector<cpx_type> out_base, out_top;
+  QVector<JFFT::cpx_type> out_base, out_top;
   QVector<double> out_abs_diff;
   QVector<double> in;
 
@@ -171,14 +150,11 @@ private:
 
   BaceConverter bc;
   QByteArray RxDataBytes;    // packed in bytes
-  QVector<short> RxDataBits; // unpacked soft bits
+  QVector<SoftBit> RxDataBits; // unpacked soft bits
 
   double mse;
   MovingAverage *msema;
 
-  QVector<cpx_type> phasepointbuff;
-  int phasepointbuff_ptr;
-
   //--
 
   DelayThing<cpx_type> rotation_bias_delay;
@@ -194,7 +170,7 @@ private:
   int startstop;
   double vol_gain;
   int cntr;
-  double maxval;
+  double peak;
 
   bool channel_stereo;
 
@@ -203,7 +179,6 @@ private:
 public slots:
   void CenterFreqChangedSlot(double freq_center);
   void writeDataSlot(const char *data, qint64 len);
-  void dataReceived(const QByteArray &audio, quint32 sampleRate);
 };
 
 #endif // BURSTOQPSKDEMODULATOR_H
@@ -0,0 +1,169 @@
+#include "channel.h"
+#include "logger.h"
+
+Channel::Channel(const QString &topic, int bitRate, bool burstMode,
+                 bool disableReassembly, FrameSink *frameSink, QObject *parent)
+    : QObject(parent) {
+  this->topic = topic;
+
+  demod = nullptr;
+  sampleClock = false;
+  clockSamples = 0;
+
+  aerol = new AeroL(this);
+  aerol->setBitRate(bitRate);
+  aerol->setBurstmode(burstMode);
+  // TODO: do we want to display ISU messages? if so, make sure to
+  //       setDoNotDisplay to ignore spammy messages
+
+  hunter = new SignalHunter(15, this);
+
+  connect(hunter, SIGNAL(newFreqCenter(double)), this,
+          SLOT(handleNewFreqCenter(double)));
+  connect(hunter, SIGNAL(noSignalAfterScan()), this,
+          SLOT(handleNoSignalAfterFullScan()));
+
+  // Only the demodulator this channel actually uses is created so idle
+  // pipelines don't hold FFT and filter state per VFO
+  QObject *demodObject = nullptr;
+
+  if (bitRate > 1200) {
+    hunter->setParams(0, 25000, 10500);
+
+    if (burstMode) {
+      DBG("%s: using burst OQPSK demodulator", topic.toStdString().c_str());
+
+      BurstOqpskDemodulator::Settings burstOqpskSettings;
+      burstOqpskSettings.zmqAudio = true;
+
+      BurstOqpskDemodulator *burstOqpskDemod = new BurstOqpskDemodulator(this);
+      burstOqpskDemod->setAFC(true);
+      burstOqpskDemod->setCPUReduce(false);
+      burstOqpskDemod->setSettings(burstOqpskSettings);
+
+      hunter->disable();
+      demod = burstOqpskDemod;
+      demodObject = burstOqpskDemod;
+    } else {
+      DBG("%s: using OQPSK demodulator", topic.toStdString().c_str());
+
+      OqpskDemodulator::Settings oqpskSettings;
+      oqpskSettings.zmqAudio = true;
+      oqpskSettings.freq_center = 0;
+
+      OqpskDemodulator *oqpskDemod = new OqpskDemodulator(this);
+      oqpskDemod->setAFC(true);
+      oqpskDemod->setSettings(oqpskSettings);
+
+      demod = oqpskDemod;
+      demodObject = oqpskDemod;
+    }
+  } else {
+    hunter->setParams(0, 6000, 900);
+
+    if (burstMode) {
+      DBG("%s: using burst MSK demodulator", topic.toStdString().c_str());
+
+      BurstMskDemodulator::Settings burstMskSettings;
+      burstMskSettings.zmqAudio = true;
+      burstMskSettings.Fs = 48000;
+      burstMskSettings.fb = 1200;
+      burstMskSettings.lockingbw = 10500;
+
+      BurstMskDemodulator *burstMskDemod = new BurstMskDemodulator(this);
+      burstMskDemod->setAFC(true);
+      burstMskDemod->setCPUReduce(false);
+      burstMskDemod->setSettings(burstMskSettings);
+
+      hunter->disable();
+      demod = burstMskDemod;
+      demodObject = burstMskDemod;
+    } else {
+      DBG("%s: using MSK demodulator", topic.toStdString().c_str());
+
+      MskDemodulator::Settings mskSettings;
+      mskSettings.zmqAudio = true;
+      mskSettings.freq_center = 0;
+      mskSettings.Fs = (bitRate == 600) ? 12000 : 24000;
+
+      MskDemodulator *mskDemod = new MskDemodulator(this);
+      mskDemod->setAFC(true);
+      mskDemod->setSettings(mskSettings);
+
+      demod = mskDemod;
+      demodObject = mskDemod;
+    }
+  }
+
+  // data plane: direct calls from the demodulator into AeroL and from AeroL
+  // into the frame sink, no queued signals or vector copies per frame
+  demod->setSoftBitSink(aerol);
+  aerol->setFrameSink(frameSink, disableReassembly);
+
+  // control plane
+  connect(demodObject, SIGNAL(SignalStatus(bool)), hunter,
+          SLOT(updatedSignalStatus(bool)));
+  connect(hunter, SIGNAL(newFreqCenter(double)), demodObject,
+          SLOT(CenterFreqChangedSlot(double)));
+
+  connect(aerol, SIGNAL(DataCarrierDetect(bool)), hunter,
+          SLOT(handleDcd(bool)));
+  connect(hunter, SIGNAL(dcdChange(bool, bool)), this,
+          SLOT(handleDcdChange(bool, bool)));
+}
+
+Channel::~Channel() {}
+
+void Channel::processAudio(const char *data, qint64 len, quint32 sampleRate) {
+  demod->processAudio(data, len, sampleRate);
+
+  // after the demodulator so a new centre lands between blocks
+  hunter->processAudio(reinterpret_cast<const short *>(data),
+                       len / sizeof(short), sampleRate);
+
+  if (sampleClock && sampleRate > 0) {
+    clockSamples += len / sizeof(short);
+    while (clockSamples >= sampleRate) {
+      clockSamples -= sampleRate;
+      aerol->tickDCD();
+    }
+  }
+}
+
+void Channel::setCoarseEstimatePolicy(CoarseEstimatePolicy policy) {
+  demod->setCoarseEstimatePolicy(policy);
+}
+
+void Channel::setHuntMode(HuntMode mode) { hunter->setMode(mode); }
+
+void Channel::setSampleClock(bool enabled) {
+  sampleClock = enabled;
+  clockSamples = 0;
+  aerol->setDCDTimerEnabled(!enabled);
+}
+
+void Channel::frameReceived(const ZmqFramePtr &frame) {
+  // the demodulator consumes the samples synchronously and we hold a
+  // reference to the frame until it returns, so it reads the ZeroMQ buffer
+  processAudio(frame->data(), frame->size(), frame->sampleRate);
+}
+
+void Channel::handleNoSignalAfterFullScan() { emit noSignalAfterScan(topic); }
+
+void Channel::handleDcdChange(bool old_state, bool new_state) {
+  demod->setCoarseEstimateDCD(new_state);
+
+  if (new_state) {
+    DBG("%s: data carrier detected: no signal => signal",
+        topic.toStdString().c_str());
+    emit signalFound(topic);
+  } else {
+    DBG("%s: data carrier lost: signal => no signal",
+        topic.toStdString().c_str());
+  }
+}
+
+void Channel::handleNewFreqCenter(double freq_center) {
+  DBG("%s: trying frequency center %.1f in search of signal",
+      topic.toStdString().c_str(), freq_center);
+}
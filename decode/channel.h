@@ -0,0 +1,73 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include "aerol.h"
+#include "burstmskdemodulator.h"
+#include "burstoqpskdemodulator.h"
+#include "hunter.h"
+#include "mskdemodulator.h"
+#include "oqpskdemodulator.h"
+#include "pipeline.h"
+#include "zmqframe.h"
+#include <QObject>
+#include <QString>
+
+// One VFO worth of decoding: the demodulator selected by the bit rate and
+// burst mode, its AeroL decoder and the signal hunter driving it. Decoded
+// frames go to frameSink on the channel thread. Channels have no parent so
+// Decoder can move each of them onto a worker thread.
+class Channel : public QObject {
+  Q_OBJECT
+
+public:
+  Channel(const QString &topic, int bitRate, bool burstMode,
+          bool disableReassembly, FrameSink *frameSink,
+          QObject *parent = nullptr);
+  Channel(const Channel &) = delete;
+  Channel(Channel &&) noexcept = delete;
+  ~Channel();
+
+  Channel &operator=(const Channel &) = delete;
+  Channel &operator=(Channel &&) noexcept = delete;
+
+  const QString &getTopic() const { return topic; }
+
+  // Call on the channel thread
+  DemodMetrics getMetrics() { return demod->getMetrics(); }
+
+  // Feeds samples straight into the demodulator on the calling thread, used
+  // for offline replay where the channel is never moved to a worker
+  void processAudio(const char *data, qint64 len, quint32 sampleRate);
+
+  // Call before the channel is moved to its worker
+  void setCoarseEstimatePolicy(CoarseEstimatePolicy policy);
+  void setHuntMode(HuntMode mode);
+
+  // Runs the DCD timeout off the number of samples processed rather than the
+  // wall clock
+  void setSampleClock(bool enabled);
+
+private:
+  QString topic;
+
+  bool sampleClock;
+  qint64 clockSamples;
+
+  AeroL *aerol;
+  DemodulatorStage *demod;
+
+  SignalHunter *hunter;
+
+public slots:
+  void frameReceived(const ZmqFramePtr &frame);
+
+  void handleNoSignalAfterFullScan();
+  void handleNewFreqCenter(double freq_center);
+  void handleDcdChange(bool old_state, bool new_state);
+
+signals:
+  void noSignalAfterScan(const QString &topic);
+  void signalFound(const QString &topic);
+};
+
+#endif
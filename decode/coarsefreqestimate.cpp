@@ -12,7 +12,6 @@ CoarseFreqEstimate::CoarseFreqEstimate(QObject *parent) : QObject(parent) {
   fft = new FFT(nfft, false);
   ifft = new FFT(nfft, true);
   hzperbin = Fs / ((double)nfft);
-  out.resize(nfft);
   in.resize(nfft);
   y.resize(nfft);
   z.resize(nfft);
@@ -50,7 +49,6 @@ void CoarseFreqEstimate::setSettings(int _coarsefreqest_fft_power,
   fft = new FFT(nfft, false);
   ifft = new FFT(nfft, true);
   hzperbin = Fs / ((double)nfft);
-  out.resize(nfft);
   in.resize(nfft);
   y.resize(nfft);
   z.resize(nfft);
@@ -90,31 +88,35 @@ void CoarseFreqEstimate::ProcessBasebandData(const QVector<cpx_type> &data) {
   // fft size must be even. 2^n is best
   assert(nfft == data.size());
 
+  // the estimate is always done in double whatever the sample type
+  for (int i = 0; i < nfft; i++)
+    in[i] = data[i];
+
   // remove high frequencies then square and do fft and shift (0hz bin is at
-  // nfft/2)
-  fft->transform(data, out);
+  // nfft/2). all in place in the one buffer
+  fft->transform(in);
 
   // what window would be better?
   if (fb != 8400)
     for (int i = startbin; i <= stopbin; i++)
-      out[i] =
+      in[i] =
           0; // this one is a boxcar window so can be pulled easily to the sides
   else
     for (int i = 0; i < nfft; i++)
-      out[i] *= window[i]; // this one will weight ones closer to the center
-                           // more
+      in[i] *= window[i]; // this one will weight ones closer to the center
+                          // more
 
-  ifft->transform(out, in);
+  ifft->transform(in);
   for (int i = 0; i < nfft; i++)
     in[i] = in[i] * in[i];
-  fft->transform(in, out);
+  fft->transform(in);
   for (int i = 0; i < nfft / 2; i++)
-    std::swap(out[i + nfft / 2], out[i]);
+    std::swap(in[i + nfft / 2], in[i]);
 
   // smooth
   for (int i = 0; i < nfft; i++)
-    y[i] = y[i] * 0.9 + 0.1 * 10 * log10(fmax(abs(out[i]), 1));
-  // for(int i=0;i<nfft;i++)y[i]=10*log10(fmax(abs(out[i]),1));
+    y[i] = y[i] * 0.9 + 0.1 * 10 * log10(fmax(abs(in[i]), 1));
+  // for(int i=0;i<nfft;i++)y[i]=10*log10(fmax(abs(in[i]),1));
 
   // fold and look for the fold that produces a big peak at the expected peak
   // location
@@ -4,10 +4,45 @@
 #include <QObject>
 #include <QVector>
 
+#include "DSP.h"
 #include "fftwrapper.h"
+#include "pipeline.h"
 
 typedef FFTWrapper<double> FFT;
-typedef std::complex<double> cpx_type;
+
+// Seconds DCD has to hold before the adaptive policy slows the estimator
+const int COARSE_TRACKING_HOLD_S = 10;
+
+// Picks the coarse estimator rate for a block of samples from the policy and
+// how long DCD has held. Hunting and any DCD loss get the full rate, a
+// carrier AeroL has been decoding for a while only needs tracking.
+class CoarseEstimateSchedule {
+public:
+  CoarseEstimateSchedule() : policy(CoarseAdaptive), dcd(false), held(0) {}
+
+  void setPolicy(CoarseEstimatePolicy policy) { this->policy = policy; }
+  void setDCD(bool dcd) {
+    this->dcd = dcd;
+    held = 0;
+  }
+
+  // true when the block should run at the tracking rate
+  bool reduce(int samples, double Fs) {
+    if (policy != CoarseAdaptive)
+      return policy == CoarseTracking;
+    if (!dcd)
+      return false;
+    const qint64 hold = COARSE_TRACKING_HOLD_S * (qint64)Fs;
+    if (held < hold)
+      held += samples;
+    return held >= hold;
+  }
+
+private:
+  CoarseEstimatePolicy policy;
+  bool dcd;
+  qint64 held; // samples since DCD came up
+};
 
 class CoarseFreqEstimate : public QObject {
   Q_OBJECT
@@ -25,8 +60,7 @@ public slots:
 private:
   FFT *fft;
   FFT *ifft;
-  QVector<cpx_type> out;
-  QVector<cpx_type> in;
+  QVector<JFFT::cpx_type> in;
   QVector<double> window;
   QVector<double> y;
   QVector<double> z;
@@ -1,6 +1,7 @@
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QHostAddress>
-#include <QJsonDocument>
 #include <QTcpSocket>
 #include <QUdpSocket>
 #include <libacars/acars.h>
@@ -8,6 +9,7 @@
 #include <libacars/vstring.h>
 #include <zmq.h>
 
+#include "audiofile.h"
 #include "decode.h"
 #include "logger.h"
 #include "output.h"
@@ -55,7 +57,8 @@ bool libacarsDecode(ACARSItem &item) {
   if (vstr == nullptr)
     goto exit;
 
-  item.parsed = QJsonDocument::fromJson(QString(vstr->str).toUtf8()).object();
+  // kept serialized, JsonDump splices it into its acars object as it is
+  item.parsedJson = QByteArray(vstr->str, (int)vstr->len);
 
   ::la_vstring_destroy(vstr, true);
 
@@ -70,20 +73,32 @@ exit:
 }
 
 Decoder::Decoder(const QString &station_id, const QString &publisher,
-                 const QString &topic, const QString &format, int bitRate,
+                 const QStringList &topics, const QString &format, int bitRate,
                  bool burstMode, const QString &rawForwarders,
                  bool disableReassembly, QObject *parent)
-    : QObject(parent) {
+    : QObject(parent), sendBuffer(DEFAULT_SEND_BUFFER_ITEMS) {
   this->publisher = publisher;
   this->stationId = station_id;
-  this->topic = topic;
   this->bitRate = bitRate;
   this->burstMode = burstMode;
   this->disableReassembly = disableReassembly;
   this->format = parseOutputFormat(format);
+  this->workerThreads = QThread::idealThreadCount();
+  this->decodeThreads = DEFAULT_DECODE_THREADS;
+  this->inputSampleRate = 48000;
+  this->reportStats = false;
+  this->nextDecodeSeq = 0;
+  this->nextForwardSeq = 0;
+  this->coarsePolicy = CoarseAdaptive;
+  this->huntMode = HuntSpectrum;
+
+  zmqContext = nullptr;
+  zmqSub = nullptr;
 
   running.storeRelease(0);
 
+  qRegisterMetaType<ZmqFramePtr>("ZmqFramePtr");
+
   if (!validBitRates.contains(this->bitRate)) {
     CRIT("Unsupported bit rate: %d", this->bitRate);
     return;
@@ -94,6 +109,22 @@ Decoder::Decoder(const QString &station_id, const QString &publisher,
     return;
   }
 
+  // a trailing * turns a topic into a prefix, channels for it are created as
+  // matching VFOs show up on the publisher
+  for (const auto &topic : topics) {
+    if (topic.endsWith("*")) {
+      if (!topicPrefix.isEmpty()) {
+        CRIT("Only one topic prefix is supported: %s",
+             topic.toStdString().c_str());
+        return;
+      }
+
+      topicPrefix = topic.chopped(1);
+    } else if (!topic.isEmpty() && !this->topics.contains(topic)) {
+      this->topics.append(topic);
+    }
+  }
+
   if (!rawForwarders.isEmpty()) {
     if (!parseForwarder(rawForwarders)) {
       CRIT("Some forwarders configuration may be malformed: %s",
@@ -114,136 +145,24 @@ Decoder::Decoder(const QString &station_id, const QString &publisher,
     return;
   }
 
-  aerol = new AeroL(this);
-  aerol->setBitRate(this->bitRate);
-  aerol->setBurstmode(this->burstMode);
-  // TODO: do we want to display ISU messages? if so, make sure to
-  //       setDoNotDisplay to ignore spammy messages
-
-  BurstMskDemodulator::Settings burstMskSettings;
-  burstMskSettings.zmqAudio = true;
-  burstMskSettings.Fs = 48000;
-  burstMskSettings.fb = 1200;
-  burstMskSettings.lockingbw = 10500;
-
-  burstMskDemod = new BurstMskDemodulator(this);
-  burstMskDemod->setAFC(true);
-  burstMskDemod->setCPUReduce(false);
-  burstMskDemod->setSettings(burstMskSettings);
-
-  BurstOqpskDemodulator::Settings burstOqpskSettings;
-  burstOqpskSettings.zmqAudio = true;
-
-  burstOqpskDemod = new BurstOqpskDemodulator(this);
-  burstOqpskDemod->setAFC(true);
-  burstOqpskDemod->setCPUReduce(false);
-  burstOqpskDemod->setSettings(burstOqpskSettings);
-
-  MskDemodulator::Settings mskSettings;
-  mskSettings.zmqAudio = true;
-  mskSettings.freq_center = 0;
-  mskSettings.Fs = (this->bitRate == 600) ? 12000 : 24000;
-
-  mskDemod = new MskDemodulator(this);
-  mskDemod->setAFC(true);
-  mskDemod->setCPUReduce(false);
-  mskDemod->setSettings(mskSettings);
-
-  OqpskDemodulator::Settings oqpskSettings;
-  oqpskSettings.zmqAudio = true;
-  oqpskSettings.freq_center = 0;
-
-  oqpskDemod = new OqpskDemodulator(this);
-  oqpskDemod->setAFC(true);
-  oqpskDemod->setCPUReduce(false);
-  oqpskDemod->setSettings(oqpskSettings);
-
-  hunter = new SignalHunter(15, this);
-
-  connect(hunter, SIGNAL(newFreqCenter(double)), this,
-          SLOT(handleNewFreqCenter(double)));
-  connect(hunter, SIGNAL(noSignalAfterScan()), this,
-          SLOT(handleNoSignalAfterFullScan()));
-
-  if (this->bitRate > 1200) {
-    hunter->setParams(0, 25000, 10500);
-
-    if (burstMode) {
-      DBG("Connecting audioReceived signal to burst OQPSK demodulator");
-
-      hunter->disable();
-      connect(this, SIGNAL(audioReceived(const QByteArray &, quint32)),
-              burstOqpskDemod, SLOT(dataReceived(const QByteArray &, quint32)));
-      connect(burstOqpskDemod,
-              SIGNAL(processDemodulatedSoftBits(const QVector<short> &)), aerol,
-              SLOT(processDemodulatedSoftBits(const QVector<short> &)));
-      connect(burstOqpskDemod, SIGNAL(SignalStatus(bool)), hunter,
-              SLOT(updatedSignalStatus(bool)));
-      connect(hunter, SIGNAL(newFreqCenter(double)), burstOqpskDemod,
-              SLOT(CenterFreqChangedSlot(double)));
-    } else {
-      DBG("Connecting audioReceived signal to OQPSK demodulator");
-
-      connect(this, SIGNAL(audioReceived(const QByteArray &, quint32)),
-              oqpskDemod, SLOT(dataReceived(const QByteArray &, quint32)));
-      connect(oqpskDemod,
-              SIGNAL(processDemodulatedSoftBits(const QVector<short> &)), aerol,
-              SLOT(processDemodulatedSoftBits(const QVector<short> &)));
-      connect(oqpskDemod, SIGNAL(SignalStatus(bool)), hunter,
-              SLOT(updatedSignalStatus(bool)));
-      connect(hunter, SIGNAL(newFreqCenter(double)), oqpskDemod,
-              SLOT(CenterFreqChangedSlot(double)));
-    }
-  } else {
-    hunter->setParams(0, 6000, 900);
-
-    if (burstMode) {
-      DBG("Connecting audioReceived signal to burst MSK demodulator");
-
-      hunter->disable();
-      connect(this, SIGNAL(audioReceived(const QByteArray &, quint32)),
-              burstMskDemod, SLOT(dataReceived(const QByteArray &, quint32)));
-      connect(burstMskDemod,
-              SIGNAL(processDemodulatedSoftBits(const QVector<short> &)), aerol,
-              SLOT(processDemodulatedSoftBits(const QVector<short> &)));
-      connect(burstMskDemod, SIGNAL(SignalStatus(bool)), hunter,
-              SLOT(updatedSignalStatus(bool)));
-      connect(hunter, SIGNAL(newFreqCenter(double)), burstMskDemod,
-              SLOT(CenterFreqChangedSlot(double)));
-    } else {
-      DBG("Connecting audioReceived signal to MSK demodulator");
-
-      connect(this, SIGNAL(audioReceived(const QByteArray &, quint32)),
-              mskDemod, SLOT(dataReceived(const QByteArray &, quint32)));
-      connect(mskDemod,
-              SIGNAL(processDemodulatedSoftBits(const QVector<short> &)), aerol,
-              SLOT(processDemodulatedSoftBits(const QVector<short> &)));
-      connect(mskDemod, SIGNAL(SignalStatus(bool)), hunter,
-              SLOT(updatedSignalStatus(bool)));
-      connect(hunter, SIGNAL(newFreqCenter(double)), mskDemod,
-              SLOT(CenterFreqChangedSlot(double)));
-    }
-  }
+  running.storeRelease(1);
+}
 
-  connect(aerol, SIGNAL(DataCarrierDetect(bool)), hunter,
-          SLOT(handleDcd(bool)));
-  connect(hunter, SIGNAL(dcdChange(bool, bool)), this,
-          SLOT(handleDcdChange(bool, bool)));
+Decoder::~Decoder() {
+  running.storeRelease(0);
+  consumerThread.waitForFinished();
 
-  if (this->disableReassembly) {
-    DBG("Reassembly disabled, connecting to ACARSfragmentsignal signal");
-    connect(aerol, SIGNAL(ACARSfragmentsignal(ACARSItem &)), this,
-            SLOT(handleACARS(ACARSItem &)));
-  } else {
-    DBG("Reassembly enabled, connecting to ACARSsignal signal");
-    connect(aerol, SIGNAL(ACARSsignal(ACARSItem &)), this,
-            SLOT(handleACARS(ACARSItem &)));
+  for (auto worker : workers) {
+    worker->quit();
+    worker->wait();
   }
 
-  running.storeRelease(1);
-}
+  // workers are stopped so the channels can be safely deleted from here
+  qDeleteAll(channels);
+  qDeleteAll(workers);
+
+  forwardLoop.stop(0);
 
-Decoder::~Decoder() {
   for (auto target : forwarders) {
     if (target != nullptr) {
       delete target;
@@ -260,8 +179,21 @@ Decoder::~Decoder() {
 }
 
 void Decoder::run() {
-  DBG("Starting concurrent publishing consumer thread");
-  consumerThread = QtConcurrent::run([this] { publisherConsumer(); });
+  if (!inputFile.isEmpty()) {
+    DBG("Starting concurrent file replay thread");
+    consumerThread = QtConcurrent::run([this] { fileConsumer(); });
+  } else {
+    if (running.loadAcquire()) {
+      for (const auto &topic : topics) {
+        addChannel(topic);
+      }
+    }
+
+    DBG("Starting concurrent publishing consumer thread");
+    consumerThread = QtConcurrent::run([this] { publisherConsumer(); });
+  }
+
+  decodePool.setMaxThreadCount(qMax(decodeThreads, 1));
 
   DBG("Starting concurrent forwarder consumer thread");
   forwarderThread = QtConcurrent::run([this] { forwarderConsumer(); });
@@ -280,25 +212,114 @@ bool Decoder::parseForwarder(const QString &raw) {
   return true;
 }
 
+Channel *Decoder::addChannel(const QString &name) {
+  QMutexLocker locker(&channelsMutex);
+
+  Channel *channel =
+      new Channel(name, bitRate, burstMode, disableReassembly, this);
+  channel->setCoarseEstimatePolicy(coarsePolicy);
+  channel->setHuntMode(huntMode);
+
+  connect(channel, SIGNAL(noSignalAfterScan(const QString &)), this,
+          SLOT(handleNoSignalAfterFullScan(const QString &)));
+  connect(channel, SIGNAL(signalFound(const QString &)), this,
+          SLOT(handleSignalFound(const QString &)));
+
+  QThread *worker = nullptr;
+  if (workers.size() < qMax(workerThreads, 1)) {
+    worker = new QThread();
+    worker->start();
+    workers.append(worker);
+  } else {
+    worker = workers[channels.size() % workers.size()];
+  }
+
+  channel->moveToThread(worker);
+  channels.insert(name, channel);
+
+  DBG("Added channel for topic %s on worker %lld", name.toStdString().c_str(),
+      workers.indexOf(worker));
+
+  return channel;
+}
+
+Channel *Decoder::findChannel(const QString &name) {
+  QMutexLocker locker(&channelsMutex);
+  return channels.value(name, nullptr);
+}
+
+bool Decoder::receiveFrame(zmq_msg_t *topicMsg, zmq_msg_t *rateMsg) {
+  ZmqFramePtr frame;
+  QString topicName;
+  Channel *channel = nullptr;
+
+  if (::zmq_msg_recv(topicMsg, zmqSub, ZMQ_DONTWAIT) < 0)
+    return false;
+
+  // ZMQ subscriptions are prefix matches, so VFO5 also delivers VFO51;
+  // dispatch on the exact topic and only create channels in prefix mode
+  topicName = QString::fromLatin1((const char *)::zmq_msg_data(topicMsg),
+                                  ::zmq_msg_size(topicMsg));
+  channel = findChannel(topicName);
+  if (channel == nullptr && !topicPrefix.isEmpty() &&
+      topicName.startsWith(topicPrefix)) {
+    channel = addChannel(topicName);
+  }
+
+  // multipart messages are delivered atomically, so the remaining parts are
+  // already queued once the topic arrived
+  if (channel == nullptr || !::zmq_msg_more(topicMsg)) {
+    goto Drain;
+  }
+
+  if (::zmq_msg_recv(rateMsg, zmqSub, ZMQ_DONTWAIT) < 0)
+    return true;
+
+  if (::zmq_msg_size(rateMsg) != sizeof(quint32) || !::zmq_msg_more(rateMsg))
+    goto Drain;
+
+  frame = ZmqFramePtr::create();
+  ::memcpy(&frame->sampleRate, ::zmq_msg_data(rateMsg), sizeof(quint32));
+
+  if (::zmq_msg_recv(frame->message(), zmqSub, ZMQ_DONTWAIT) < 0)
+    return true;
+
+  QMetaObject::invokeMethod(channel, "frameReceived", Qt::QueuedConnection,
+                            Q_ARG(ZmqFramePtr, frame));
+
+  if (!::zmq_msg_more(frame->message()))
+    return true;
+
+Drain:
+  int more = 0;
+  size_t moreSize = sizeof(more);
+  while (::zmq_getsockopt(zmqSub, ZMQ_RCVMORE, &more, &moreSize) == 0 &&
+         more) {
+    ::zmq_recv(zmqSub, nullptr, 0, ZMQ_DONTWAIT);
+    moreSize = sizeof(more);
+  }
+
+  return true;
+}
+
 void Decoder::publisherConsumer() {
-  int bufSize = 192000;
-  int recvSize = 0;
   int status = 0;
-  quint32 sampleRate = 48000;
 
-  unsigned char rateBuf[4] = {0};
-  char *samplesBuf = nullptr;
+  zmq_msg_t topicMsg;
+  zmq_msg_t rateMsg;
+  zmq_pollitem_t pollItems[1];
 
+  QStringList subscriptions = topics;
   const std::string publisherUrl = publisher.toStdString();
-  const std::string topicName = topic.toStdString();
-  int topicNameSize = ::strlen(topicName.c_str());
+
+  ::zmq_msg_init(&topicMsg);
+  ::zmq_msg_init(&rateMsg);
 
   if (!running.loadAcquire())
     goto Exit;
 
-  samplesBuf = (char *)::malloc(bufSize * sizeof(char));
-  if (samplesBuf == nullptr) {
-    CRIT("Failed to allocate samples buffer for ZeroMQ");
+  if (topics.isEmpty() && topicPrefix.isEmpty()) {
+    CRIT("No valid topics provided");
     goto Exit;
   }
 
@@ -312,52 +333,136 @@ void Decoder::publisherConsumer() {
     goto Exit;
   }
 
-  DBG("Subscribing to ZMQ topic %s", topicName.c_str());
+  if (!topicPrefix.isEmpty()) {
+    subscriptions.append(topicPrefix);
+  }
 
-  status =
-      ::zmq_setsockopt(zmqSub, ZMQ_SUBSCRIBE, topicName.c_str(), topicNameSize);
-  if (status == -1) {
-    CRIT("Failed to subscribe to %s; error code = %d",
-         topic.toStdString().c_str(), zmq_errno());
-    goto Exit;
+  for (const auto &subscription : subscriptions) {
+    const std::string name = subscription.toStdString();
+
+    DBG("Subscribing to ZMQ topic %s", name.c_str());
+
+    status = ::zmq_setsockopt(zmqSub, ZMQ_SUBSCRIBE, name.c_str(), name.size());
+    if (status == -1) {
+      CRIT("Failed to subscribe to %s; error code = %d", name.c_str(),
+           zmq_errno());
+      goto Exit;
+    }
   }
 
+  pollItems[0].socket = zmqSub;
+  pollItems[0].fd = 0;
+  pollItems[0].events = ZMQ_POLLIN;
+  pollItems[0].revents = 0;
+
   DBG("Listening for samples...");
 
   while (running.loadAcquire()) {
-    while (((recvSize = ::zmq_recv(zmqSub, nullptr, 0, ZMQ_DONTWAIT)) < 0) &&
-           running.loadAcquire()) {
-      ::usleep(10000);
-    }
+    status = ::zmq_poll(pollItems, 1, MAX_POLL_WAIT_MS);
+    if (status < 0) {
+      if (zmq_errno() == EINTR)
+        continue;
 
-    if (!running.loadAcquire())
+      CRIT("Failed to poll ZeroMQ socket, error code = %d", zmq_errno());
       break;
+    }
 
-    recvSize = ::zmq_recv(zmqSub, rateBuf, sizeof(rateBuf), ZMQ_DONTWAIT);
-    if (recvSize != sizeof(rateBuf)) {
+    if (status == 0 || !(pollItems[0].revents & ZMQ_POLLIN))
       continue;
-    }
 
-    if (!running.loadAcquire())
-      break;
+    // drain everything that is queued before going back to poll
+    while (running.loadAcquire() && receiveFrame(&topicMsg, &rateMsg))
+      ;
+  }
 
-    ::memcpy(&sampleRate, rateBuf, sizeof(sampleRate));
+Exit:
+  ::zmq_msg_close(&topicMsg);
+  ::zmq_msg_close(&rateMsg);
 
-    recvSize = ::zmq_recv(zmqSub, samplesBuf, bufSize, ZMQ_DONTWAIT);
-    if (!running.loadAcquire())
-      break;
+  DBG("Waiting for forwarder consumer to get the hint to exit");
+  forwarderThread.waitForFinished();
 
-    if (recvSize >= 0) {
-      QByteArray qdata(samplesBuf, recvSize);
-      emit audioReceived(qdata, sampleRate);
-    }
+  DBG("Forwarder consumer exited");
+  emit completed();
+}
+
+void Decoder::fileConsumer() {
+  AudioFile audioFile;
+  Channel *channel = nullptr;
+  QElapsedTimer elapsed;
+  QByteArray samples(REPLAY_CHUNK_SAMPLES * sizeof(short), Qt::Uninitialized);
+
+  qint64 readSize = 0;
+  qint64 totalSamples = 0;
+  qint64 frames = 0;
+  quint32 sampleRate = 0;
+  double seconds = 0;
+
+  if (!running.loadAcquire())
+    goto Exit;
+
+  if (!audioFile.open(inputFile, inputSampleRate))
+    goto Exit;
+
+  sampleRate = audioFile.getSampleRate();
+
+  DBG("Replaying %s as %s at %u Hz", inputFile.toStdString().c_str(),
+      audioFile.isWav() ? "WAV" : "raw PCM", sampleRate);
+
+  // the channel stays on this thread and is fed directly, so replay runs as
+  // fast as the demodulator can go with DCD clocked by the samples
+  channel = new Channel(QFileInfo(inputFile).fileName(), bitRate, burstMode,
+                        disableReassembly, this);
+  channel->setCoarseEstimatePolicy(coarsePolicy);
+  channel->setHuntMode(huntMode);
+  channel->setSampleClock(true);
+
+  elapsed.start();
+
+  while (running.loadAcquire() &&
+         (readSize = audioFile.read(samples.data(), samples.size())) > 0) {
+    channel->processAudio(samples.constData(), readSize, sampleRate);
+    totalSamples += readSize / sizeof(short);
+  }
+
+  seconds = elapsed.nsecsElapsed() / 1e9;
+
+  DBG("Replay finished, waiting for forwarder consumer to drain sendBuffer");
+
+  // items are popped and numbered under forwarderMutex, so an empty ring
+  // means they have all been counted in nextDecodeSeq
+  forwarderMutex.lock();
+  while (running.loadAcquire() &&
+         (!sendBuffer.isEmpty() || nextForwardSeq < nextDecodeSeq)) {
+    forwarderMutex.unlock();
+    QThread::msleep(10);
+    forwarderMutex.lock();
+  }
+  forwarderMutex.unlock();
+  frames = sendBuffer.stats().pushed;
+
+  if (reportStats && seconds > 0 && sampleRate > 0) {
+    INF("Replayed %lld samples (%.1f s of audio) in %.3f s", totalSamples,
+        totalSamples / (double)sampleRate, seconds);
+    INF("%.0f samples/s (%.1fx real time), %lld messages decoded, %.2f "
+        "messages/s",
+        totalSamples / seconds, totalSamples / (double)sampleRate / seconds,
+        frames, frames / seconds);
+
+    DemodMetrics metrics = channel->getMetrics();
+    INF("Demodulator peak %.3f, EbNo %.1f dB, MSE %.3f, carrier %.1f Hz, %d "
+        "coarse estimates",
+        metrics.peak, metrics.ebno, metrics.mse, metrics.freq,
+        metrics.coarseEstimates);
   }
 
 Exit:
-  if (samplesBuf != nullptr) {
-    ::free(samplesBuf);
+  if (channel != nullptr) {
+    delete channel;
   }
 
+  running.storeRelease(0);
+
   DBG("Waiting for forwarder consumer to get the hint to exit");
   forwarderThread.waitForFinished();
 
@@ -366,98 +471,172 @@ Exit:
 }
 
 void Decoder::forwarderConsumer() {
-  for (auto target : forwarders) {
-    if (target != nullptr) {
-      target->reconnect();
+  const int maxInFlight = qMax(decodeThreads, 1) * DECODE_ITEMS_PER_THREAD;
+
+  forwardLoop.start(forwarders);
+
+  forwarderMutex.lock();
+  while (running.loadAcquire()) {
+    // keep the decode pool busy, oldest items first
+    ACARSItem queued;
+    while (nextDecodeSeq - nextForwardSeq < maxInFlight &&
+           sendBuffer.pop(queued)) {
+      submitDecode(queued, nextDecodeSeq++);
     }
+
+    // the next item in arrival order goes out as soon as it is decoded,
+    // anything decoded after it waits
+    auto next = decodedItems.find(nextForwardSeq);
+    if (next != decodedItems.end()) {
+      ACARSItem item = next.value();
+      decodedItems.erase(next);
+      forwarderMutex.unlock();
+
+      forwardItem(item);
+
+      forwarderMutex.lock();
+      nextForwardSeq++;
+      forwarderStats.forwarded++;
+      continue;
+    }
+
+    // with the decode pool full only a finished decode is worth waking for
+    const bool canSubmit = nextDecodeSeq - nextForwardSeq < maxInFlight;
+    forwarderMutex.unlock();
+
+    DBG("Nothing to forward, forwarder consumer waiting a second for the "
+        "next item or decode");
+    sendBuffer.waitConsumer(MAX_CONNECTION_WAIT_MS, canSubmit);
+
+    forwarderMutex.lock();
   }
+  forwarderMutex.unlock();
 
-  while (running.loadAcquire()) {
-    sendBufferRwLock.lockForRead();
-    if (sendBuffer.isEmpty()) {
-      DBG("No items in sendBuffer, forwarder consumer waiting a second for "
-          "next item add");
-      sendBufferCondition.wait(&sendBufferRwLock,
-                               QDeadlineTimer(MAX_CONNECTION_WAIT_MS));
-      if (!running.loadAcquire()) {
-        sendBufferRwLock.unlock();
-        break;
-      }
+  // producers blocked on a full ring would otherwise wait forever
+  sendBuffer.close();
 
-      if (sendBuffer.isEmpty()) {
-        DBG("Still nothing, trying for another wait");
-        sendBufferRwLock.unlock();
-        continue;
+  // decodes still running reference the decoder
+  decodePool.waitForDone();
+
+  // whatever the targets still have queued gets a moment to go out
+  forwardLoop.stop(MAX_CONNECTION_WAIT_MS);
+
+  logForwarderStats();
+}
+
+void Decoder::submitDecode(const ACARSItem &item, qint64 seq) {
+  QElapsedTimer queued;
+  queued.start();
+
+  // libacars keeps no state between decodes, so they can run side by side
+  decodePool.start([this, item, seq, queued]() {
+    ACARSItem decoded = item;
+    libacarsDecode(decoded);
+    const qint64 nsecs = queued.nsecsElapsed();
+
+    forwarderMutex.lock();
+    decodedItems.insert(seq, decoded);
+    forwarderStats.decodes++;
+    forwarderStats.decodeNsecs += nsecs;
+    forwarderStats.maxDecodeNsecs = qMax(forwarderStats.maxDecodeNsecs, nsecs);
+    forwarderMutex.unlock();
+
+    sendBuffer.wakeConsumer();
+  });
+}
+
+void Decoder::forwardItem(const ACARSItem &item) {
+  // each format is encoded once and every target using it queues the same
+  // bytes, so there are no conversions or copies per target
+  QByteArray lines[OUTPUT_FORMATS];
+
+  for (auto target : forwarders) {
+    if (target != nullptr) {
+      QByteArray &line = lines[target->getFormat()];
+      if (line.isNull()) {
+        line = toOutputFormat(target->getFormat(), stationId,
+                              disableReassembly, item);
+        if (line.isNull())
+          continue;
+        line += '\n';
       }
+
+      target->send(line);
     }
+  }
+}
 
-    DBG("sendBuffer is populated with %lld items for processing",
-        sendBuffer.size());
-
-    ACARSItem item = sendBuffer.front();
-    sendBuffer.pop_front();
-    sendBufferRwLock.unlock();
-
-    libacarsDecode(item);
-    
-    for (auto target : forwarders) {
-      if (target != nullptr) {
-        QString *out = toOutputFormat(target->getFormat(), stationId,
-                                      disableReassembly, item);
-        if (out != nullptr) {
-          *out += "\n";
-
-          target->send(out->toLatin1());
-          delete out;
-        }
-      }
+void Decoder::logForwarderStats() {
+  forwarderMutex.lock();
+  const ForwarderStats stats = forwarderStats;
+  const qint64 inFlight = nextDecodeSeq - nextForwardSeq;
+  forwarderMutex.unlock();
+
+  const MpscRingStats ring = sendBuffer.stats();
+
+  INF("Forwarded %lld messages, sendBuffer depth: %d of %d (max %d), "
+      "dropped %lld, spilled %lld, blocked %lld, in flight: %lld, decode "
+      "latency: %.2f ms avg, %.2f ms max",
+      stats.forwarded, ring.depth, sendBuffer.getCapacity(), ring.maxDepth,
+      ring.dropped, ring.spilled, ring.blocked, inFlight,
+      stats.decodes > 0 ? stats.decodeNsecs / 1e6 / stats.decodes : 0.0,
+      stats.maxDecodeNsecs / 1e6);
+
+  for (auto target : forwarders) {
+    if (target != nullptr) {
+      const ForwardStats fs = target->getStats();
+      INF("Target %s: sent %lld, dropped %lld, queued %d (max %d), %lld "
+          "connects, latency: %.2f ms avg, %.2f ms max",
+          target->getTarget().toString().toStdString().c_str(), fs.sent,
+          fs.dropped, fs.depth, fs.maxDepth, fs.connects,
+          fs.sent > 0 ? fs.latencyNsecs / 1e6 / fs.sent : 0.0,
+          fs.maxLatencyNsecs / 1e6);
     }
   }
 }
 
-void Decoder::handleNoSignalAfterFullScan() {
-  WARN("Scanned entire VFO bandwidth and could not find a signal.");
+void Decoder::handleNoSignalAfterFullScan(const QString &topic) {
+  WARN("Scanned entire VFO bandwidth of %s and could not find a signal.",
+       topic.toStdString().c_str());
 
   if (noSignalExit) {
-    WARN("Please confirm and verify that the specified topic is correct and "
+    QMutexLocker locker(&channelsMutex);
+    silentTopics.insert(topic);
+    if (silentTopics.size() < channels.size())
+      return;
+
+    WARN("Please confirm and verify that the specified topics are correct and "
          "that aero-publish is using correct settings")
     running.storeRelease(0);
     FATAL("Exiting because of no signal");
   }
 }
 
-void Decoder::handleDcdChange(bool old_state, bool new_state) {
-  if (new_state) {
-    DBG("Data carrier detected: no signal => signal");
-  } else {
-    DBG("Data carrier lost: signal => no signal");
-  }
-}
-
-void Decoder::handleNewFreqCenter(double freq_center) {
-  DBG("Trying frequency center %.1f in search of signal", freq_center);
+void Decoder::handleSignalFound(const QString &topic) {
+  // a VFO that has found its carrier since its last full scan isn't silent
+  QMutexLocker locker(&channelsMutex);
+  silentTopics.remove(topic);
 }
 
-void Decoder::handleACARS(ACARSItem &item) {
-  QString *output = toOutputFormat(format, stationId, disableReassembly, item);
-  if (output == nullptr) {
+void Decoder::processFrame(ACARSItem &item) {
+  const QByteArray output =
+      toOutputFormat(format, stationId, disableReassembly, item);
+  if (output.isNull()) {
     CRIT("Failed to generate output format!");
     return;
   }
 
-  INF("%s", output->toStdString().c_str());
-  delete output;
+  INF("%s", output.constData());
 
-  sendBufferRwLock.lockForWrite();
-  sendBuffer.push_back(item);
-  sendBufferCondition.wakeAll();
-  sendBufferRwLock.unlock();
+  // the caller keeps its item, the ring gets its own to move in
+  ACARSItem queued = item;
+  sendBuffer.push(std::move(queued));
 }
 
 void Decoder::handleHup() {
   DBG("Got SIGHUP signal from EventNotifier");
 
-  // TODO: do debug dump?
+  logForwarderStats();
 }
 
 void Decoder::handleInterrupt() {
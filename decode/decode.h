@@ -2,26 +2,59 @@
 #define DECODE_H
 
 #include "aerol.h"
+#include "channel.h"
 #include "forwarder.h"
-#include "hunter.h"
-#include "burstmskdemodulator.h"
-#include "burstoqpskdemodulator.h"
-#include "mskdemodulator.h"
-#include "oqpskdemodulator.h"
+#include "mpscring.h"
+#include "pipeline.h"
+#include "zmqframe.h"
 #include <QByteArray>
+#include <QHash>
 #include <QList>
+#include <QMutex>
 #include <QObject>
-#include <QReadWriteLock>
+#include <QSet>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
 #include <QUrl>
-#include <QWaitCondition>
 #include <QtConcurrent>
 
-class Decoder : public QObject {
+// Upper bound on how long the consumer sleeps in zmq_poll before checking if
+// it was asked to exit, samples wake it immediately
+const int MAX_POLL_WAIT_MS = 250;
+
+// Samples handed to the demodulator per read when replaying a file
+const int REPLAY_CHUNK_SAMPLES = 8192;
+
+// Threads running libacars on decoded messages before they are forwarded
+const int DEFAULT_DECODE_THREADS = 2;
+
+// Messages each decode thread may have in flight, the rest wait in sendBuffer
+const int DECODE_ITEMS_PER_THREAD = 4;
+
+// Messages sendBuffer holds before its overflow policy kicks in
+const int DEFAULT_SEND_BUFFER_ITEMS = 1024;
+
+// Largest sendBuffer --queue-size may ask for
+const int MAX_SEND_BUFFER_ITEMS = 1 << 20;
+
+// Forwarder path counters, guarded by forwarderMutex
+struct ForwarderStats {
+  qint64 forwarded;
+  qint64 decodes;
+  qint64 decodeNsecs; // from leaving sendBuffer to libacars being done
+  qint64 maxDecodeNsecs;
+
+  ForwarderStats()
+      : forwarded(0), decodes(0), decodeNsecs(0), maxDecodeNsecs(0) {}
+};
+
+class Decoder : public QObject, public FrameSink {
   Q_OBJECT
 
 public:
   Decoder(const QString &station_id, const QString &publisher,
-          const QString &topic, const QString &format, int bitRate,
+          const QStringList &topics, const QString &format, int bitRate,
           bool burstMode, const QString &rawForwarders, bool disableReassembly,
           QObject *parent = nullptr);
   Decoder(const Decoder &) = delete;
@@ -33,20 +66,60 @@ public:
   
   bool isRunning() const { return running; }
   void setNoSignalExit(bool noSignalExit) { this->noSignalExit = noSignalExit; }
+  void setWorkerThreads(int workerThreads) {
+    this->workerThreads = workerThreads;
+  }
+  void setDecodeThreads(int decodeThreads) {
+    this->decodeThreads = decodeThreads;
+  }
+  void setSendBuffer(int items, OverflowPolicy policy) {
+    sendBuffer.setCapacity(items);
+    sendBuffer.setPolicy(policy);
+  }
+  void setInputFile(const QString &path, quint32 sampleRate) {
+    this->inputFile = path;
+    this->inputSampleRate = sampleRate;
+  }
+  void setReportStats(bool reportStats) { this->reportStats = reportStats; }
+  void setCoarseEstimatePolicy(CoarseEstimatePolicy policy) {
+    this->coarsePolicy = policy;
+  }
+  void setHuntMode(HuntMode huntMode) { this->huntMode = huntMode; }
+
+  // Called directly on the channel threads, which all push to sendBuffer
+  // without locking
+  void processFrame(ACARSItem &item);
 
 private:
   bool parseForwarder(const QString &raw);
+  Channel *addChannel(const QString &name);
+  Channel *findChannel(const QString &name);
+  bool receiveFrame(zmq_msg_t *topicMsg, zmq_msg_t *rateMsg);
   void publisherConsumer();
+  void fileConsumer();
   void forwarderConsumer();
+  void submitDecode(const ACARSItem &item, qint64 seq);
+  void forwardItem(const ACARSItem &item);
+  void logForwarderStats();
 
   const QList<int> validBitRates = {600, 1200, 10500};
 
   QFuture<void> consumerThread;
   QFuture<void> forwarderThread;
 
-  QList<ACARSItem> sendBuffer;
-  QReadWriteLock sendBufferRwLock;
-  QWaitCondition sendBufferCondition;
+  // frames on their way from the channels to the forwarder consumer
+  MpscRing<ACARSItem> sendBuffer;
+
+  // libacars runs on decodePool. Items are numbered as they leave
+  // sendBuffer and, once decoded, wait in decodedItems until everything
+  // before them has been forwarded, so targets see them in arrival order.
+  // All of it is guarded by forwarderMutex
+  QMutex forwarderMutex;
+  QThreadPool decodePool;
+  QHash<qint64, ACARSItem> decodedItems;
+  qint64 nextDecodeSeq;
+  qint64 nextForwardSeq;
+  ForwarderStats forwarderStats;
   
   QAtomicInt running;
   
@@ -57,21 +130,33 @@ private:
   bool burstMode;
   bool disableReassembly;
   int bitRate;
+  int workerThreads;
+  int decodeThreads;
+  CoarseEstimatePolicy coarsePolicy;
+  HuntMode huntMode;
+
+  QString inputFile;
+  quint32 inputSampleRate;
+  bool reportStats;
 
   QString publisher;
   QString stationId;
-  QString topic;
+  QStringList topics;
+  QString topicPrefix;
   OutputFormat format;
 
   QList<ForwardTarget *> forwarders;
-  
-  AeroL *aerol;
-  BurstMskDemodulator *burstMskDemod;
-  BurstOqpskDemodulator *burstOqpskDemod;
-  MskDemodulator *mskDemod;
-  OqpskDemodulator *oqpskDemod;
-
-  SignalHunter *hunter;
+  // delivers to every target from its own thread, forwardItem only queues
+  ForwardLoop forwardLoop;
+
+  // channels are keyed by topic and spread round robin over the workers,
+  // the mutex guards both since prefix subscriptions add channels from the
+  // consumer thread. It also guards silentTopics, the channels whose last
+  // full scan found nothing and that haven't had DCD since
+  QMutex channelsMutex;
+  QHash<QString, Channel *> channels;
+  QList<QThread *> workers;
+  QSet<QString> silentTopics;
 
 public slots:
   void run();
@@ -80,14 +165,11 @@ public slots:
   void handleInterrupt();
   void handleTerminate();
 
-  void handleNoSignalAfterFullScan();
-  void handleNewFreqCenter(double freq_center);
-  void handleDcdChange(bool old_state, bool new_state);
-  void handleACARS(ACARSItem &item);
+  void handleNoSignalAfterFullScan(const QString &topic);
+  void handleSignalFound(const QString &topic);
 
 signals:
   void completed();
-  void audioReceived(const QByteArray &, quint32);
 };
 
 #endif
@@ -0,0 +1,249 @@
+#include "fftkernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FFTKERNEL_X86
+#elif defined(__ARM_NEON) && defined(AERO_DSP_FLOAT)
+#include <arm_neon.h>
+#define FFTKERNEL_NEON
+#endif
+
+// butterflies j to j + lanes of every 4h block. x1 and x3 are rotated by
+// W_2h^j and paired with x0 and x2, then the sums and differences are rotated
+// by W_4h^j and W_4h^(j+h) = -i W_4h^j and paired again
+void fftRadix4Scalar(fft_t *re, fft_t *im, int n, int h, const fft_t *w) {
+  const fft_t *w1r = w;
+  const fft_t *w1i = w + h;
+  const fft_t *w2r = w + 2 * h;
+  const fft_t *w2i = w + 3 * h;
+
+  for (int b = 0; b < n; b += 4 * h) {
+    fft_t *r0 = re + b, *r1 = r0 + h, *r2 = r1 + h, *r3 = r2 + h;
+    fft_t *i0 = im + b, *i1 = i0 + h, *i2 = i1 + h, *i3 = i2 + h;
+
+    for (int j = 0; j < h; j++) {
+      const fft_t ar = r1[j] * w1r[j] - i1[j] * w1i[j];
+      const fft_t ai = r1[j] * w1i[j] + i1[j] * w1r[j];
+      const fft_t br = r3[j] * w1r[j] - i3[j] * w1i[j];
+      const fft_t bi = r3[j] * w1i[j] + i3[j] * w1r[j];
+
+      const fft_t t0r = r0[j] + ar, t0i = i0[j] + ai;
+      const fft_t t1r = r0[j] - ar, t1i = i0[j] - ai;
+      const fft_t t2r = r2[j] + br, t2i = i2[j] + bi;
+      const fft_t t3r = r2[j] - br, t3i = i2[j] - bi;
+
+      const fft_t cr = t2r * w2r[j] - t2i * w2i[j];
+      const fft_t ci = t2r * w2i[j] + t2i * w2r[j];
+      const fft_t dr = t3r * w2r[j] - t3i * w2i[j];
+      const fft_t di = t3r * w2i[j] + t3i * w2r[j];
+
+      r0[j] = t0r + cr;
+      i0[j] = t0i + ci;
+      r2[j] = t0r - cr;
+      i2[j] = t0i - ci;
+      r1[j] = t1r + di;
+      i1[j] = t1i - dr;
+      r3[j] = t1r - di;
+      i3[j] = t1i + dr;
+    }
+  }
+}
+
+#ifdef FFTKERNEL_X86
+
+#ifdef AERO_DSP_FLOAT
+typedef __m128 fft_sse_t;
+typedef __m256 fft_avx_t;
+#define SSE_LANES 4
+#define AVX_LANES 8
+#define SSE_OP(op) _mm_##op##_ps
+#define AVX_OP(op) _mm256_##op##_ps
+#else
+typedef __m128d fft_sse_t;
+typedef __m256d fft_avx_t;
+#define SSE_LANES 2
+#define AVX_LANES 4
+#define SSE_OP(op) _mm_##op##_pd
+#define AVX_OP(op) _mm256_##op##_pd
+#endif
+
+__attribute__((target("sse2"))) static void
+fftRadix4SSE(fft_t *re, fft_t *im, int n, int h, const fft_t *w) {
+  if (h < SSE_LANES) {
+    fftRadix4Scalar(re, im, n, h, w);
+    return;
+  }
+
+  const fft_t *w1r = w;
+  const fft_t *w1i = w + h;
+  const fft_t *w2r = w + 2 * h;
+  const fft_t *w2i = w + 3 * h;
+
+  for (int b = 0; b < n; b += 4 * h) {
+    fft_t *r0 = re + b, *r1 = r0 + h, *r2 = r1 + h, *r3 = r2 + h;
+    fft_t *i0 = im + b, *i1 = i0 + h, *i2 = i1 + h, *i3 = i2 + h;
+
+    for (int j = 0; j < h; j += SSE_LANES) {
+      const fft_sse_t wr = SSE_OP(loadu)(w1r + j);
+      const fft_sse_t wi = SSE_OP(loadu)(w1i + j);
+      const fft_sse_t vr = SSE_OP(loadu)(w2r + j);
+      const fft_sse_t vi = SSE_OP(loadu)(w2i + j);
+
+      fft_sse_t x0r = SSE_OP(loadu)(r0 + j), x0i = SSE_OP(loadu)(i0 + j);
+      fft_sse_t x1r = SSE_OP(loadu)(r1 + j), x1i = SSE_OP(loadu)(i1 + j);
+      fft_sse_t x2r = SSE_OP(loadu)(r2 + j), x2i = SSE_OP(loadu)(i2 + j);
+      fft_sse_t x3r = SSE_OP(loadu)(r3 + j), x3i = SSE_OP(loadu)(i3 + j);
+
+      fft_sse_t ar = SSE_OP(sub)(SSE_OP(mul)(x1r, wr), SSE_OP(mul)(x1i, wi));
+      fft_sse_t ai = SSE_OP(add)(SSE_OP(mul)(x1r, wi), SSE_OP(mul)(x1i, wr));
+      fft_sse_t br = SSE_OP(sub)(SSE_OP(mul)(x3r, wr), SSE_OP(mul)(x3i, wi));
+      fft_sse_t bi = SSE_OP(add)(SSE_OP(mul)(x3r, wi), SSE_OP(mul)(x3i, wr));
+
+      fft_sse_t t0r = SSE_OP(add)(x0r, ar), t0i = SSE_OP(add)(x0i, ai);
+      fft_sse_t t1r = SSE_OP(sub)(x0r, ar), t1i = SSE_OP(sub)(x0i, ai);
+      fft_sse_t t2r = SSE_OP(add)(x2r, br), t2i = SSE_OP(add)(x2i, bi);
+      fft_sse_t t3r = SSE_OP(sub)(x2r, br), t3i = SSE_OP(sub)(x2i, bi);
+
+      fft_sse_t cr = SSE_OP(sub)(SSE_OP(mul)(t2r, vr), SSE_OP(mul)(t2i, vi));
+      fft_sse_t ci = SSE_OP(add)(SSE_OP(mul)(t2r, vi), SSE_OP(mul)(t2i, vr));
+      fft_sse_t dr = SSE_OP(sub)(SSE_OP(mul)(t3r, vr), SSE_OP(mul)(t3i, vi));
+      fft_sse_t di = SSE_OP(add)(SSE_OP(mul)(t3r, vi), SSE_OP(mul)(t3i, vr));
+
+      SSE_OP(storeu)(r0 + j, SSE_OP(add)(t0r, cr));
+      SSE_OP(storeu)(i0 + j, SSE_OP(add)(t0i, ci));
+      SSE_OP(storeu)(r2 + j, SSE_OP(sub)(t0r, cr));
+      SSE_OP(storeu)(i2 + j, SSE_OP(sub)(t0i, ci));
+      SSE_OP(storeu)(r1 + j, SSE_OP(add)(t1r, di));
+      SSE_OP(storeu)(i1 + j, SSE_OP(sub)(t1i, dr));
+      SSE_OP(storeu)(r3 + j, SSE_OP(sub)(t1r, di));
+      SSE_OP(storeu)(i3 + j, SSE_OP(add)(t1i, dr));
+    }
+  }
+}
+
+__attribute__((target("avx"))) static void
+fftRadix4AVX(fft_t *re, fft_t *im, int n, int h, const fft_t *w) {
+  if (h < AVX_LANES) {
+    fftRadix4SSE(re, im, n, h, w);
+    return;
+  }
+
+  const fft_t *w1r = w;
+  const fft_t *w1i = w + h;
+  const fft_t *w2r = w + 2 * h;
+  const fft_t *w2i = w + 3 * h;
+
+  for (int b = 0; b < n; b += 4 * h) {
+    fft_t *r0 = re + b, *r1 = r0 + h, *r2 = r1 + h, *r3 = r2 + h;
+    fft_t *i0 = im + b, *i1 = i0 + h, *i2 = i1 + h, *i3 = i2 + h;
+
+    for (int j = 0; j < h; j += AVX_LANES) {
+      const fft_avx_t wr = AVX_OP(loadu)(w1r + j);
+      const fft_avx_t wi = AVX_OP(loadu)(w1i + j);
+      const fft_avx_t vr = AVX_OP(loadu)(w2r + j);
+      const fft_avx_t vi = AVX_OP(loadu)(w2i + j);
+
+      fft_avx_t x0r = AVX_OP(loadu)(r0 + j), x0i = AVX_OP(loadu)(i0 + j);
+      fft_avx_t x1r = AVX_OP(loadu)(r1 + j), x1i = AVX_OP(loadu)(i1 + j);
+      fft_avx_t x2r = AVX_OP(loadu)(r2 + j), x2i = AVX_OP(loadu)(i2 + j);
+      fft_avx_t x3r = AVX_OP(loadu)(r3 + j), x3i = AVX_OP(loadu)(i3 + j);
+
+      fft_avx_t ar = AVX_OP(sub)(AVX_OP(mul)(x1r, wr), AVX_OP(mul)(x1i, wi));
+      fft_avx_t ai = AVX_OP(add)(AVX_OP(mul)(x1r, wi), AVX_OP(mul)(x1i, wr));
+      fft_avx_t br = AVX_OP(sub)(AVX_OP(mul)(x3r, wr), AVX_OP(mul)(x3i, wi));
+      fft_avx_t bi = AVX_OP(add)(AVX_OP(mul)(x3r, wi), AVX_OP(mul)(x3i, wr));
+
+      fft_avx_t t0r = AVX_OP(add)(x0r, ar), t0i = AVX_OP(add)(x0i, ai);
+      fft_avx_t t1r = AVX_OP(sub)(x0r, ar), t1i = AVX_OP(sub)(x0i, ai);
+      fft_avx_t t2r = AVX_OP(add)(x2r, br), t2i = AVX_OP(add)(x2i, bi);
+      fft_avx_t t3r = AVX_OP(sub)(x2r, br), t3i = AVX_OP(sub)(x2i, bi);
+
+      fft_avx_t cr = AVX_OP(sub)(AVX_OP(mul)(t2r, vr), AVX_OP(mul)(t2i, vi));
+      fft_avx_t ci = AVX_OP(add)(AVX_OP(mul)(t2r, vi), AVX_OP(mul)(t2i, vr));
+      fft_avx_t dr = AVX_OP(sub)(AVX_OP(mul)(t3r, vr), AVX_OP(mul)(t3i, vi));
+      fft_avx_t di = AVX_OP(add)(AVX_OP(mul)(t3r, vi), AVX_OP(mul)(t3i, vr));
+
+      AVX_OP(storeu)(r0 + j, AVX_OP(add)(t0r, cr));
+      AVX_OP(storeu)(i0 + j, AVX_OP(add)(t0i, ci));
+      AVX_OP(storeu)(r2 + j, AVX_OP(sub)(t0r, cr));
+      AVX_OP(storeu)(i2 + j, AVX_OP(sub)(t0i, ci));
+      AVX_OP(storeu)(r1 + j, AVX_OP(add)(t1r, di));
+      AVX_OP(storeu)(i1 + j, AVX_OP(sub)(t1i, dr));
+      AVX_OP(storeu)(r3 + j, AVX_OP(sub)(t1r, di));
+      AVX_OP(storeu)(i3 + j, AVX_OP(add)(t1i, dr));
+    }
+  }
+}
+
+#endif
+
+#ifdef FFTKERNEL_NEON
+
+static void fftRadix4NEON(float *re, float *im, int n, int h,
+                          const float *w) {
+  if (h < 4) {
+    fftRadix4Scalar(re, im, n, h, w);
+    return;
+  }
+
+  const float *w1r = w;
+  const float *w1i = w + h;
+  const float *w2r = w + 2 * h;
+  const float *w2i = w + 3 * h;
+
+  for (int b = 0; b < n; b += 4 * h) {
+    float *r0 = re + b, *r1 = r0 + h, *r2 = r1 + h, *r3 = r2 + h;
+    float *i0 = im + b, *i1 = i0 + h, *i2 = i1 + h, *i3 = i2 + h;
+
+    for (int j = 0; j < h; j += 4) {
+      const float32x4_t wr = vld1q_f32(w1r + j);
+      const float32x4_t wi = vld1q_f32(w1i + j);
+      const float32x4_t vr = vld1q_f32(w2r + j);
+      const float32x4_t vi = vld1q_f32(w2i + j);
+
+      float32x4_t x0r = vld1q_f32(r0 + j), x0i = vld1q_f32(i0 + j);
+      float32x4_t x1r = vld1q_f32(r1 + j), x1i = vld1q_f32(i1 + j);
+      float32x4_t x2r = vld1q_f32(r2 + j), x2i = vld1q_f32(i2 + j);
+      float32x4_t x3r = vld1q_f32(r3 + j), x3i = vld1q_f32(i3 + j);
+
+      float32x4_t ar = vmlsq_f32(vmulq_f32(x1r, wr), x1i, wi);
+      float32x4_t ai = vmlaq_f32(vmulq_f32(x1r, wi), x1i, wr);
+      float32x4_t br = vmlsq_f32(vmulq_f32(x3r, wr), x3i, wi);
+      float32x4_t bi = vmlaq_f32(vmulq_f32(x3r, wi), x3i, wr);
+
+      float32x4_t t0r = vaddq_f32(x0r, ar), t0i = vaddq_f32(x0i, ai);
+      float32x4_t t1r = vsubq_f32(x0r, ar), t1i = vsubq_f32(x0i, ai);
+      float32x4_t t2r = vaddq_f32(x2r, br), t2i = vaddq_f32(x2i, bi);
+      float32x4_t t3r = vsubq_f32(x2r, br), t3i = vsubq_f32(x2i, bi);
+
+      float32x4_t cr = vmlsq_f32(vmulq_f32(t2r, vr), t2i, vi);
+      float32x4_t ci = vmlaq_f32(vmulq_f32(t2r, vi), t2i, vr);
+      float32x4_t dr = vmlsq_f32(vmulq_f32(t3r, vr), t3i, vi);
+      float32x4_t di = vmlaq_f32(vmulq_f32(t3r, vi), t3i, vr);
+
+      vst1q_f32(r0 + j, vaddq_f32(t0r, cr));
+      vst1q_f32(i0 + j, vaddq_f32(t0i, ci));
+      vst1q_f32(r2 + j, vsubq_f32(t0r, cr));
+      vst1q_f32(i2 + j, vsubq_f32(t0i, ci));
+      vst1q_f32(r1 + j, vaddq_f32(t1r, di));
+      vst1q_f32(i1 + j, vsubq_f32(t1i, dr));
+      vst1q_f32(r3 + j, vsubq_f32(t1r, di));
+      vst1q_f32(i3 + j, vaddq_f32(t1i, dr));
+    }
+  }
+}
+
+#endif
+
+const KernelDispatch<FFTRadix4Kernel> &fftRadix4Kernels() {
+  static const KernelDispatch<FFTRadix4Kernel> kernels("FFT", {
+#if defined(FFTKERNEL_X86)
+    {CPU_AVX, fftRadix4AVX},
+    {CPU_SSE2, fftRadix4SSE},
+#elif defined(FFTKERNEL_NEON)
+    {CPU_NEON, fftRadix4NEON},
+#endif
+    {CPU_SCALAR, fftRadix4Scalar}
+  });
+  return kernels;
+}
@@ -0,0 +1,27 @@
+#ifndef FFTKERNEL_H
+#define FFTKERNEL_H
+
+#include "cpudispatch.h"
+
+// Scalar type the JFFT butterflies run in, single precision when built with
+// AERO_DSP_FLOAT so twice as many lanes fit in a SIMD register
+#ifdef AERO_DSP_FLOAT
+typedef float fft_t;
+#else
+typedef double fft_t;
+#endif
+
+// One radix-4 pass over bit reversed split complex data: the radix-2 stages of
+// span h and 2h fused, so each pass reads and writes the buffer once and
+// takes three complex multiplies per four points instead of four. w holds
+// W_2h^j then W_4h^j for j in [0, h), each as h real parts followed by h
+// imaginary parts.
+typedef void (*FFTRadix4Kernel)(fft_t *re, fft_t *im, int n, int h,
+                                const fft_t *w);
+
+// The radix-4 passes built for this CPU
+const KernelDispatch<FFTRadix4Kernel> &fftRadix4Kernels();
+
+void fftRadix4Scalar(fft_t *re, fft_t *im, int n, int h, const fft_t *w);
+
+#endif // FFTKERNEL_H
@@ -16,19 +16,22 @@ void FFTWrapper<T>::transform(const QVector<std::complex<T>> &in,
                               QVector<std::complex<T>> &out) {
   assert(in.size() == out.size());
   assert(in.size() == nfft);
-  for (int i = 0; i < in.size(); i++) {
-    out[i] = in[i];
-  }
+  if (&in != &out)
+    out = in;
+  transform(out);
+}
+
+template <class T>
+void FFTWrapper<T>::transform(QVector<std::complex<T>> &inout) {
+  assert(inout.size() == nfft);
   if (inverse) {
     // for inverse kiss fft doesn't match matlab ifft but the rest of JAERO
-    // expects the mucked up version of the inverse so we have to scale the iff
-    // to match what is expected
-    fft.ifft(out);
-    if (kissfft_scaling)
-      for (int i = 0; i < out.size(); i++)
-        out[i] *= (double)out.size();
+    // expects the mucked up version of the inverse so we have to skip the
+    // scaling to match what is expected
+    fft.fft(inout.data(), nfft,
+            kissfft_scaling ? JFFT::INVERSE_UNSCALED : JFFT::INVERSE);
   } else
-    fft.fft(out);
+    fft.fft(inout.data(), nfft);
 }
 
 template class FFTWrapper<double>;
@@ -12,6 +12,7 @@ public:
   ~FFTWrapper();
   void transform(const QVector<std::complex<T>> &in,
                  QVector<std::complex<T>> &out);
+  void transform(QVector<std::complex<T>> &inout);
 
 private:
   JFFT fft;
@@ -1,7 +1,12 @@
 #include "forwarder.h"
 #include "logger.h"
 #include <qt5/QtCore/qglobal.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <time.h>
 #include <unistd.h>
 
 OutputFormat parseOutputFormat(const QString &raw) {
@@ -17,122 +22,564 @@ OutputFormat parseOutputFormat(const QString &raw) {
   return OutputFormat::None;
 }
 
+static qint64 monotonicNsecs() {
+  timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
 ForwardTarget::ForwardTarget(const QUrl &url, OutputFormat fmt)
-    : QObject(nullptr), target(url), connfd(-1), servinfo(nullptr),
-      activeinfo(nullptr), format(fmt) {
+    : QObject(nullptr), target(url), format(fmt), socktype(0),
+      lookupWanted(false), lookupDone(false), lookupError(0),
+      lookupResult(nullptr), loop(nullptr),
+      state(Disconnected), connfd(-1), epfd(-1), watched(-1),
+      servinfo(nullptr), activeinfo(nullptr), nextinfo(nullptr), deadline(0),
+      backoffMs(FORWARD_BACKOFF_MIN_MS), blocked(false), writing(false),
+      offset(0) {
   scheme = url.scheme().toLower();
+  lookupHost = url.host().toUtf8();
+  lookupPort = QByteArray::number(url.port());
+  socktype = (scheme == "tcp") ? SOCK_STREAM : SOCK_DGRAM;
+  current.queuedAt = 0;
 }
 
 ForwardTarget::~ForwardTarget() {
+  closeSocket();
+
   if (servinfo != nullptr) {
     ::freeaddrinfo(servinfo);
     servinfo = nullptr;
-    activeinfo = nullptr;
   }
 
-  if (connfd != -1) {
-    ::close(connfd);
-    connfd = -1;
+  // a lookup that finished after the loop last looked
+  if (lookupResult != nullptr) {
+    ::freeaddrinfo(lookupResult);
+    lookupResult = nullptr;
   }
 }
 
-void ForwardTarget::reconnect() {
-  addrinfo hints = {0};
-  addrinfo *p = nullptr;
+void ForwardTarget::send(const QByteArray &data) {
+  bool wasEmpty;
+  {
+    QMutexLocker locker(&queueMutex);
+    if (queue.size() >= FORWARD_QUEUE_FRAMES) {
+      queue.dequeue();
+      stats.dropped++;
+    }
+
+    wasEmpty = queue.isEmpty();
+    queue.enqueue({data, monotonicNsecs()});
+    stats.queued++;
+    stats.maxDepth = qMax(stats.maxDepth, (int)queue.size());
+  }
+
+  // the loop takes everything queued whenever it looks, so only the first
+  // frame needs to wake it
+  if (wasEmpty && loop != nullptr) {
+    loop->wake();
+  }
+}
+
+ForwardStats ForwardTarget::getStats() const {
+  QMutexLocker locker(&queueMutex);
+  ForwardStats copy = stats;
+  copy.depth = queue.size();
+  return copy;
+}
+
+void ForwardTarget::connectStart() {
+  closeSocket();
+
+  // looked up on every round, the host may have moved while it was down.
+  // The loop carries on with the other targets until resolveDone has the
+  // answer.
+  state = Resolving;
+  loop->lookup(this);
+}
+
+void ForwardTarget::resolveDone(qint64 now) {
+  addrinfo *info;
+  int error;
+  {
+    QMutexLocker locker(&loop->lookupMutex);
+    if (!lookupDone) {
+      return;
+    }
+
+    lookupDone = false;
+    info = lookupResult;
+    error = lookupError;
+    lookupResult = nullptr;
+  }
+
+  if (error == 0) {
+    if (servinfo != nullptr) {
+      ::freeaddrinfo(servinfo);
+    }
+    servinfo = info;
+  } else if (servinfo == nullptr) {
+    DBG("Failed to resolve forwarder target %s: %s",
+        target.toString().toStdString().c_str(), ::gai_strerror(error));
+    retryLater(now);
+    return;
+  } else {
+    // a resolver that is down shouldn't take a collector that isn't with it
+    DBG("Failed to resolve forwarder target %s: %s, trying its last "
+        "addresses",
+        target.toString().toStdString().c_str(), ::gai_strerror(error));
+  }
+
+  nextinfo = servinfo;
+  connectNext(now);
+}
+
+void ForwardTarget::connectNext(qint64 now) {
+  closeSocket();
+
+  while (nextinfo != nullptr) {
+    addrinfo *p = nextinfo;
+    nextinfo = p->ai_next;
+
+    connfd = ::socket(p->ai_family, p->ai_socktype | SOCK_NONBLOCK,
+                      p->ai_protocol);
+    if (connfd == -1) {
+      continue;
+    }
+
+    activeinfo = p;
+
+    // datagrams have nothing to wait for
+    if (scheme != "tcp" || ::connect(connfd, p->ai_addr, p->ai_addrlen) == 0) {
+      connectDone(now);
+      return;
+    }
+
+    if (errno == EINPROGRESS) {
+      DBG("Connecting to forwarder target %s",
+          target.toString().toStdString().c_str());
+      state = Connecting;
+      deadline = now + FORWARD_CONNECT_TIMEOUT_MS * 1000000LL;
+      watch(EPOLLOUT);
+      return;
+    }
+
+    closeSocket();
+  }
 
-  DBG("Attempting to connect to forwarder target %s",
+  // every address failed
+  DBG("Failed to connect to forwarder target %s",
       target.toString().toStdString().c_str());
+  retryLater(now);
+}
 
-  if (servinfo != nullptr) {
-    ::freeaddrinfo(servinfo);
-    servinfo = nullptr;
-    activeinfo = nullptr;
+void ForwardTarget::connectDone(qint64 now) {
+  DBG("Connected to forwarder target %s",
+      target.toString().toStdString().c_str());
+
+  state = Connected;
+  backoffMs = FORWARD_BACKOFF_MIN_MS;
+  blocked = false;
+  nextinfo = nullptr;
+
+  {
+    QMutexLocker locker(&queueMutex);
+    stats.connects++;
   }
 
+  // a collector closing the connection shows up as readable
+  watch(scheme == "tcp" ? EPOLLIN | EPOLLRDHUP : 0);
+  if (!flush()) {
+    retryLater(now);
+  }
+}
+
+void ForwardTarget::closeSocket() {
   if (connfd != -1) {
+    // closing the socket also takes it out of the epoll set
     ::close(connfd);
     connfd = -1;
   }
 
-  ::memset(&hints, 0, sizeof(hints));
-  hints.ai_family = AF_INET;
-  hints.ai_socktype = (scheme == "tcp") ? SOCK_STREAM : SOCK_DGRAM;
+  watched = -1;
+  activeinfo = nullptr;
+  blocked = false;
+  state = Disconnected;
 
-  QString port = QString("%1").arg(target.port());
+  // a frame cut off on a stream is sent whole on the next connection
+  offset = 0;
+}
 
-  if (::getaddrinfo(target.host().toStdString().c_str(),
-                    port.toStdString().c_str(), &hints, &servinfo) != 0) {
-    goto Exit;
-  }
+void ForwardTarget::retryLater(qint64 now) {
+  closeSocket();
+  nextinfo = nullptr;
 
-  for (p = servinfo; p != nullptr; p = p->ai_next) {
-    connfd = ::socket(p->ai_family, p->ai_socktype, p->ai_protocol);
-    if (connfd == -1) {
-      continue;
+  DBG("Retrying forwarder target %s in %d ms",
+      target.toString().toStdString().c_str(), backoffMs);
+
+  deadline = now + backoffMs * 1000000LL;
+  backoffMs = qMin(backoffMs * 2, FORWARD_BACKOFF_MAX_MS);
+}
+
+bool ForwardTarget::flush() {
+  while (!blocked) {
+    if (!writing) {
+      QMutexLocker locker(&queueMutex);
+      if (queue.isEmpty()) {
+        break;
+      }
+
+      current = queue.dequeue();
+      writing = true;
+      offset = 0;
     }
 
+    const char *raw = current.data.constData();
+    const int size = current.data.size();
+
+    ssize_t bytesWritten;
     if (scheme == "tcp") {
-      if (::connect(connfd, p->ai_addr, p->ai_addrlen) == -1) {
-        ::close(connfd);
-        connfd = -1;
+      bytesWritten = ::send(connfd, raw + offset, size - offset, MSG_NOSIGNAL);
+    } else {
+      bytesWritten = ::sendto(connfd, raw, size, 0, activeinfo->ai_addr,
+                              activeinfo->ai_addrlen);
+    }
+
+    if (bytesWritten == -1) {
+      if (errno == EINTR) {
         continue;
       }
+
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        blocked = true;
+        break;
+      }
+
+      DBG("Failed to send frame to forwarder target %s: %s",
+          target.toString().toStdString().c_str(), ::strerror(errno));
+
+      // datagrams are best effort, a stream resends the frame on reconnect
+      if (scheme != "tcp") {
+        QMutexLocker locker(&queueMutex);
+        stats.dropped++;
+        writing = false;
+        current.data = QByteArray();
+      }
+      return false;
     }
 
-    activeinfo = p;
-    break;
+    offset += bytesWritten;
+    if (scheme == "tcp" && offset < size) {
+      continue;
+    }
+
+    const qint64 latency = monotonicNsecs() - current.queuedAt;
+    {
+      QMutexLocker locker(&queueMutex);
+      stats.sent++;
+      stats.latencyNsecs += latency;
+      stats.maxLatencyNsecs = qMax(stats.maxLatencyNsecs, latency);
+    }
+
+    writing = false;
+    current.data = QByteArray();
+    offset = 0;
   }
 
-Exit:
-  if (connfd == -1) {
-    DBG("Failed to connect to forwarder target");
-  } else {
-    DBG("Connected to forwarder target");
+  const uint32_t idle = (scheme == "tcp") ? EPOLLIN | EPOLLRDHUP : 0;
+  watch(blocked ? idle | EPOLLOUT : idle);
+  return true;
+}
+
+bool ForwardTarget::drainInput() {
+  char buf[512];
+
+  // collectors don't talk back, anything they send is thrown away
+  for (;;) {
+    ssize_t n = ::recv(connfd, buf, sizeof(buf), 0);
+    if (n > 0) {
+      continue;
+    }
+
+    if (n == 0) {
+      DBG("Forwarder target %s closed the connection",
+          target.toString().toStdString().c_str());
+      return false;
+    }
+
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
   }
 }
 
-int ForwardTarget::sendFrame(const QByteArray &data) {
-  const std::string buf = data.toStdString();
-  const char *raw = buf.c_str();
+void ForwardTarget::watch(uint32_t events) {
+  if (connfd == -1 || (int)events == watched) {
+    return;
+  }
+
+  epoll_event ev;
+  ::memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.ptr = this;
 
-  int bytesWritten = -1;
-  if (scheme == "tcp") {
-    bytesWritten = ::send(connfd, raw, ::strlen(raw), MSG_NOSIGNAL);
+  const int op = (watched == -1) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+  if (::epoll_ctl(epfd, op, connfd, &ev) == 0) {
+    watched = events;
   } else {
-    bytesWritten = ::sendto(connfd, raw, ::strlen(raw), 0, activeinfo->ai_addr,
-                            activeinfo->ai_addrlen);
+    WARN("Failed to watch forwarder target socket: %s", ::strerror(errno));
   }
+}
 
-  return bytesWritten;
+bool ForwardTarget::isIdle() {
+  QMutexLocker locker(&queueMutex);
+  return !writing && queue.isEmpty();
 }
 
-void ForwardTarget::send(const QByteArray &data) {
-  DBG("Attempting to send %lld bytes to forwarding target %s", data.size(),
-      target.toString().toStdString().c_str());
+ForwardLoop::ForwardLoop()
+    : thread(nullptr), lookupsStopped(false), stopAt(0), epfd(-1), wakefd(-1) {
+  running.storeRelease(0);
+}
+
+ForwardLoop::~ForwardLoop() { stop(0); }
 
-  if (connfd == -1) {
-    DBG("Invalid socket detected, attempting reconnect");
-    reconnect();
+void ForwardLoop::start(const QList<ForwardTarget *> &targets) {
+  epfd = ::epoll_create1(EPOLL_CLOEXEC);
+  wakefd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epfd == -1 || wakefd == -1) {
+    CRIT("Failed to set up the forwarder event loop: %s", ::strerror(errno));
+    return;
   }
 
-  int bytesWritten = sendFrame(data);
-  if (bytesWritten == -1) {
-    reconnect();
+  epoll_event ev;
+  ::memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = nullptr;
+  ::epoll_ctl(epfd, EPOLL_CTL_ADD, wakefd, &ev);
+
+  for (auto target : targets) {
+    if (target != nullptr) {
+      target->epfd = epfd;
+      target->loop = this;
+      this->targets.append(target);
+    }
+  }
 
-    if (connfd == -1) {
-      DBG("Failed attempt to reconnect to forwarding target during send()");
+  running.storeRelease(1);
+  for (auto target : this->targets) {
+    QThread *resolver = QThread::create([this, target] { resolve(target); });
+    resolver->start();
+    resolvers.append(resolver);
+  }
+  thread = QThread::create([this] { run(); });
+  thread->start();
+}
+
+void ForwardLoop::stop(int flushMs) {
+  if (thread != nullptr) {
+    stopAt = monotonicNsecs() + flushMs * 1000000LL;
+    running.storeRelease(0);
+    wake();
+
+    thread->wait();
+    delete thread;
+    thread = nullptr;
+  }
+
+  // a lookup already under way is waited for, it's bounded by the system
+  // resolver's own timeouts
+  {
+    QMutexLocker locker(&lookupMutex);
+    lookupsStopped = true;
+  }
+  lookupsWanted.wakeAll();
+
+  for (auto resolver : resolvers) {
+    resolver->wait();
+    delete resolver;
+  }
+  resolvers.clear();
+
+  for (auto target : targets) {
+    target->loop = nullptr;
+    target->closeSocket();
+  }
+  targets.clear();
+
+  if (wakefd != -1) {
+    ::close(wakefd);
+    wakefd = -1;
+  }
+
+  if (epfd != -1) {
+    ::close(epfd);
+    epfd = -1;
+  }
+}
+
+void ForwardLoop::wake() {
+  const uint64_t one = 1;
+  if (::write(wakefd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+    WARN("Failed to wake the forwarder event loop: %s", ::strerror(errno));
+  }
+}
+
+void ForwardLoop::lookup(ForwardTarget *target) {
+  {
+    QMutexLocker locker(&lookupMutex);
+    target->lookupWanted = true;
+  }
+  lookupsWanted.wakeAll();
+}
+
+void ForwardLoop::resolve(ForwardTarget *target) {
+  QMutexLocker locker(&lookupMutex);
+
+  for (;;) {
+    while (!target->lookupWanted && !lookupsStopped) {
+      lookupsWanted.wait(&lookupMutex);
+    }
+
+    if (lookupsStopped) {
       return;
     }
 
-    bytesWritten = sendFrame(data);
-    if (bytesWritten == -1) {
-      DBG("Failed again to send frame to forwarding target");
+    target->lookupWanted = false;
+    locker.unlock();
+
+    addrinfo hints;
+    ::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = target->socktype;
+    hints.ai_flags = AI_NUMERICSERV;
+
+    addrinfo *info = nullptr;
+    const int error =
+        ::getaddrinfo(target->lookupHost.constData(),
+                      target->lookupPort.constData(), &hints, &info);
+
+    locker.relock();
+    target->lookupDone = true;
+    target->lookupError = error;
+    target->lookupResult = (error == 0) ? info : nullptr;
+    wake();
+  }
+}
+
+void ForwardLoop::run() {
+  epoll_event events[16];
+  qint64 now = monotonicNsecs();
+
+  for (auto target : targets) {
+    target->connectStart();
+  }
+
+  for (;;) {
+    if (!running.loadAcquire()) {
+      bool idle = true;
+      for (auto target : targets) {
+        idle = idle && target->isIdle();
+      }
+
+      if (idle || now >= stopAt) {
+        break;
+      }
+    }
+
+    const int n = ::epoll_wait(epfd, events, 16, nextTimeout(now));
+    now = monotonicNsecs();
+
+    for (int i = 0; i < n; i++) {
+      if (events[i].data.ptr == nullptr) {
+        uint64_t count;
+        while (::read(wakefd, &count, sizeof(count)) > 0) {
+        }
+        continue;
+      }
+
+      service((ForwardTarget *)events[i].data.ptr, events[i].events, now);
+    }
+
+    // reconnects that are due, and frames queued since the last pass
+    for (auto target : targets) {
+      switch (target->state) {
+      case ForwardTarget::Disconnected:
+        if (now >= target->deadline) {
+          target->connectStart();
+        }
+        break;
+      case ForwardTarget::Resolving:
+        target->resolveDone(now);
+        break;
+      case ForwardTarget::Connecting:
+        if (now >= target->deadline) {
+          DBG("Timed out connecting to forwarder target %s",
+              target->target.toString().toStdString().c_str());
+          target->connectNext(now);
+        }
+        break;
+      case ForwardTarget::Connected:
+        if (!target->flush()) {
+          target->retryLater(now);
+        }
+        break;
+      }
     }
-  } else {
-    DBG("Sent %d to forwarding target", bytesWritten);
   }
 }
 
+void ForwardLoop::service(ForwardTarget *target, uint32_t events,
+                          qint64 now) {
+  if (target->state == ForwardTarget::Connecting) {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (::getsockopt(target->connfd, SOL_SOCKET, SO_ERROR, &error, &len) == -1) {
+      error = errno;
+    }
+
+    if (error != 0) {
+      // on to the host's next address, or a backoff if that was the last
+      target->connectNext(now);
+    } else {
+      target->connectDone(now);
+    }
+    return;
+  }
+
+  if (target->state != ForwardTarget::Connected) {
+    return;
+  }
+
+  if ((events & EPOLLIN) && !target->drainInput()) {
+    target->retryLater(now);
+    return;
+  }
+
+  if (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+    DBG("Lost connection to forwarder target %s",
+        target->target.toString().toStdString().c_str());
+    target->retryLater(now);
+    return;
+  }
+
+  if (events & EPOLLOUT) {
+    target->blocked = false;
+  }
+}
+
+int ForwardLoop::nextTimeout(qint64 now) const {
+  qint64 wait = running.loadAcquire() ? MAX_CONNECTION_WAIT_MS * 1000000LL
+                                      : stopAt - now;
+
+  for (auto target : targets) {
+    // a lookup finishing wakes the loop itself
+    if (target->state == ForwardTarget::Disconnected ||
+        target->state == ForwardTarget::Connecting) {
+      wait = qMin(wait, target->deadline - now);
+    }
+  }
+
+  // rounded up so the deadline has passed on waking
+  return (int)qMax((wait + 999999) / 1000000, (qint64)0);
+}
+
 ForwardTarget *ForwardTarget::fromRaw(const QString &raw) {
   if (raw.isEmpty()) {
     return nullptr;
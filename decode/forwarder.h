@@ -2,12 +2,50 @@
 #define FORWARDER_H
 
 #include <netdb.h>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
 #include <QObject>
+#include <QQueue>
+#include <QThread>
 #include <QUrl>
+#include <QWaitCondition>
+#include <stdint.h>
 
 const int MAX_CONNECTION_WAIT_MS = 1000;
 
+// Frames a target holds while its collector is slow or away, the oldest are
+// dropped to make room past this
+const int FORWARD_QUEUE_FRAMES = 4096;
+
+// Reconnect backoff doubles from the minimum up to the maximum, and is reset
+// once a connection is made
+const int FORWARD_BACKOFF_MIN_MS = 250;
+const int FORWARD_BACKOFF_MAX_MS = 30000;
+
+// A TCP connect that hasn't completed by then is given up on
+const int FORWARD_CONNECT_TIMEOUT_MS = 5000;
+
 enum OutputFormat { None, Text, Jaero, JsonDump };
+const int OUTPUT_FORMATS = JsonDump + 1;
+
+struct ForwardStats {
+  qint64 queued;
+  qint64 sent;
+  qint64 dropped; // pushed out of a full queue or failed as a datagram
+  qint64 connects;
+  qint64 latencyNsecs; // from being queued to being written to the socket
+  qint64 maxLatencyNsecs;
+  int depth;
+  int maxDepth;
+
+  ForwardStats()
+      : queued(0), sent(0), dropped(0), connects(0), latencyNsecs(0),
+        maxLatencyNsecs(0), depth(0), maxDepth(0) {}
+};
+
+class ForwardLoop;
 
 class ForwardTarget : public QObject {
   Q_OBJECT
@@ -21,23 +59,114 @@ public:
   ForwardTarget &operator=(const ForwardTarget &) = delete;
   ForwardTarget &operator=(ForwardTarget &&) noexcept = delete;
 
-  void reconnect();
+  // Queues a frame for the event loop and returns, it never waits on the
+  // network. The frame's buffer is shared, not copied.
   void send(const QByteArray &data);
 
   OutputFormat getFormat() const { return format; }
   const QUrl &getTarget() const { return target; }
-  
+  ForwardStats getStats() const;
+
   static ForwardTarget *fromRaw(const QString &raw);
 
 private:
-  int sendFrame(const QByteArray &data);
-  
+  friend class ForwardLoop;
+
+  enum State { Disconnected, Resolving, Connecting, Connected };
+
+  struct Frame {
+    QByteArray data;
+    qint64 queuedAt;
+  };
+
+  // the rest is only called from the event loop's thread
+  void connectStart();
+  void resolveDone(qint64 now);
+  void connectNext(qint64 now);
+  void connectDone(qint64 now);
+  void closeSocket();
+  void retryLater(qint64 now);
+  bool flush();
+  bool drainInput();
+  void watch(uint32_t events);
+  bool isIdle();
+
   QString scheme;
   QUrl target;
+  OutputFormat format;
+
+  // what the resolver thread looks up, fixed once constructed
+  QByteArray lookupHost;
+  QByteArray lookupPort;
+  int socktype;
+
+  // guarded by the loop's lookupMutex, lookupWanted is set by the loop and
+  // the rest filled in by the target's resolver thread
+  bool lookupWanted;
+  bool lookupDone;
+  int lookupError;
+  addrinfo *lookupResult;
+
+  // guards queue and stats, the only state shared with the senders
+  mutable QMutex queueMutex;
+  QQueue<Frame> queue;
+  ForwardStats stats;
+  ForwardLoop *loop;
+
+  State state;
   int connfd;
-  addrinfo *servinfo;
+  int epfd;
+  int watched; // events registered with epoll, -1 when not registered
+  addrinfo *servinfo; // the last addresses the host resolved to
   addrinfo *activeinfo;
-  OutputFormat format;
+  addrinfo *nextinfo;
+  qint64 deadline; // of the connect, or of the backoff when disconnected
+  int backoffMs;
+  bool blocked;    // waiting for the socket to take more
+  bool writing;    // current has been taken off the queue
+  Frame current;
+  int offset;      // bytes of current already on a stream socket
+};
+
+// One thread running every target's socket from a single epoll set, so a
+// target that is down, connecting or backed up never holds up the others.
+class ForwardLoop {
+public:
+  ForwardLoop();
+  ForwardLoop(const ForwardLoop &) = delete;
+  ~ForwardLoop();
+
+  ForwardLoop &operator=(const ForwardLoop &) = delete;
+
+  void start(const QList<ForwardTarget *> &targets);
+  // gives queued frames up to flushMs to go out, then stops the threads
+  void stop(int flushMs);
+  void wake();
+
+private:
+  friend class ForwardTarget;
+
+  void run();
+  void lookup(ForwardTarget *target);
+  void resolve(ForwardTarget *target);
+  void service(ForwardTarget *target, uint32_t events, qint64 now);
+  int nextTimeout(qint64 now) const;
+
+  QList<ForwardTarget *> targets;
+  QThread *thread;
+
+  // host lookups block, so each target has a thread of its own for them, a
+  // slow DNS server then only holds up the targets that wait on it. Results
+  // are handed back through wakefd.
+  QList<QThread *> resolvers;
+  QMutex lookupMutex;
+  QWaitCondition lookupsWanted;
+  bool lookupsStopped;
+
+  QAtomicInt running;
+  qint64 stopAt;
+  int epfd;
+  int wakefd;
 };
 
 OutputFormat parseOutputFormat(const QString &raw);
@@ -1,42 +1,184 @@
 #include "hunter.h"
 
+#include <algorithm>
+#include <cmath>
+
 SignalHunter::SignalHunter(quint32 maxTries, QObject *parent)
     : QObject(parent) {
   this->maxTries = maxTries;
   this->fullScans = 0;
   this->iterationsSinceSignal = 0;
+  this->scanStep = 0;
   this->lastDcd = false;
   this->enabled = true;
+  this->mode = HuntSpectrum;
+  this->minFreq = 0;
+  this->maxFreq = 0;
+  this->bandwidth = 0;
+
+  // hann window, the spectrum only has to separate carriers a few kHz apart
+  window.resize(HUNT_FFT_SIZE);
+  for (int i = 0; i < HUNT_FFT_SIZE; i++)
+    window[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / HUNT_FFT_SIZE);
+  frame.resize(HUNT_FFT_SIZE);
+  power.resize(HUNT_FFT_SIZE / 2 + 1);
+  resetSpectrum();
+
+  nextCandidate = 0;
 }
 
 SignalHunter::~SignalHunter() {}
 
+void SignalHunter::resetSpectrum() {
+  std::fill(power.begin(), power.end(), 0.0);
+  frameFill = 0;
+  framesAveraged = 0;
+}
+
 void SignalHunter::handleDcd(bool dcd) {
   if (dcd != lastDcd) {
     emit dcdChange(lastDcd, dcd);
     lastDcd = dcd;
+
+    // the carrier may have moved, rank from fresh audio and jump as soon as
+    // that is done
+    if (!dcd) {
+      resetSpectrum();
+      candidates.clear();
+      nextCandidate = 0;
+    }
   }  
 }
 
+void SignalHunter::processAudio(const short *samples, int count,
+                                quint32 sampleRate) {
+  if (!enabled || mode != HuntSpectrum || lastDcd || sampleRate == 0)
+    return;
+
+  for (int i = 0; i < count; i++) {
+    frame[frameFill] = window[frameFill] * (samples[i] / 32768.0);
+    if (++frameFill < HUNT_FFT_SIZE)
+      continue;
+    frameFill = 0;
+
+    fft.fft_real(frame, spectrum);
+    for (size_t k = 0; k < power.size(); k++)
+      power[k] += std::norm(spectrum[k]);
+    if (++framesAveraged < HUNT_AVERAGES)
+      continue;
+
+    rankCandidates(sampleRate);
+    resetSpectrum();
+
+    // first ranking since hunting started, go straight to the strongest
+    // rather than waiting out maxTries wherever the demodulator sits. the
+    // signal status is too noisy to trust without DCD
+    if (candidates.isEmpty() && !ranked.isEmpty()) {
+      candidates = ranked;
+      nextCandidate = 0;
+      iterationsSinceSignal = 0;
+      emit newFreqCenter(candidates[nextCandidate++]);
+    }
+  }
+}
+
+void SignalHunter::rankCandidates(quint32 sampleRate) {
+  const int bins = power.size();
+  const double hzPerBin = sampleRate / (double)HUNT_FFT_SIZE;
+
+  // power over half a bandwidth, the span the demodulator pulls a carrier in
+  // from, centred on every bin the scan could pick
+  const int half = std::max(1, (int)std::lround(bandwidth / 4.0 / hzPerBin));
+  const int first = std::max(half, (int)std::ceil(minFreq / hzPerBin));
+  const int last =
+      std::min(bins - 1 - half, (int)std::floor(maxFreq / hzPerBin));
+
+  ranked.clear();
+  if (last < first)
+    return;
+
+  std::vector<double> cumulative(bins + 1, 0.0);
+  for (int k = 0; k < bins; k++)
+    cumulative[k + 1] = cumulative[k] + power[k];
+
+  std::vector<std::pair<double, int>> band;
+  band.reserve(last - first + 1);
+  for (int k = first; k <= last; k++)
+    band.push_back(std::make_pair(
+        cumulative[k + half + 1] - cumulative[k - half], k));
+
+  // the median band is noise unless the VFO is mostly carrier
+  std::vector<std::pair<double, int>> sorted = band;
+  std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2,
+                   sorted.end());
+  const double threshold = sorted[sorted.size() / 2].first *
+                           std::pow(10.0, HUNT_MIN_SNR_DB / 10.0);
+
+  // only peaks, so the skirts of a wide carrier don't rank on their own
+  std::vector<std::pair<double, int>> peaks;
+  for (int i = 0; i < (int)band.size(); i++) {
+    bool peak = true;
+    for (int j = std::max(0, i - 2 * half);
+         peak && j <= std::min((int)band.size() - 1, i + 2 * half); j++)
+      peak = band[j].first <= band[i].first;
+    if (peak)
+      peaks.push_back(band[i]);
+  }
+  std::sort(peaks.rbegin(), peaks.rend());
+
+  // strongest first, skipping flat tops already taken
+  QVector<int> taken;
+  for (size_t i = 0; i < peaks.size(); i++) {
+    if (peaks[i].first <= threshold || taken.size() >= HUNT_MAX_CANDIDATES)
+      break;
+
+    bool shoulder = false;
+    for (int k : taken)
+      if (std::abs(k - peaks[i].second) <= 2 * half)
+        shoulder = true;
+    if (shoulder)
+      continue;
+
+    taken.append(peaks[i].second);
+    ranked.append(peaks[i].second * hzPerBin);
+  }
+}
+
+void SignalHunter::stepScan() {
+  scanStep++;
+
+  double new_freq_center = minFreq + (bandwidth >> 1) * scanStep;
+  if (new_freq_center > maxFreq - (bandwidth >> 1)) {
+    new_freq_center = 0.0;
+    iterationsSinceSignal = 0;
+    scanStep = 0;
+    fullScans++;
+
+    // the next round starts again from the latest ranking
+    candidates = ranked;
+    nextCandidate = 0;
+
+    emit noSignalAfterScan();
+  }
+
+  emit newFreqCenter(new_freq_center);
+}
+
 void SignalHunter::updatedSignalStatus(bool gotasignal) {
   if (!enabled) return;
   
   if (gotasignal) {
     iterationsSinceSignal = 0;
+    scanStep = 0;
+    nextCandidate = 0;
   } else {
     iterationsSinceSignal++;
 
     if (iterationsSinceSignal > 0 && iterationsSinceSignal % maxTries == 0) {
-      double new_freq_center = minFreq + (bandwidth >> 1) * (int)(iterationsSinceSignal / maxTries);
-      if (new_freq_center > maxFreq - (bandwidth >> 1)) {
-        new_freq_center = 0.0;
-        iterationsSinceSignal = 0;
-        fullScans++;
-
-        emit noSignalAfterScan();
-      }
-      
-      emit newFreqCenter(new_freq_center);
+      if (mode == HuntSpectrum && nextCandidate < candidates.size())
+        emit newFreqCenter(candidates[nextCandidate++]);
+      else
+        stepScan();
     }
   }
 }
@@ -1,7 +1,23 @@
 #ifndef HUNTER_H
 #define HUNTER_H
 
+#include "jfft.h"
 #include <QObject>
+#include <QVector>
+#include <vector>
+
+// Samples per spectrum frame and frames averaged per candidate ranking
+const int HUNT_FFT_SIZE = 4096;
+const int HUNT_AVERAGES = 8;
+
+// Candidates must stand this far above the median band power
+const double HUNT_MIN_SNR_DB = 3.0;
+const int HUNT_MAX_CANDIDATES = 8;
+
+// HuntStep walks the centre frequency across the VFO half a bandwidth at a
+// time. HuntSpectrum first tries the carriers ranked by an averaged spectrum
+// of the VFO audio, strongest first, and only then falls back to a step scan.
+enum HuntMode { HuntStep, HuntSpectrum };
 
 class SignalHunter : public QObject {
   Q_OBJECT
@@ -18,14 +34,26 @@ public:
     this->maxFreq = maxFreq;
     this->bandwidth = bandwidth;
   }
+  void setMode(HuntMode mode) { this->mode = mode; }
+
+  // The same samples the demodulator gets, only looked at while hunting
+  void processAudio(const short *samples, int count, quint32 sampleRate);
+
+  // Latest ranking in Hz, strongest first
+  const QVector<double> &getCandidates() const { return ranked; }
   
 public slots:
   void updatedSignalStatus(bool gotasignal);
   void handleDcd(bool dcd);
      
 private:
+  void resetSpectrum();
+  void rankCandidates(quint32 sampleRate);
+  void stepScan();
+
   bool enabled;
   bool lastDcd;
+  HuntMode mode;
   
   quint32 maxTries;
   quint32 fullScans;
@@ -35,6 +63,20 @@ private:
   quint32 bandwidth;
   
   quint32 iterationsSinceSignal;
+  quint32 scanStep;
+
+  // averaged power spectrum of the VFO
+  JFFT fft;
+  std::vector<double> window;
+  std::vector<double> frame;
+  std::vector<JFFT::cpx_type> spectrum;
+  std::vector<double> power;
+  int frameFill;
+  int framesAveraged;
+
+  QVector<double> ranked;
+  QVector<double> candidates; // the ranking being tried
+  int nextCandidate;
   
 signals:
   void newFreqCenter(double freq_center);
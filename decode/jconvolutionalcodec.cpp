@@ -13,6 +13,7 @@ JConvolutionalCodec::JConvolutionalCodec(QObject *parent) : QObject(parent) {
   convol = correct_convolutional_create(2, 7, poly);
   constraint = 7;
   nparitybits = 2;
+  aerocode = true;
 }
 
 void JConvolutionalCodec::SetCode(int inv_rate, int order,
@@ -24,6 +25,8 @@ void JConvolutionalCodec::SetCode(int inv_rate, int order,
   nparitybits = inv_rate;
   soft_bits_overlap_buffer_uchar.clear();
   paddinglength = _paddinglength;
+  aerocode = inv_rate == 2 && order == 7 && poly.size() == 2 &&
+             poly[0] == VITERBI_K7_POLY_A && poly[1] == VITERBI_K7_POLY_B;
 }
 
 JConvolutionalCodec::~JConvolutionalCodec() {
@@ -84,7 +87,7 @@ JConvolutionalCodec::Decode_hard(const QByteArray &soft_bits_in,
 
   return decoded_bits;
 }
-QVector<int> &
+PackedBits &
 JConvolutionalCodec::Decode_soft(QByteArray &soft_bits_in,
                                  int size) // 0-->-1 128-->0 255-->1
 {
@@ -94,28 +97,21 @@ JConvolutionalCodec::Decode_soft(QByteArray &soft_bits_in,
 
   // decode
   decoded.resize(size / nparitybits);
-  size_t dbits = correct_convolutional_decode_soft(
-      convol, (uchar *)soft_bits_overlap_buffer_uchar.data(), size,
-      (uchar *)decoded.data());
+  size_t dbits;
+  if (aerocode)
+    dbits = viterbi.decodeSoft((uchar *)soft_bits_overlap_buffer_uchar.data(),
+                               size, (uchar *)decoded.data());
+  else
+    dbits = correct_convolutional_decode_soft(
+        convol, (uchar *)soft_bits_overlap_buffer_uchar.data(), size,
+        (uchar *)decoded.data());
   assert(dbits > 0);
   dbits = size / nparitybits;
 
-  // unpack bytes
-  decoded_bits.resize(dbits);
-  int bit_ptr = 0;
-  for (int i = 0; i < decoded.size() && bit_ptr < ((int)dbits); i++) {
-    uchar uch = decoded[i];
-    for (int k = 0; k < 8; k++) {
-      if (uch & 128)
-        decoded_bits[bit_ptr] = 1;
-      else
-        decoded_bits[bit_ptr] = 0;
-      uch <<= 1;
-      bit_ptr++;
-    }
-  }
+  // repack LSB first
+  decoded_packed.setFromMSBFirst((const uchar *)decoded.constData(), 0, dbits);
 
-  return decoded_bits;
+  return decoded_packed;
 }
 
 QVector<int> &
@@ -143,7 +139,7 @@ JConvolutionalCodec::Hard_To_Soft_Convert(QByteArray &hard_bits_in) {
   return hard_bits_in;
 }
 
-QVector<int> &JConvolutionalCodec::Decode_Continuous(
+PackedBits &JConvolutionalCodec::Decode_Continuous(
     QByteArray &soft_bits_in) // 0-->-1 128-->0 255-->1
 {
   int k = 62; // polys.size()*(paddinglength+constraint_));
@@ -151,50 +147,35 @@ QVector<int> &JConvolutionalCodec::Decode_Continuous(
   soft_bits_overlap_buffer_uchar.append(soft_bits_in);
 
   // add some padding on the back
-  QByteArray filldata;
-  filldata.fill(128, paddinglength);
-  soft_bits_overlap_buffer_uchar.append(filldata);
+  soft_bits_overlap_buffer_uchar.append(paddinglength, char(128));
 
   // decode
-  double bt_size = soft_bits_overlap_buffer_uchar.size();
-  bt_size = (bt_size / nparitybits) / 8 + 1;
-
   decoded.resize((soft_bits_overlap_buffer_uchar.size() / nparitybits) + 1);
 
-  size_t dbits = correct_convolutional_decode_soft(
-      convol, (uchar *)soft_bits_overlap_buffer_uchar.data(),
-      soft_bits_overlap_buffer_uchar.size(), (uchar *)decoded.data());
+  size_t dbits;
+  if (aerocode)
+    dbits = viterbi.decodeSoft((uchar *)soft_bits_overlap_buffer_uchar.data(),
+                               soft_bits_overlap_buffer_uchar.size(),
+                               (uchar *)decoded.data());
+  else
+    dbits = correct_convolutional_decode_soft(
+        convol, (uchar *)soft_bits_overlap_buffer_uchar.data(),
+        soft_bits_overlap_buffer_uchar.size(), (uchar *)decoded.data());
   assert(dbits > 0);
 
   dbits = soft_bits_overlap_buffer_uchar.size() / nparitybits;
 
-  // unpack bytes
-  decoded_bits.resize(dbits);
-
-  int bit_ptr = 0;
-
-  for (int i = 0; i < decoded.size() && bit_ptr < ((int)dbits); i++) {
-    uchar uch = decoded[i];
-
-    for (int k = 0; k < 8 && bit_ptr < ((int)dbits); k++) {
-      if (uch & 128)
-        decoded_bits[bit_ptr] = 1;
-      else
-        decoded_bits[bit_ptr] = 0;
-      uch <<= 1;
-      bit_ptr++;
-    }
-  }
-
-  // remove the padding bits from the return data
-  decoded_bits =
-      decoded_bits.mid(paddinglength + 1, soft_bits_in.size() / nparitybits);
+  // remove the padding bits from the return data and repack LSB first
+  int from = paddinglength + 1;
+  int nbits = qMin((int)soft_bits_in.size() / nparitybits, (int)dbits - from);
+  decoded_packed.setFromMSBFirst((const uchar *)decoded.constData(), from,
+                                 qMax(nbits, 0));
 
   // remove the used data from the padding buffer
   soft_bits_overlap_buffer_uchar = soft_bits_in.right(k);
   soft_bits_overlap_buffer_uchar.resize(k);
 
-  return decoded_bits;
+  return decoded_packed;
 }
 
 // unpack the re-encoded bytes
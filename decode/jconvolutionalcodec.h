@@ -12,6 +12,9 @@ extern "C" {
 
 #include <QVector>
 
+#include "packedbits.h"
+#include "viterbikernel.h"
+
 #include <QObject>
 
 class JConvolutionalCodec : public QObject {
@@ -21,12 +24,12 @@ public:
   ~JConvolutionalCodec();
   void SetCode(int inv_rate, int order, const QVector<quint16> poly,
                int paddinglength = 24 * 4);
-  QVector<int> &
+  PackedBits &
   Decode_Continuous(QByteArray &soft_bits_in); // 0-->-1 128-->0 255-->1
   QVector<int> &Decode_Continuous_hard(const QByteArray &soft_bits_in); // 0-->1
 
-  QVector<int> &Decode_soft(QByteArray &soft_bits_in,
-                            int size); // 0-->-1 128-->0 255-->1
+  PackedBits &Decode_soft(QByteArray &soft_bits_in,
+                          int size); // 0-->-1 128-->0 255-->1
   QVector<int> &Decode_hard(const QByteArray &soft_bits_in, int size); // 0-->1
 
   QVector<int> &Soft_To_Hard_Convert(
@@ -42,12 +45,15 @@ signals:
 public slots:
 private:
   correct_convolutional *convol;
+  ViterbiK7 viterbi; // in tree decoder for the Aero code
+  bool aerocode;
   int constraint;
   int nparitybits;
   int paddinglength;
   QByteArray soft_bits_overlap_buffer_uchar;
   QVector<int> decoded_bits; // unpacked
-  QByteArray decoded;        // packed tempory storage
+  PackedBits decoded_packed; // packed LSB first
+  QByteArray decoded;        // packed MSB first tempory storage
 };
 
 #endif // JCONVOLUTIONALCODEC_H
@@ -1,6 +1,9 @@
 #include "jfft.h"
 
 #include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -10,22 +13,20 @@
 
 JFFT::JFFT() {}
 
-void JFFT::init(int &fft_size) {
+std::shared_ptr<const JFFT::Plan> JFFT::getPlan(int nfft) {
+  static std::mutex mutex;
+  static std::map<int, std::shared_ptr<const Plan>> plans;
 
-  // use a bigger FFT size if its not a power of 2
-  nfft = 1;
-  nfft_2power = 0;
-  while (nfft < fft_size) {
-    nfft <<= 1;
-    nfft_2power++;
-  }
-  fft_size = nfft;
-  // qDebug()<<nfft<<nfft_2power;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::map<int, std::shared_ptr<const Plan>>::iterator it = plans.find(nfft);
+  if (it != plans.end())
+    return it->second;
 
-  // alocate mem
-  TWIDDLE_mem.resize(nfft); // this is more memory than we need. what is the
-                            // exact amount we need?
-  TWIDDLE_INV_mem.resize(nfft);
+  std::shared_ptr<Plan> plan = std::make_shared<Plan>();
+  plan->nfft = nfft;
+  plan->nfft_2power = 0;
+  while ((1 << plan->nfft_2power) < nfft)
+    plan->nfft_2power++;
 
   // load twiddles (these are just roots of unity, like cutting a cake)
   // looking at
@@ -35,35 +36,105 @@ void JFFT::init(int &fft_size) {
   // many piecies N) and the top number increases till not quite half way around
   // the cake (ie less than N/2)
   cpx_type imag = cpx_type(0, 1);
-  cpx_type *TWIDDLE = TWIDDLE_mem.data();
-  cpx_type *TWIDDLE_INV = TWIDDLE_INV_mem.data();
+  plan->TWIDDLE.resize(nfft);
+  plan->TWIDDLE_INV.resize(nfft);
   int w = 0;
   for (int N = 2; N <= nfft; N <<= 1) {
     for (int i = 0; i < N / 2; i++) {
-      cpx_type twiddle =
+      assert(w < nfft);
+      plan->TWIDDLE[w] =
           std::exp(-2.0 * imag * M_PI * ((double)i) / ((double)N));
-      cpx_type twiddle_inv =
+      plan->TWIDDLE_INV[w] =
           std::exp(2.0 * imag * M_PI * ((double)i) / ((double)N));
-      assert(w < nfft);
-      TWIDDLE[w] = twiddle;
-      TWIDDLE_INV[w] = twiddle_inv;
       w++;
-      // qDebug()<<i<<N<<twiddle.real()<<twiddle.imag();
     }
   }
 
   // load diddle factors
   // these are the factors for real transforms
-  DIDDLE_A.resize(nfft);
-  DIDDLE_B.resize(nfft);
+  plan->DIDDLE_A.resize(nfft);
+  plan->DIDDLE_B.resize(nfft);
   for (int i = 0; i < nfft; i++) {
-    DIDDLE_A[i] =
+    plan->DIDDLE_A[i] =
         0.5 * (1.0 - imag * std::exp(-2.0 * imag * M_PI * ((double)i) /
                                      ((double)(2 * nfft))));
-    DIDDLE_B[i] =
+    plan->DIDDLE_B[i] =
         0.5 * (1.0 + imag * std::exp(-2.0 * imag * M_PI * ((double)i) /
                                      ((double)(2 * nfft))));
   }
+
+  /*
+   bit reversal indices. fast (lets say 2x as fast as the slow one)
+   this does the bit reversal in an iterative way.
+    This is a bit hard to draw in ascii art
+      1 2 3 4
+       X   X
+      2 1 4 3
+       \ X /
+        X X
+        / X \
+       4 3 2 1
+
+    or maybe this is a better to describe the process
+
+     1 2   3 4   5 6   7 8
+      X     X     X     X
+     2 1   4 3   6 5   8 7
+
+     21 43   65 87
+       X       X
+     43 21   87 65
+
+     4321 8765
+         X
+     8765 4321
+  */
+  plan->bitrev.resize(nfft);
+  for (uint32_t i = 0; i < ((uint32_t)nfft); ++i) {
+    uint32_t y = i;
+    y = (((y & 0xaaaaaaaa) >> 1) | ((y & 0x55555555) << 1));
+    y = (((y & 0xcccccccc) >> 2) | ((y & 0x33333333) << 2));
+    y = (((y & 0xf0f0f0f0) >> 4) | ((y & 0x0f0f0f0f) << 4));
+    y = (((y & 0xff00ff00) >> 8) | ((y & 0x00ff00ff) << 8));
+    y = ((y >> 16) | (y << 16));
+    plan->bitrev[i] = plan->nfft_2power ? y >> (32 - plan->nfft_2power) : 0;
+  }
+
+  // radix-4 pass twiddles, W_2h^j then W_4h^j for each pass in the order
+  // fft() runs them
+  int h = (plan->nfft_2power & 1) ? 2 : 1;
+  for (; 4 * h <= nfft; h *= 4) {
+    const size_t base = plan->radix4.size();
+    plan->radix4.resize(base + 4 * h);
+    fft_t *p = plan->radix4.data() + base;
+    for (int j = 0; j < h; j++) {
+      const double a = -2.0 * M_PI * ((double)j) / ((double)(2 * h));
+      p[j] = std::cos(a);
+      p[h + j] = std::sin(a);
+      p[2 * h + j] = std::cos(a / 2.0);
+      p[3 * h + j] = std::sin(a / 2.0);
+    }
+  }
+
+  plans[nfft] = plan;
+  return plan;
+}
+
+void JFFT::init(int &fft_size) {
+
+  // use a bigger FFT size if its not a power of 2
+  nfft = 1;
+  nfft_2power = 0;
+  while (nfft < fft_size) {
+    nfft <<= 1;
+    nfft_2power++;
+  }
+  fft_size = nfft;
+
+  plan = getPlan(nfft);
+  re.resize(nfft);
+  im.resize(nfft);
+  kernel = fftRadix4Kernels().best();
 }
 
 // the size of the sets should be 2 times the size of the fft
@@ -81,6 +152,8 @@ void JFFT::fft_real(const double *real, cpx_type *complex, int size) {
   fft(F.data(), nfft);
 
   // do the diddling
+  const std::vector<cpx_type> &DIDDLE_A = plan->DIDDLE_A;
+  const std::vector<cpx_type> &DIDDLE_B = plan->DIDDLE_B;
   complex[0] = F[0] * DIDDLE_A[0] + DIDDLE_B[0] * std::conj(F[0]);
   complex[nfft] = F[0] * DIDDLE_B[0] + DIDDLE_A[0] * std::conj(F[0]);
   for (int i = 1; i < nfft; ++i) {
@@ -96,6 +169,8 @@ void JFFT::ifft_real(const cpx_type *complex, double *real, int size) {
   F.resize(nfft);
 
   // do the diddling
+  const std::vector<cpx_type> &DIDDLE_A = plan->DIDDLE_A;
+  const std::vector<cpx_type> &DIDDLE_B = plan->DIDDLE_B;
   for (int i = 0; i < nfft; ++i) {
     F[i] = complex[i] * std::conj(DIDDLE_A[i]) +
            std::conj(DIDDLE_B[i]) * std::conj(complex[(nfft - i)]);
@@ -113,113 +188,61 @@ void JFFT::ifft_real(const cpx_type *complex, double *real, int size) {
 
 void JFFT::fft(cpx_type *x, int size, fft_direction_t fft_direction) {
   assert(size == nfft);
-  cpx_type *TWIDDLE;
-  if (fft_direction == FORWARD)
-    TWIDDLE = TWIDDLE_mem.data();
-  else
-    TWIDDLE = TWIDDLE_INV_mem.data();
+  const uint32_t *bitrev = plan->bitrev.data();
+  fft_t *xr = re.data();
+  fft_t *xi = im.data();
 
-  /*
-   for the ifft an alternitive tick is given at
-   http://www.embedded.com/design/configurable-systems/4210789/DSP-Tricks--Computing-inverse-FFTs-using-the-forward-FFT
-   it would mean taking the conjugate of x before the forward fft is done then
-   taking the conjugate after the fft is done this would be a good idea for
-   memory limited devices
-
-   bit reversal. fast (lets say 2x as fast as the slow one)
-   this does the bit reversal in an iterative way.
-    This is a bit hard to draw in ascii art
-      1 2 3 4  
-       X   X     
-      2 1 4 3  
-       \ X /   
-        X X    
-        / X \  
-       4 3 2 1 
-  
-    or maybe this is a better to describe the process
-  
-     1 2   3 4   5 6   7 8
-      X     X     X     X
-     2 1   4 3   6 5   8 7
-  
-     21 43   65 87
-       X       X
-     43 21   87 65
-  
-     4321 8765
-         X
-     8765 4321
-  */
-  for (uint32_t i = 0; i < ((uint32_t)nfft); ++i) {
-
-    uint32_t y = i;
-    y = (((y & 0xaaaaaaaa) >> 1) | ((y & 0x55555555) << 1));
-    y = (((y & 0xcccccccc) >> 2) | ((y & 0x33333333) << 2));
-    y = (((y & 0xf0f0f0f0) >> 4) | ((y & 0x0f0f0f0f) << 4));
-    y = (((y & 0xff00ff00) >> 8) | ((y & 0x00ff00ff) << 8));
-    y = ((y >> 16) | (y << 16)) >> (32 - nfft_2power);
+  // for the ifft the trick at
+  // http://www.embedded.com/design/configurable-systems/4210789/DSP-Tricks--Computing-inverse-FFTs-using-the-forward-FFT
+  // is used. conjugate on the way in, forward fft, conjugate on the way out.
+  // bit reversal is done while splitting x into real and imaginary parts
+  const fft_t conj = (fft_direction == FORWARD) ? 1 : -1;
+  for (int i = 0; i < nfft; ++i) {
+    const cpx_type &v = x[bitrev[i]];
+    xr[i] = v.real();
+    xi[i] = conj * v.imag();
+  }
 
-    if (y > i) {
-      swap(x[i], x[y]);
-      // qDebug()<<y<<i;
+  // an odd number of radix-2 stages leaves one over, do it first as its
+  // twiddles are all 1
+  int h = 1;
+  if (nfft_2power & 1) {
+    for (int k = 0; k < nfft; k += 2) {
+      const fft_t r = xr[k + 1];
+      const fft_t i = xi[k + 1];
+      xr[k + 1] = xr[k] - r;
+      xi[k + 1] = xi[k] - i;
+      xr[k] += r;
+      xi[k] += i;
     }
+    h = 2;
   }
 
-  // fft. using pointers harder to understand but is identical to the one in
-  // fft_easy_to_understand
-  int nfill = 0;
-  cpx_type y;
-  cpx_type *xkp;
-  cpx_type *xlp;
-  cpx_type *wp;
-  for (int n = 1; n < nfft; n <<= 1) // run through each stage
-  {
-    int k = 0;
-    wp = TWIDDLE + n - 1;
-    xkp = x;
-    xlp = x + k + n;
-    while (k < nfft) {
-
-      // buterfly
-      y = (*wp) * (*xlp);
-      (*xlp) = (*xkp) - y;
-      (*xkp) += y;
-
-      // find next pointers for the buterfly
-      xkp++;
-      xlp++;
-      k++;
-      if (k & nfill)
-        wp++;
-      else {
-        k += n;
-        xkp += n;
-        xlp += n;
-        wp = TWIDDLE + n - 1;
-      }
-    }
-    nfill <<= 1;
-    nfill |= 1;
+  // the rest two stages at a time
+  const fft_t *w = plan->radix4.data();
+  for (; 4 * h <= nfft; h *= 4) {
+    kernel(xr, xi, nfft, h, w);
+    w += 4 * h;
   }
 
   // scale if we are doing an inverse
   // this only scalling on the ifft matchs what MATLAB does
-  if (fft_direction == INVERSE) {
-    for (int i = 0; i < nfft; ++i)
-      x[i] *= (1.0 / ((double)nfft));
-  }
+  double scale = 1.0;
+  if (fft_direction == INVERSE)
+    scale = 1.0 / ((double)nfft);
+  for (int i = 0; i < nfft; ++i)
+    x[i] = cpx_type(scale * xr[i], conj * scale * xi[i]);
 }
 
 // this is eaiser to understand
 void JFFT::fft_easy_to_understand(cpx_type *x, int size,
                                   fft_direction_t fft_direction) {
   assert(size == nfft);
-  cpx_type *TWIDDLE;
+  const cpx_type *TWIDDLE;
   if (fft_direction == FORWARD)
-    TWIDDLE = TWIDDLE_mem.data();
+    TWIDDLE = plan->TWIDDLE.data();
   else
-    TWIDDLE = TWIDDLE_INV_mem.data();
+    TWIDDLE = plan->TWIDDLE_INV.data();
 
   // for the ifft an alternitive tick is given at
   // http://www.embedded.com/design/configurable-systems/4210789/DSP-Tricks--Computing-inverse-FFTs-using-the-forward-FFT
@@ -4,8 +4,13 @@
 #include <assert.h>
 #include <cmath>
 #include <complex>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
+#include "fftkernel.h"
+
+
 #ifdef QT_CORE_LIB
 #include <QDebug>
 #include <QVector>
@@ -16,13 +21,35 @@
 // transform took 1.2ms for my FFT and 3.4s for my SFT. Thats about 3000 times
 // faster We also have real 1 dimentional non in place FFT/IFFT that are about
 // twice as fast as the complex ones
+// fft() runs fused radix-4 passes on split real/imaginary copies through the
+// SIMD kernels in fftkernel.h. Twiddles and bit reversal indices come from a
+// plan built once per size and shared by every JFFT of that size.
 class JFFT {
 public:
   typedef std::complex<double>
       cpx_type; // this is the complex number definition. people really should
                 // use complex numbers more they are much better than real
                 // numbers
-  typedef enum fft_direction_t { FORWARD, INVERSE } fft_direction_t;
+  // INVERSE_UNSCALED skips the 1/N so it matches what kissfft returns
+  typedef enum fft_direction_t {
+    FORWARD,
+    INVERSE,
+    INVERSE_UNSCALED
+  } fft_direction_t;
+
+  // tables for one size, both directions. read only once built
+  struct Plan {
+    int nfft;
+    int nfft_2power;
+    std::vector<cpx_type> TWIDDLE;
+    std::vector<cpx_type> TWIDDLE_INV;
+    std::vector<cpx_type> DIDDLE_A;
+    std::vector<cpx_type> DIDDLE_B;
+    std::vector<uint32_t> bitrev;
+    std::vector<fft_t> radix4; // per pass 4h twiddles, see fftkernel.h
+  };
+  static std::shared_ptr<const Plan> getPlan(int nfft);
+
   JFFT();
   void init(int &fft_size);
 
@@ -153,11 +180,11 @@ private:
   int nfft = 0;
 
   // memory
-  std::vector<cpx_type> DIDDLE_A;
-  std::vector<cpx_type> DIDDLE_B;
-  std::vector<cpx_type> TWIDDLE_mem;
-  std::vector<cpx_type> TWIDDLE_INV_mem;
+  std::shared_ptr<const Plan> plan;
+  std::vector<fft_t> re; // split working copy for fft()
+  std::vector<fft_t> im;
   std::vector<cpx_type> F; // used if the slow DFT is done or real FFT/iFFT
+  FFTRadix4Kernel kernel = nullptr;
 
   void inline swap(cpx_type &a, cpx_type &b) {
     cpx_type c_tmp = b;
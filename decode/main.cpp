@@ -3,6 +3,7 @@
 #include <QCoreApplication>
 #include <QHostInfo>
 #include <QList>
+#include <QThread>
 #include <QTimer>
 
 #include "decode.h"
@@ -27,14 +28,23 @@ int main(int argc, char *argv[]) {
       "Forward decoded ACARS messages to a list of servers and formats, see "
       "--format for allowable formats; example: FORMAT1=URL1,FORMAT2=URL2,...",
       "fwd"));
+  parser.addOption(QCommandLineOption(
+      QStringList() << "i" << "input",
+      "Replay a mono 16-bit PCM recording, raw or WAV, as fast as possible "
+      "instead of subscribing to a publisher",
+      "input"));
   parser.addOption(QCommandLineOption(
       QStringList() << "p" << "publisher",
       "URL of aero-publish or SDRReceiver publishing ZeroMQ server",
       "publisher"));
   parser.addOption(QCommandLineOption(QStringList() << "s" << "station-id",
                                       "Station ID for feeding", "station-id"));
-  parser.addOption(QCommandLineOption(QStringList() << "t" << "topic",
-                                      "ZeroMQ VFO topic name", "topic"));
+  parser.addOption(QCommandLineOption(
+      QStringList() << "t" << "topic",
+      "ZeroMQ VFO topic name, or a comma separated list of them; a trailing * "
+      "decodes every VFO starting with that prefix, example: VFO51,VFO52 or "
+      "VFO*",
+      "topic"));
   parser.addOption(QCommandLineOption(QStringList() << "v" << "verbose",
                                       "Show verbose output"));
   parser.addOption(QCommandLineOption("burst", "Enable burst mode (C-band)"));
@@ -45,28 +55,74 @@ int main(int argc, char *argv[]) {
                          "ACARS format type to display on console; valid: "
                          "jaero, jsondump, text (default)",
                          "format"));
+  parser.addOption(QCommandLineOption(
+      "input-rate", "Sample rate of raw PCM input in Hz (default: 48000)",
+      "input-rate"));
   parser.addOption(QCommandLineOption(
       "no-signal-exit",
-      "Exit if no signal is found after a full scan of a VFO"));
+      "Exit if no signal is found after a full scan of every VFO"));
+  parser.addOption(QCommandLineOption(
+      "threads",
+      "Number of worker threads VFOs are demodulated on (default: number of "
+      "CPU cores)",
+      "threads"));
+  parser.addOption(QCommandLineOption(
+      "decode-threads",
+      "Number of threads decoding ACARS applications with libacars before "
+      "messages are forwarded (default: 2)",
+      "decode-threads"));
+  parser.addOption(QCommandLineOption(
+      "queue-size",
+      "Number of decoded messages held for the forwarders before the queue "
+      "overflows, rounded up to a power of two (default: 1024, at most "
+      "1048576)",
+      "queue-size"));
+  parser.addOption(QCommandLineOption(
+      "queue-overflow",
+      "What a full forwarder queue does with another message; valid: "
+      "drop-oldest (default), block (hold up the demodulator, default when "
+      "replaying a file), spill (keep it in an unbounded list)",
+      "queue-overflow"));
+  parser.addOption(QCommandLineOption(
+      "coarse-estimate",
+      "When to run the coarse carrier estimator; valid: full (always at full "
+      "rate), adaptive (full rate until the data carrier has been detected "
+      "for a while, default), tracking (always at a low rate)",
+      "coarse-estimate"));
+  parser.addOption(QCommandLineOption(
+      "hunt",
+      "How to search a VFO for its carrier; valid: spectrum (try the "
+      "strongest carriers in the VFO spectrum first, default), step (walk "
+      "the VFO half a signal bandwidth at a time)",
+      "hunt"));
+  parser.addOption(QCommandLineOption(
+      "stats", "Report samples and messages per second and the demodulator "
+               "state when a replay ends"));
   parser.process(core);
 
   if (parser.isSet("verbose")) {
     gMaxLogVerbosity = true;
   }
 
+  const QString input = parser.value("input");
   const QString rawForwarders = parser.value("fwd");
   const QString publisher = parser.value("publisher");
-  const QString topic = parser.value("topic");
+  const QStringList topics =
+      parser.value("topic").split(",", Qt::SkipEmptyParts);
 
   QString format = parser.value("format");
   QString station_id = parser.value("station-id");
 
   int bitRate = parser.value("bit-rate").toInt();
+  int threads = QThread::idealThreadCount();
+  int decodeThreads = DEFAULT_DECODE_THREADS;
+  int queueSize = DEFAULT_SEND_BUFFER_ITEMS;
+  int inputRate = 48000;
 
   bool burstMode = parser.isSet("burst");
   bool disableReassembly = parser.isSet("disable-reassembly");
 
-  if (publisher.isEmpty()) {
+  if (publisher.isEmpty() && input.isEmpty()) {
     CRIT("Required publisher option is missing, example: -p "
          "tcp://127.0.0.1:6004");
     return 1;
@@ -79,19 +135,108 @@ int main(int argc, char *argv[]) {
          station_id.toStdString().c_str());
   }
 
-  if (topic.isEmpty()) {
+  if (topics.isEmpty() && input.isEmpty()) {
     CRIT("Required topic option is missing, example: -t VFO51");
     return 1;
   }
 
+  if (parser.isSet("threads")) {
+    threads = parser.value("threads").toInt();
+    if (threads < 1) {
+      CRIT("Invalid number of worker threads: %s",
+           parser.value("threads").toStdString().c_str());
+      return 1;
+    }
+  }
+
+  if (parser.isSet("decode-threads")) {
+    decodeThreads = parser.value("decode-threads").toInt();
+    if (decodeThreads < 1) {
+      CRIT("Invalid number of decode threads: %s",
+           parser.value("decode-threads").toStdString().c_str());
+      return 1;
+    }
+  }
+
+  if (parser.isSet("queue-size")) {
+    queueSize = parser.value("queue-size").toInt();
+    if (queueSize < 1 || queueSize > MAX_SEND_BUFFER_ITEMS) {
+      CRIT("Invalid forwarder queue size: %s",
+           parser.value("queue-size").toStdString().c_str());
+      return 1;
+    }
+  }
+
+  // a replay shouldn't lose messages just because it outruns the forwarders
+  OverflowPolicy overflow =
+      input.isEmpty() ? OverflowDropOldest : OverflowBlock;
+  if (parser.isSet("queue-overflow")) {
+    const QString policy = parser.value("queue-overflow").toLower();
+    if (policy == "drop-oldest") {
+      overflow = OverflowDropOldest;
+    } else if (policy == "block") {
+      overflow = OverflowBlock;
+    } else if (policy == "spill") {
+      overflow = OverflowSpill;
+    } else {
+      CRIT("Invalid forwarder queue overflow policy: %s",
+           parser.value("queue-overflow").toStdString().c_str());
+      return 1;
+    }
+  }
+
+  if (parser.isSet("input-rate")) {
+    inputRate = parser.value("input-rate").toInt();
+    if (inputRate <= 0) {
+      CRIT("Invalid input sample rate: %s",
+           parser.value("input-rate").toStdString().c_str());
+      return 1;
+    }
+  }
+
   if (format.isEmpty()) {
     format = "text";
   }
 
+  CoarseEstimatePolicy coarsePolicy = CoarseAdaptive;
+  if (parser.isSet("coarse-estimate")) {
+    const QString policy = parser.value("coarse-estimate").toLower();
+    if (policy == "full") {
+      coarsePolicy = CoarseFull;
+    } else if (policy == "tracking") {
+      coarsePolicy = CoarseTracking;
+    } else if (policy != "adaptive") {
+      CRIT("Invalid coarse estimate policy: %s",
+           parser.value("coarse-estimate").toStdString().c_str());
+      return 1;
+    }
+  }
+
+  HuntMode huntMode = HuntSpectrum;
+  if (parser.isSet("hunt")) {
+    const QString hunt = parser.value("hunt").toLower();
+    if (hunt == "step") {
+      huntMode = HuntStep;
+    } else if (hunt != "spectrum") {
+      CRIT("Invalid hunt mode: %s",
+           parser.value("hunt").toStdString().c_str());
+      return 1;
+    }
+  }
+
   EventNotifier notifier;
-  Decoder decoder(station_id, publisher, topic, format, bitRate, burstMode,
+  Decoder decoder(station_id, publisher, topics, format, bitRate, burstMode,
                   rawForwarders, disableReassembly);
   decoder.setNoSignalExit(parser.isSet("no-signal-exit"));
+  decoder.setWorkerThreads(threads);
+  decoder.setDecodeThreads(decodeThreads);
+  decoder.setSendBuffer(queueSize, overflow);
+  decoder.setReportStats(parser.isSet("stats"));
+  decoder.setCoarseEstimatePolicy(coarsePolicy);
+  decoder.setHuntMode(huntMode);
+  if (!input.isEmpty()) {
+    decoder.setInputFile(input, inputRate);
+  }
 
   QObject::connect(&notifier, SIGNAL(hangup()), &decoder, SLOT(handleHup()));
   QObject::connect(&notifier, SIGNAL(interrupt()), &decoder,
@@ -0,0 +1,304 @@
+#ifndef MPSCRING_H
+#define MPSCRING_H
+
+#include <QDeadlineTimer>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+#include <utility>
+
+// Largest capacity a ring rounds up to, bigger requests are clamped to it
+const int MPSC_RING_MAX_CAPACITY = 1 << 30;
+
+// What a full ring does with another item
+enum OverflowPolicy {
+  OverflowBlock,      // the producer waits for the consumer to make room
+  OverflowDropOldest, // the oldest item is thrown away to make room
+  OverflowSpill       // the item waits in an unbounded list behind the ring
+};
+
+struct MpscRingStats {
+  qint64 pushed;
+  qint64 dropped; // thrown away to make room, or pushed after close()
+  qint64 spilled;
+  qint64 blocked; // pushes that had to wait for room
+  int depth;
+  int maxDepth;
+};
+
+// Bounded queue that many threads push to and one thread pops from. Every
+// cell carries a sequence number saying whose turn it is, so a push or pop
+// is one compare and swap with no lock. The mutex is only taken when the
+// ring is full or spilling, or for a thread to sleep on it. Items are moved
+// in and out, never copied.
+template <typename T> class MpscRing {
+public:
+  explicit MpscRing(int capacity, OverflowPolicy policy = OverflowDropOldest)
+      : cells(nullptr), policy(policy) {
+    setCapacity(capacity);
+  }
+  MpscRing(const MpscRing &) = delete;
+  ~MpscRing() { delete[] cells; }
+
+  MpscRing &operator=(const MpscRing &) = delete;
+
+  // only while no other thread is using the ring, anything queued is lost.
+  // Rounded up to a power of two, at most MPSC_RING_MAX_CAPACITY.
+  void setCapacity(int capacity) {
+    capacity = qMin(capacity, MPSC_RING_MAX_CAPACITY);
+    int size = 1;
+    while (size < capacity)
+      size <<= 1;
+
+    delete[] cells;
+    cells = new Cell[size];
+    for (int i = 0; i < size; i++)
+      cells[i].seq.store(i, std::memory_order_relaxed);
+    mask = size - 1;
+
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    spillCount.store(0, std::memory_order_relaxed);
+    spill.clear();
+    consumerWaiting.store(0, std::memory_order_relaxed);
+    producersWaiting.store(0, std::memory_order_relaxed);
+    woken = false;
+    closed.store(false, std::memory_order_relaxed);
+
+    pushed.store(0, std::memory_order_relaxed);
+    dropped.store(0, std::memory_order_relaxed);
+    spilled.store(0, std::memory_order_relaxed);
+    blocked.store(0, std::memory_order_relaxed);
+    maxDepth.store(0, std::memory_order_relaxed);
+  }
+  void setPolicy(OverflowPolicy policy) { this->policy = policy; }
+  int getCapacity() const { return (int)mask + 1; }
+  OverflowPolicy getPolicy() const { return policy; }
+
+  // Any thread. False if the item was dropped because the ring is closed,
+  // with OverflowDropOldest it is always queued at the expense of the
+  // oldest one.
+  bool push(T &&item) {
+    if (closed.load(std::memory_order_acquire)) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    pushed.fetch_add(1, std::memory_order_relaxed);
+
+    // nothing may overtake spilled items, so they have to drain first
+    if (spillCount.load(std::memory_order_acquire) != 0 || !tryPush(item)) {
+      switch (policy) {
+      case OverflowDropOldest: {
+        T oldest;
+        while (!tryPush(item)) {
+          if (tryPop(oldest))
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        break;
+      }
+
+      case OverflowSpill: {
+        QMutexLocker locker(&mutex);
+        if (!spill.isEmpty() || !tryPush(item)) {
+          spill.append(std::move(item));
+          spillCount.store((int)spill.size(), std::memory_order_release);
+          spilled.fetch_add(1, std::memory_order_relaxed);
+        }
+        break;
+      }
+
+      case OverflowBlock: {
+        blocked.fetch_add(1, std::memory_order_relaxed);
+
+        QMutexLocker locker(&mutex);
+        producersWaiting.fetch_add(1, std::memory_order_seq_cst);
+        while (!tryPush(item)) {
+          if (closed.load(std::memory_order_acquire)) {
+            producersWaiting.fetch_sub(1, std::memory_order_relaxed);
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+          }
+          notFull.wait(&mutex);
+        }
+        producersWaiting.fetch_sub(1, std::memory_order_relaxed);
+        break;
+      }
+      }
+    }
+
+    const int depth = size();
+    int max = maxDepth.load(std::memory_order_relaxed);
+    while (depth > max && !maxDepth.compare_exchange_weak(
+                              max, depth, std::memory_order_relaxed)) {
+    }
+
+    // pairs with the fence in waitConsumer, so either the consumer sees the
+    // item or we see it waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumerWaiting.load(std::memory_order_relaxed) == WaitForItems)
+      wakeConsumer();
+
+    return true;
+  }
+
+  // Consumer thread only, oldest item first
+  bool pop(T &item) {
+    if (!tryPop(item)) {
+      if (spillCount.load(std::memory_order_acquire) == 0)
+        return false;
+
+      // the ring is drained, the spilled items are next
+      QMutexLocker locker(&mutex);
+      if (!tryPop(item)) {
+        if (spill.isEmpty())
+          return false;
+
+        item = spill.takeFirst();
+        spillCount.store((int)spill.size(), std::memory_order_release);
+      }
+    }
+
+    if (policy == OverflowBlock) {
+      // pairs with the increment in push
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (producersWaiting.load(std::memory_order_relaxed) != 0) {
+        QMutexLocker locker(&mutex);
+        notFull.wakeAll();
+      }
+    }
+
+    return true;
+  }
+
+  // Approximate while producers are pushing
+  int size() const {
+    const qint64 depth = (qint64)(tail.load(std::memory_order_acquire) -
+                                  head.load(std::memory_order_acquire));
+    return (int)qMax(depth, (qint64)0) +
+           spillCount.load(std::memory_order_acquire);
+  }
+  bool isEmpty() const { return size() == 0; }
+
+  // Sleeps the consumer for up to msecs, until wakeConsumer() is called or,
+  // with forItems, until there is an item to pop
+  void waitConsumer(int msecs, bool forItems) {
+    QMutexLocker locker(&mutex);
+    consumerWaiting.store(forItems ? WaitForItems : WaitForWake,
+                          std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (!woken && !(forItems && !isEmpty()))
+      notEmpty.wait(&mutex, QDeadlineTimer(msecs));
+
+    consumerWaiting.store(NotWaiting, std::memory_order_relaxed);
+    woken = false;
+  }
+
+  void wakeConsumer() {
+    QMutexLocker locker(&mutex);
+    woken = true;
+    notEmpty.wakeAll();
+  }
+
+  // Releases blocked producers, anything pushed from then on is dropped
+  void close() {
+    closed.store(true, std::memory_order_release);
+
+    QMutexLocker locker(&mutex);
+    notFull.wakeAll();
+    notEmpty.wakeAll();
+  }
+
+  MpscRingStats stats() const {
+    MpscRingStats s;
+    s.pushed = pushed.load(std::memory_order_relaxed);
+    s.dropped = dropped.load(std::memory_order_relaxed);
+    s.spilled = spilled.load(std::memory_order_relaxed);
+    s.blocked = blocked.load(std::memory_order_relaxed);
+    s.depth = size();
+    s.maxDepth = maxDepth.load(std::memory_order_relaxed);
+    return s;
+  }
+
+private:
+  enum { NotWaiting, WaitForWake, WaitForItems };
+
+  struct Cell {
+    std::atomic<quint64> seq;
+    T item;
+  };
+
+  // A cell is free to push to when its sequence equals the position and
+  // holds an item when it is one past it
+  bool tryPush(T &item) {
+    quint64 pos = tail.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &cell = cells[pos & mask];
+      const quint64 seq = cell.seq.load(std::memory_order_acquire);
+      const qint64 diff = (qint64)(seq - pos);
+      if (diff == 0) {
+        if (tail.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed)) {
+          cell.item = std::move(item);
+          cell.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // also used by producers dropping the oldest item
+  bool tryPop(T &item) {
+    quint64 pos = head.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &cell = cells[pos & mask];
+      const quint64 seq = cell.seq.load(std::memory_order_acquire);
+      const qint64 diff = (qint64)(seq - (pos + 1));
+      if (diff == 0) {
+        if (head.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed)) {
+          item = std::move(cell.item);
+          cell.seq.store(pos + mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  Cell *cells;
+  quint64 mask;
+  OverflowPolicy policy;
+
+  // on their own cache lines, producers only touch tail in the fast path
+  alignas(64) std::atomic<quint64> tail;
+  alignas(64) std::atomic<quint64> head;
+
+  // guards spill and woken, and is what sleeping threads wait on
+  alignas(64) QMutex mutex;
+  QWaitCondition notFull;
+  QWaitCondition notEmpty;
+  QList<T> spill;
+  std::atomic<int> spillCount;
+  std::atomic<int> consumerWaiting;
+  std::atomic<int> producersWaiting;
+  bool woken;
+  std::atomic<bool> closed;
+
+  std::atomic<qint64> pushed;
+  std::atomic<qint64> dropped;
+  std::atomic<qint64> spilled;
+  std::atomic<qint64> blocked;
+  std::atomic<int> maxDepth;
+};
+
+#endif // MPSCRING_H
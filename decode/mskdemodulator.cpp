@@ -3,13 +3,12 @@
 #include <QDebug>
 
 #include <QTimerEvent>
+#include <algorithm>
 
 MskDemodulator::MskDemodulator(QObject *parent) : QObject(parent) {
 
   afc = false;
 
-  timer.start();
-
   Fs = 48000;
   double freq_center = 1000;
   lockingbw = 900;
@@ -48,13 +47,10 @@ MskDemodulator::MskDemodulator(QObject *parent) : QObject(parent) {
   bbcycbuff_ptr = 0;
   bbtmpbuff.resize(bbnfft);
 
-  spectrumnfft = pow(2, 13);
-  spectrumcycbuff.resize(spectrumnfft);
-  spectrumcycbuff_ptr = 0;
-  spectrumtmpbuff.resize(spectrumnfft);
-
-  pointbuff.resize(100);
-  pointbuff_ptr = 0;
+  countdown = 4;
+  peak = 0;
+  cpuReduce = false;
+  coarseEstimates = 0;
   mse = 10.0;
   msema = new MovingAverage(600);
 
@@ -82,10 +78,30 @@ MskDemodulator::MskDemodulator(QObject *parent) : QObject(parent) {
 
 void MskDemodulator::setAFC(bool state) { afc = state; }
 
-void MskDemodulator::setCPUReduce(bool state) { cpuReduce = state; }
+void MskDemodulator::setCPUReduce(bool state) {
+  coarseSchedule.setPolicy(state ? CoarseTracking : CoarseFull);
+}
+
+void MskDemodulator::setCoarseEstimatePolicy(CoarseEstimatePolicy policy) {
+  coarseSchedule.setPolicy(policy);
+}
+
+void MskDemodulator::setCoarseEstimateDCD(bool dcd) { coarseSchedule.setDCD(dcd); }
 
 double MskDemodulator::getCurrentFreq() { return mixer_center.GetFreqHz(); }
 
+DemodMetrics MskDemodulator::getMetrics() {
+  DemodMetrics metrics;
+  metrics.peak = peak;
+  metrics.ebno = ebnomeasure->EbNo;
+  metrics.mse = mse;
+  metrics.freq = mixer2.GetFreqHz();
+  metrics.coarseEstimates = coarseEstimates;
+  peak = 0;
+  coarseEstimates = 0;
+  return metrics;
+}
+
 void MskDemodulator::invalidatesettings() {
   Fs = -1;
   fb = -1;
@@ -139,14 +155,10 @@ void MskDemodulator::setSettings(Settings _settings) {
   ebnomeasure = new MSKEbNoMeasure(
       2.0 * Fs); // 1 second ave //SamplesPerSymbol*125);//125 symbol averaging
 
-  pointbuff.resize(100);
-  pointbuff_ptr = 0;
   mse = 10.0;
 
   lastindex = 0;
 
-  emit Plottables(mixer2.GetFreqHz(), mixer_center.GetFreqHz(), lockingbw);
-
   st_iir_resonator.a.resize(3);
   st_iir_resonator.b.resize(3);
 
@@ -236,7 +248,6 @@ void MskDemodulator::CenterFreqChangedSlot(
   }
   for (int j = 0; j < bbcycbuff.size(); j++)
     bbcycbuff[j] = 0;
-  emit Plottables(mixer2.GetFreqHz(), mixer_center.GetFreqHz(), lockingbw);
 }
 
 MskDemodulator::~MskDemodulator() {
@@ -251,32 +262,12 @@ MskDemodulator::~MskDemodulator() {
 
 qint64 MskDemodulator::writeData(const char *data, qint64 len) {
   const short *ptr = reinterpret_cast<const short *>(data);
+  cpuReduce = coarseSchedule.reduce(len / sizeof(short), Fs);
   for (int i = 0; i < (int)(len / sizeof(short)); i++) {
 
-    double dval = ((double)(*ptr)) / 32768.0;
-
-    // for looks
-    spectrumcycbuff[spectrumcycbuff_ptr] = dval;
-    spectrumcycbuff_ptr++;
-    spectrumcycbuff_ptr %= spectrumnfft;
-    if (spectrumcycbuff_ptr % (spectrumnfft) == 0) {
-      double maxval = 0;
-      for (int j = 0; j < spectrumcycbuff.size(); j++) {
-        spectrumtmpbuff[j] = spectrumcycbuff[spectrumcycbuff_ptr];
-        spectrumcycbuff_ptr++;
-        spectrumcycbuff_ptr %= spectrumnfft;
-        if (fabs(spectrumtmpbuff[j]) > maxval) {
-          maxval = fabs(spectrumtmpbuff[j]);
-        }
-      }
+    dsp_t dval = ((dsp_t)(*ptr)) / 32768.0;
 
-      if ((!cpuReduce && timer.elapsed() > 150) ||
-          (cpuReduce && timer.elapsed() > 1000)) {
-        timer.start();
-        emit OrgOverlapedBuffer(spectrumtmpbuff);
-        emit PeakVolume(maxval);
-      }
-    }
+    peak = std::max(peak, (double)std::fabs(dval));
 
     if ((coarseCounter >= Fs || !cpuReduce)) {
 
@@ -293,6 +284,7 @@ qint64 MskDemodulator::writeData(const char *data, qint64 len) {
           bbcycbuff_ptr %= bbnfft;
         }
         emit BBOverlapedBuffer(bbtmpbuff);
+        coarseEstimates++;
         coarseCounter = 0;
       }
     }
@@ -302,7 +294,7 @@ qint64 MskDemodulator::writeData(const char *data, qint64 len) {
         cpx_type(matchedfilter_re->FIRUpdateAndProcess(cval.real()),
                  matchedfilter_im->FIRUpdateAndProcess(cval.imag()));
 
-    double dabval =
+    dsp_t dabval =
         std::sqrt(sig2.real() * sig2.real() + sig2.imag() * sig2.imag());
 
     // Measure ebno
@@ -312,10 +304,10 @@ qint64 MskDemodulator::writeData(const char *data, qint64 len) {
     sig2 *= agc->Update(dabval);
 
     // clipping
-    double abval =
+    dsp_t abval =
         std::sqrt(sig2.real() * sig2.real() + sig2.imag() * sig2.imag());
     if (abval > 2.84)
-      sig2 = (2.84 / abval) * sig2;
+      sig2 = (dsp_t)(2.84 / abval) * sig2;
 
     cpx_type pt_d = delayedsmpl.update_dont_touch(sig2);
     cpx_type pt_msk = cpx_type(sig2.real(), pt_d.imag());
@@ -368,21 +360,6 @@ qint64 MskDemodulator::writeData(const char *data, qint64 len) {
       dt.update(pt_msk);
       pt_msk *= cpx_type(cos(marg->Val), sin(marg->Val));
 
-      // gui feedback
-      static int slowdown = 0;
-      if (pointbuff_ptr == 0) {
-        slowdown++;
-        slowdown %= 12;
-      }
-      // for looks show constellation
-      if (!slowdown) {
-        ASSERTCH(pointbuff, pointbuff_ptr);
-        pointbuff[pointbuff_ptr] = pt_msk * 0.75;
-
-        pointbuff_ptr++;
-        pointbuff_ptr %= pointbuff.size();
-      }
-
       double tda = (fabs((pt_msk).real() * 0.75) - 1.0);
       double tdb = (fabs((pt_msk).imag() * 0.75) - 1.0);
       mse = msema->Update((tda * tda) + (tdb * tdb));
@@ -393,10 +370,10 @@ qint64 MskDemodulator::writeData(const char *data, qint64 len) {
       int ibit = qRound((imagin) * 127.0 + 128.0);
       if (ibit > 255)
         ibit = 255;
-      if (ibit < 0)
-        ibit = 0;
+      if (ibit < 1)
+        ibit = 1;
 
-      RxDataBits.push_back((uchar)ibit);
+      RxDataBits.push_back((SoftBit)ibit);
 
       double real = diffdecode.UpdateSoft(pt_msk.real());
 
@@ -406,14 +383,16 @@ qint64 MskDemodulator::writeData(const char *data, qint64 len) {
 
       if (ibit > 255)
         ibit = 255;
-      if (ibit < 0)
-        ibit = 0;
+      if (ibit < 1)
+        ibit = 1;
 
-      RxDataBits.push_back((uchar)ibit);
+      RxDataBits.push_back((SoftBit)ibit);
 
       // push them out to decode
       if (RxDataBits.size() >= 12) {
-        emit processDemodulatedSoftBits(RxDataBits);
+        if (softBitSink != nullptr)
+          softBitSink->processSoftBits(RxDataBits.constData(),
+                                       RxDataBits.size());
         RxDataBits.clear();
       }
     }
@@ -431,7 +410,6 @@ void MskDemodulator::FreqOffsetEstimateSlot(
     double freq_offset_est) // coarse est class calls this with current est
 {
 
-  static int countdown = 4;
   if ((mse > signalthreshold) &&
       (fabs(mixer2.GetFreqHz() - (mixer_center.GetFreqHz() + freq_offset_est)) >
        0.0)) // no sig, prob cant track carrier phase
@@ -456,7 +434,6 @@ void MskDemodulator::FreqOffsetEstimateSlot(
     }
   } else
     countdown = 4;
-  emit Plottables(mixer2.GetFreqHz(), mixer_center.GetFreqHz(), lockingbw);
 
   emit EbNoMeasurmentSignal(ebnomeasure->EbNo);
 
@@ -470,12 +447,13 @@ void MskDemodulator::FreqOffsetEstimateSlot(
 
 void MskDemodulator::DCDstatSlot(bool _dcd) { dcd = _dcd; }
 
-void MskDemodulator::dataReceived(const QByteArray &audio, quint32 sampleRate) {
+void MskDemodulator::processAudio(const char *data, qint64 len,
+                                  quint32 sampleRate) {
   if (sampleRate != Fs) {
     qDebug() << "Sample rate different than expected. Trying to change "
                 "demodulator sample rate. (Expected:" << sampleRate << ", Got:" << Fs << ")";
     last_applied_settings.Fs = sampleRate;
     setSettings(last_applied_settings);
   }
-  writeData(audio, audio.length());
+  writeData(data, len);
 }
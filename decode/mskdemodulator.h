@@ -2,14 +2,13 @@
 #define MSKDEMODULATOR_H
 
 #include "DSP.h"
+#include "coarsefreqestimate.h"
+#include "pipeline.h"
 #include <QObject>
 #include <QVector>
 #include <QPointer>
-#include <QElapsedTimer>
 
-class CoarseFreqEstimate;
-
-class MskDemodulator : public QObject {
+class MskDemodulator : public QObject, public DemodulatorStage {
   Q_OBJECT
 public:
   struct Settings {
@@ -37,27 +36,27 @@ public:
   ~MskDemodulator();
 
   qint64 writeData(const char *data, qint64 len);
+  void processAudio(const char *data, qint64 len, quint32 sampleRate);
   void setSettings(Settings settings);
   void invalidatesettings();
   void setAFC(bool state);
   void setCPUReduce(bool state);
   double getCurrentFreq();
+  DemodMetrics getMetrics();
+  void setCoarseEstimatePolicy(CoarseEstimatePolicy policy);
+  void setCoarseEstimateDCD(bool dcd);
 
 private:
   WaveTable mixer_center;
   WaveTable mixer2;
   WaveTable st_osc;
 
-  int spectrumnfft, bbnfft;
+  int bbnfft;
 
   QVector<cpx_type> bbcycbuff;
   QVector<cpx_type> bbtmpbuff;
   int bbcycbuff_ptr;
 
-  QVector<double> spectrumcycbuff;
-  QVector<double> spectrumtmpbuff;
-  int spectrumcycbuff_ptr;
-
   CoarseFreqEstimate *coarsefreqestimate;
 
   double Fs;
@@ -79,12 +78,9 @@ private:
 
   int lastindex;
 
-  QVector<cpx_type> pointbuff;
-  int pointbuff_ptr;
-
   DiffDecode diffdecode;
 
-  QVector<short> RxDataBits; // unpacked
+  QVector<SoftBit> RxDataBits; // unpacked
 
   double mse;
 
@@ -96,11 +92,14 @@ private:
 
   BaceConverter bc;
 
-  QElapsedTimer timer;
-
   double ee;
   cpx_type pt_d;
 
+  // per instance afc state
+  int countdown;
+
+  double peak;
+
   IIR st_iir_resonator;
 
   MovingAverage *marg;
@@ -114,18 +113,15 @@ private:
   double correctionfactor;
 
   int coarseCounter;
-  bool cpuReduce;
+  bool cpuReduce; // tracking rate for the current block
+  CoarseEstimateSchedule coarseSchedule;
+  int coarseEstimates;
 
   Settings last_applied_settings;
 
 signals:
-  void ScatterPoints(const QVector<cpx_type> &buffer);
   void SymbolPhase(double phase_rad);
   void BBOverlapedBuffer(const QVector<cpx_type> &buffer);
-  void OrgOverlapedBuffer(const QVector<double> &buffer);
-  void Plottables(double freq_est, double freq_center, double bandwidth);
-  void PeakVolume(double Volume);
-  void processDemodulatedSoftBits(const QVector<short> &soft_bits);
   void RxData(const QByteArray &data); // packed in bytes
   void MSESignal(double mse);
   void SignalStatus(bool gotasignal);
@@ -137,7 +133,6 @@ public slots:
   void FreqOffsetEstimateSlot(double freq_offset_est);
   void CenterFreqChangedSlot(double freq_center);
   void DCDstatSlot(bool dcd);
-  void dataReceived(const QByteArray &audio, quint32 sampleRate);
 };
 
 #endif // MSKDEMODULATOR_H
@@ -3,8 +3,7 @@
 #include <QDebug>
 #include <QFile>
 #include <QTextStream>
-
-#define SPECTRUM_FFT_POWER 13
+#include <algorithm>
 
 OqpskDemodulator::OqpskDemodulator(QObject *parent) : QObject(parent) {
   afc = false;
@@ -23,12 +22,6 @@ OqpskDemodulator::OqpskDemodulator(QObject *parent) : QObject(parent) {
   mixer_center.SetFreq(freq_center, Fs);
   mixer2.SetFreq(freq_center, Fs);
 
-  timer.start();
-
-  spectrumnfft = pow(2, SPECTRUM_FFT_POWER);
-  spectrumcycbuff.resize(spectrumnfft);
-  spectrumcycbuff_ptr = 0;
-
   bbnfft = pow(2, 14);
   bbcycbuff.resize(bbnfft);
   bbcycbuff_ptr = 0;
@@ -41,11 +34,14 @@ OqpskDemodulator::OqpskDemodulator(QObject *parent) : QObject(parent) {
   marg = new MovingAverage(800);
   dt.setLength(400);
 
-  phasepointbuff.resize(2);
-  phasepointbuff_ptr = 0;
-
-  pointbuff.resize(300);
-  pointbuff_ptr = 0;
+  sig2_last = 0;
+  pt_d = 0;
+  yui = 0;
+  countdown = 4;
+  countdown2 = 5;
+  peak = 0;
+  cpuReduce = false;
+  coarseEstimates = 0;
 
   msecalc = new MSEcalc(400);
 
@@ -126,7 +122,15 @@ OqpskDemodulator::~OqpskDemodulator() {
 
 void OqpskDemodulator::setAFC(bool state) { afc = state; }
 
-void OqpskDemodulator::setCPUReduce(bool state) { cpuReduce = state; }
+void OqpskDemodulator::setCPUReduce(bool state) {
+  coarseSchedule.setPolicy(state ? CoarseTracking : CoarseFull);
+}
+
+void OqpskDemodulator::setCoarseEstimatePolicy(CoarseEstimatePolicy policy) {
+  coarseSchedule.setPolicy(policy);
+}
+
+void OqpskDemodulator::setCoarseEstimateDCD(bool dcd) { coarseSchedule.setDCD(dcd); }
 
 void OqpskDemodulator::invalidatesettings() {
   Fs = -1;
@@ -160,9 +164,6 @@ void OqpskDemodulator::setSettings(Settings _settings) {
   delete agc;
   agc = new AGC(4, Fs);
 
-  pointbuff.resize(300);
-  pointbuff_ptr = 0;
-
   // Reset symbol rate dependent stuff
 
   if (fir_re)
@@ -248,7 +249,6 @@ void OqpskDemodulator::setSettings(Settings _settings) {
       4096); // rrc_pre_imp.Points.size()*2);//use x2 rather than the x4 rule of
              // thumb, will make it more responsive but may use more cpu
 
-  emit Plottables(mixer2.GetFreqHz(), mixer_center.GetFreqHz(), lockingbw);
 
   coarseCounter = 0;
 }
@@ -274,129 +274,126 @@ void OqpskDemodulator::CenterFreqChangedSlot(
   if ((mixer2.GetFreqHz() - mixer_center.GetFreqHz()) < (-lockingbw / 2.0)) {
     mixer2.SetFreq(mixer_center.GetFreqHz() - (lockingbw / 2.0));
   }
+  // the prefilter follows mixer2, don't leave it on the old carrier until
+  // the end of the next block
+  mixer_fir_pre.SetFreq(mixer2.GetFreqHz());
   for (int j = 0; j < bbcycbuff.size(); j++)
     bbcycbuff[j] = 0;
-  emit Plottables(mixer2.GetFreqHz(), mixer_center.GetFreqHz(), lockingbw);
 }
 
 double OqpskDemodulator::getCurrentFreq() { return mixer_center.GetFreqHz(); }
 
+DemodMetrics OqpskDemodulator::getMetrics() {
+  DemodMetrics metrics;
+  metrics.peak = peak;
+  metrics.ebno = ebnomeasure->EbNo;
+  metrics.mse = mse;
+  metrics.freq = mixer2.GetFreqHz();
+  metrics.coarseEstimates = coarseEstimates;
+  peak = 0;
+  coarseEstimates = 0;
+  return metrics;
+}
+
 qint64 OqpskDemodulator::writeData(const char *data, qint64 len) {
   if (!len)
     return 0;
 
   double lastmse = mse;
+  const int n = len / sizeof(short);
 
-  // prefilter start
-  QVector<cpx_type> cval_prefiltered;
-  if (fb == 8400) {
-
-    // I think the org estimate good enough so dont bother
-    // mixer_fir_pre.SetFreq(mixer2.GetFreqHz()*0.03+0.97*mixer_fir_pre.GetFreqHz());
-
-    // down
-    cval_prefiltered.resize(len / sizeof(short));
-    const short *ptr2 = reinterpret_cast<const short *>(data);
-    double savedphase = mixer_fir_pre.GetPhaseDeg();
-    for (int i = 0; i < cval_prefiltered.size(); i++) {
-      double dval = ((double)(*ptr2)) / 32768.0;
-
-      // down
-      cval_prefiltered[i] = mixer_fir_pre.WTCISValue() * dval;
-
-      // next
-      mixer_fir_pre.WTnextFrame();
-      ptr2++;
+  // convert, the peak is taken on the integers so it vectorizes
+  samples.resize(n);
+  const short *ptr = reinterpret_cast<const short *>(data);
+  dsp_t *x = samples.data();
+  int blockpeak = 0;
+  for (int i = 0; i < n; i++) {
+    x[i] = ((dsp_t)ptr[i]) * (dsp_t)(1.0 / 32768.0);
+    blockpeak = std::max(blockpeak, std::abs((int)ptr[i]));
+  }
+  peak = std::max(peak, blockpeak / 32768.0);
+
+  // full rate 75% overlap while hunting, tracking rate once locked
+  cpuReduce = coarseSchedule.reduce(n, Fs);
+
+  // the coarse estimator only listens for a block of samples once a second
+  // while tracking, so mixing to it is split into runs around that gap
+  centerphasor.resize(n);
+  mixer_center.WTCISBlock(centerphasor.data(), n);
+  const int hop = cpuReduce ? bbnfft : bbnfft / 4; // 75% overlap hunting
+  const int idleSamples = (int)std::ceil(Fs);
+  for (int i = 0; i < n;) {
+    if (cpuReduce && coarseCounter < idleSamples) {
+      const int skip = std::min(n - i, idleSamples - coarseCounter);
+      coarseCounter += skip;
+      i += skip;
+      continue;
     }
 
-    // filter vector
-    fir_pre.update(cval_prefiltered);
-
-    // up
-    mixer_fir_pre.SetPhaseDeg(savedphase);
-    for (int i = 0; i < cval_prefiltered.size(); i++) {
-      // up
-      cval_prefiltered[i] *= mixer_fir_pre.WTCISValue_conj();
-
-      // next
-      mixer_fir_pre.WTnextFrame();
+    const int run = std::min(n - i, hop - bbcycbuff_ptr % hop);
+    ASSERTCH(bbcycbuff, bbcycbuff_ptr + run - 1);
+    MixBlock(x + i, centerphasor.constData() + i,
+             bbcycbuff.data() + bbcycbuff_ptr, run);
+    bbcycbuff_ptr = (bbcycbuff_ptr + run) % bbnfft;
+    coarseCounter += run;
+    i += run;
+
+    if (bbcycbuff_ptr % hop == 0) {
+      // oldest sample first
+      const cpx_type *cyc = bbcycbuff.constData();
+      std::copy(cyc + bbcycbuff_ptr, cyc + bbnfft, bbtmpbuff.data());
+      std::copy(cyc, cyc + bbcycbuff_ptr,
+                bbtmpbuff.data() + (bbnfft - bbcycbuff_ptr));
+      emit BBOverlapedBuffer(bbtmpbuff);
+      coarseEstimates++;
+      coarseCounter = 1; // the sample that completed it
     }
   }
 
-  // prefilter end
+  // rrc filter the whole block around the carrier estimate ahead of the
+  // tracking loop. mixer2 is then only a small correction so the filter can
+  // sit before it for every rate, as the 8400bps prefilter always has.
 
-  double mixer2_freq_sum = 0;
-  int i = 0;
-  const short *ptr = reinterpret_cast<const short *>(data);
-  for (i = 0; i < (int)(len / sizeof(short)); i++) {
-    double dval = ((double)(*ptr)) / 32768.0;
-
-    // for looks
-    static double maxval = 0;
-    if (fabs(dval) > maxval)
-      maxval = fabs(dval);
-    spectrumcycbuff[spectrumcycbuff_ptr] = dval;
-    spectrumcycbuff_ptr++;
-    spectrumcycbuff_ptr %= spectrumnfft;
-
-    if ((!cpuReduce && timer.elapsed() > 150) ||
-        (cpuReduce && fb == 8400 && timer.elapsed() > 150) ||
-        (cpuReduce && fb > 8400 && timer.elapsed() > 1000)) {
-      timer.start();
-      emit OrgOverlapedBuffer(spectrumcycbuff);
-      emit PeakVolume(maxval);
-      maxval = 0;
-    }
+  // down
+  filtered.resize(n);
+  prephasor.resize(n);
+  mixer_fir_pre.WTCISBlock(prephasor.data(), n);
+  MixBlock(x, prephasor.constData(), filtered.data(), n);
 
-    if ((coarseCounter >= Fs || !cpuReduce)) {
-
-      ASSERTCH(bbcycbuff, bbcycbuff_ptr);
-      bbcycbuff[bbcycbuff_ptr] = mixer_center.WTCISValue() * dval;
-      bbcycbuff_ptr++;
-      bbcycbuff_ptr %= bbnfft;
-      if (bbcycbuff_ptr % (cpuReduce ? bbnfft : bbnfft / 4) == 0) // 75% overlap
-      {
-        for (int j = 0; j < bbcycbuff.size(); j++) {
-          ASSERTCH(bbcycbuff, bbcycbuff_ptr);
-          ASSERTCH(bbtmpbuff, j);
-          bbtmpbuff[j] = bbcycbuff[bbcycbuff_ptr];
-          bbcycbuff_ptr++;
-          bbcycbuff_ptr %= bbnfft;
-        }
-        emit BBOverlapedBuffer(bbtmpbuff);
-        coarseCounter = 0;
-      }
+  // filter vector and up
+  if (fb == 8400) {
+    prefiltered.resize(n);
+    for (int i = 0; i < n; i++)
+      prefiltered[i] = JFFT::cpx_type(filtered[i]);
+    fir_pre.update(prefiltered);
+    for (int i = 0; i < n; i++)
+      filtered[i] = cpx_type(prefiltered[i]);
+  } else {
+    block_re.resize(n);
+    block_im.resize(n);
+    for (int i = 0; i < n; i++) {
+      block_re[i] = filtered[i].real();
+      block_im[i] = filtered[i].imag();
     }
+    fir_re->FIRUpdateAndProcessBlock(block_re.data(), block_re.data(), n);
+    fir_im->FIRUpdateAndProcessBlock(block_im.data(), block_im.data(), n);
+    for (int i = 0; i < n; i++)
+      filtered[i] = cpx_type(block_re[i], block_im[i]);
+  }
+  MixConjBlock(filtered.constData(), prephasor.constData(), filtered.data(),
+               n);
 
-    coarseCounter++;
-    //-----
-
-    cpx_type cval, sig2;
-
-    if (fb == 8400) {
-      // already had a good enough rrc filter just needs mixing down
-      // mix
-      sig2 = mixer2.WTCISValue() * cval_prefiltered[i];
-
-      // this would be both
-      // cval=mixer2.WTCISValue()*cval_prefiltered[i];
-      // sig2=cpx_type(fir_re->FIRUpdateAndProcess(cval.real()),fir_im->FIRUpdateAndProcess(cval.imag()));
-
-      // calc ave of freq over this block for 8400bps prefilter
-      mixer2_freq_sum += mixer2.GetFreqHz();
-
-    } else {
-      // mix
-      cval = mixer2.WTCISValue() * dval;
+  double mixer2_freq_sum = 0;
+  for (int i = 0; i < n; i++) {
+    // mix
+    cpx_type sig2 = mixer2.WTCISValue() * filtered[i];
 
-      // rrc
-      sig2 = cpx_type(fir_re->FIRUpdateAndProcess(cval.real()),
-                      fir_im->FIRUpdateAndProcess(cval.imag()));
-    }
+    // calc ave of freq over this block for the prefilter
+    mixer2_freq_sum += mixer2.GetFreqHz();
 
     // Measure ebno
 
-    double dabval =
+    dsp_t dabval =
         std::sqrt(sig2.real() * sig2.real() + sig2.imag() * sig2.imag());
 
     ebnomeasure->Update(dabval);
@@ -405,9 +402,9 @@ qint64 OqpskDemodulator::writeData(const char *data, qint64 len) {
     sig2 *= agc->Update(dabval);
 
     // clipping
-    double abval = std::abs(sig2);
+    dsp_t abval = std::abs(sig2);
     if (abval > 2.84)
-      sig2 = (2.84 / abval) * sig2;
+      sig2 = (dsp_t)(2.84 / abval) * sig2;
 
     // symbol timer
     double st_diff = delays.update(abval * abval) - (abval * abval);
@@ -426,18 +423,15 @@ qint64 OqpskDemodulator::writeData(const char *data, qint64 len) {
       st_osc.SetFreq((st_osc_ref.GetFreqHz() + 0.1));
 
     // sample times
-    static cpx_type sig2_last = sig2;
     if (st_osc.IfHavePassedPoint(ee)) {
 
       // interpol
-      double pt_last = st_osc.FractionOfSampleItPassesBy;
-      double pt_this = 1.0 - pt_last;
+      dsp_t pt_last = st_osc.FractionOfSampleItPassesBy;
+      dsp_t pt_this = 1.0 - pt_last;
       cpx_type pt = pt_this * sig2 + pt_last * sig2_last;
 
-      static int yui = 0;
       yui++;
       yui %= 2;
-      static cpx_type pt_d = 0;
       if (!yui)
         pt_d = pt;
       else {
@@ -480,33 +474,6 @@ qint64 OqpskDemodulator::writeData(const char *data, qint64 len) {
         dt.update(pt_qpsk);
         pt_qpsk *= cpx_type(cos(marg->Val), sin(marg->Val));
 
-        // gui feedback
-        static int slowdown = 0;
-        if (pointbuff_ptr == 0) {
-          slowdown++;
-          slowdown %= 100;
-        }
-        // for looks show constellation
-        if (!slowdown) {
-          ASSERTCH(pointbuff, pointbuff_ptr);
-          pointbuff.replace(pointbuff_ptr, pt_qpsk);
-          pointbuff_ptr++;
-          pointbuff_ptr %= pointbuff.size();
-          // if(scatterpointtype==SPT_constellation&&(pointbuff_ptr%100==0))emit
-          // ScatterPoints(pointbuff);
-        }
-        // for looks show symbol phase offset
-        if (!slowdown) {
-          cpx_type st_phase_offset_pt =
-              st_osc_ref.WTCISValue() * std::conj(st_osc.WTCISValue());
-          ASSERTCH(phasepointbuff, phasepointbuff_ptr);
-          phasepointbuff.replace(phasepointbuff_ptr, st_phase_offset_pt);
-          phasepointbuff_ptr++;
-          phasepointbuff_ptr %= phasepointbuff.size();
-          // if(scatterpointtype==SPT_phaseoffsetest)emit
-          // ScatterPoints(phasepointbuff);
-        }
-
         // calc MSE of the points
         mse = msecalc->Update(pt_qpsk);
 
@@ -516,25 +483,27 @@ qint64 OqpskDemodulator::writeData(const char *data, qint64 len) {
           int ibit = qRound(0.75 * pt_qpsk.imag() * 127.0 + 128.0);
           if (ibit > 255)
             ibit = 255;
-          if (ibit < 0)
-            ibit = 0;
+          if (ibit < 1)
+            ibit = 1;
 
-          RxDataBits.push_back((uchar)ibit);
+          RxDataBits.push_back((SoftBit)ibit);
 
           ibit = qRound(0.75 * pt_qpsk.real() * 127.0 + 128.0);
           if (ibit > 255)
             ibit = 255;
-          if (ibit < 0)
-            ibit = 0;
+          if (ibit < 1)
+            ibit = 1;
 
-          RxDataBits.push_back((uchar)ibit);
+          RxDataBits.push_back((SoftBit)ibit);
 
           // return the demodulated data (soft bit)
 
           if (RxDataBits.size() >= 32) {
             if (mse < signalthreshold || lastmse < signalthreshold) {
 
-              emit processDemodulatedSoftBits(RxDataBits);
+              if (softBitSink != nullptr)
+                softBitSink->processSoftBits(RxDataBits.constData(),
+                                             RxDataBits.size());
             }
             RxDataBits.clear();
           }
@@ -546,15 +515,13 @@ qint64 OqpskDemodulator::writeData(const char *data, qint64 len) {
     //-----
 
     mixer2.WTnextFrame();
-    mixer_center.WTnextFrame();
     st_osc.WTnextFrame();
     st_osc_ref.WTnextFrame();
-    ptr++;
   }
 
-  // update the 8400bps pre filter with better estimates of carrier in case
+  // update the pre filter with better estimates of carrier in case
   // someone uses C band with lots of drift. untested on C-band.
-  mixer_fir_pre.SetFreq(mixer2_freq_sum / ((double)i));
+  mixer_fir_pre.SetFreq(mixer2_freq_sum / ((double)n));
 
   return len;
 }
@@ -569,7 +536,6 @@ void OqpskDemodulator::FreqOffsetEstimateSlot(
   }
 
   // for preventing bad stable states
-  static int countdown2 = 5;
   if ((mse < signalthreshold) &&
       (!dcd)) // signal but we arent getting data so prob in a state that is
               // stable but wrong
@@ -583,7 +549,6 @@ void OqpskDemodulator::FreqOffsetEstimateSlot(
   } else
     countdown2 = 5;
 
-  static int countdown = 4;
   if ((mse > signalthreshold) &&
       (fabs(mixer2.GetFreqHz() - (mixer_center.GetFreqHz() + freq_offset_est)) >
        3.0)) // no sig, prob cant track carrier phase
@@ -609,7 +574,6 @@ void OqpskDemodulator::FreqOffsetEstimateSlot(
     }
   } else
     countdown = 4;
-  emit Plottables(mixer2.GetFreqHz(), mixer_center.GetFreqHz(), lockingbw);
 
   emit EbNoMeasurmentSignal(ebnomeasure->EbNo);
   emit MSESignal(mse);
@@ -621,10 +585,10 @@ void OqpskDemodulator::FreqOffsetEstimateSlot(
 
 void OqpskDemodulator::DCDstatSlot(bool _dcd) { dcd = _dcd; }
 
-void OqpskDemodulator::dataReceived(const QByteArray &audio,
+void OqpskDemodulator::processAudio(const char *data, qint64 len,
                                     quint32 sampleRate) {
   if (sampleRate != Fs) {
     qDebug() << "Sample rate not supported by demodulator";
   }
-  writeData(audio, audio.length());
+  writeData(data, len);
 }
@@ -2,14 +2,14 @@
 #define OQPSKDEMODULATOR_H
 
 #include "DSP.h"
+#include "pipeline.h"
 #include "coarsefreqestimate.h"
-#include <QElapsedTimer>
 #include <QObject>
 #include <QPointer>
 #include <QVector>
 #include <assert.h>
 
-class OqpskDemodulator : public QObject {
+class OqpskDemodulator : public QObject, public DemodulatorStage {
   Q_OBJECT
 public:
   struct Settings {
@@ -38,38 +38,28 @@ public:
   void setSettings(Settings settings);
   void invalidatesettings();
   qint64 writeData(const char *data, qint64 len);
+  void processAudio(const char *data, qint64 len, quint32 sampleRate);
   double getCurrentFreq();
+  DemodMetrics getMetrics();
+  void setCoarseEstimatePolicy(CoarseEstimatePolicy policy);
+  void setCoarseEstimateDCD(bool dcd);
 signals:
-  void ScatterPoints(const QVector<cpx_type> &buffer);
-  void OrgOverlapedBuffer(const QVector<double> &buffer);
-  void PeakVolume(double Volume);
   void SampleRateChanged(double Fs);
   void BitRateChanged(double fb, bool burstmode);
-  void Plottables(double freq_est, double freq_center, double bandwidth);
   void BBOverlapedBuffer(const QVector<cpx_type> &buffer);
   void MSESignal(double mse);
   void SignalStatus(bool gotasignal);
   void WarningTextSignal(const QString &str);
   void EbNoMeasurmentSignal(double EbNo);
-  void processDemodulatedSoftBits(const QVector<short> &soft_bits);
 
 private:
   bool afc;
 
-  QVector<double> spectrumcycbuff;
-  int spectrumcycbuff_ptr;
-  int spectrumnfft;
-
   QVector<cpx_type> bbcycbuff;
   QVector<cpx_type> bbtmpbuff;
   int bbcycbuff_ptr;
   int bbnfft;
 
-  QVector<cpx_type> pointbuff;
-  int pointbuff_ptr;
-
-  QElapsedTimer timer;
-
   double Fs;
   double freq_center;
   double lockingbw;
@@ -101,34 +91,50 @@ private:
   double mse;
   MSEcalc *msecalc;
 
-  QVector<cpx_type> phasepointbuff;
-  int phasepointbuff_ptr;
-
   AGC *agc;
 
   OQPSKEbNoMeasure *ebnomeasure;
 
   BaceConverter bc;
   QByteArray RxDataBytes;    // packed in bytes
-  QVector<short> RxDataBits; // unpacked
+  QVector<SoftBit> RxDataBits; // unpacked
 
   MovingAverage *marg;
   DelayThing<cpx_type> dt;
 
   double ee;
 
+  // per instance symbol timing, carrier tracking and afc state
+  cpx_type sig2_last;
+  cpx_type pt_d;
+  int yui;
+  int countdown;
+  int countdown2;
+
   bool dcd;
   JFastFir fir_pre;
   WaveTable mixer_fir_pre;
 
+  // per block stages of writeData
+  QVector<dsp_t> samples;
+  QVector<cpx_type> centerphasor;
+  QVector<cpx_type> prephasor;
+  QVector<cpx_type> filtered;
+  QVector<JFFT::cpx_type> prefiltered;
+  QVector<dsp_t> block_re;
+  QVector<dsp_t> block_im;
+
   int coarseCounter;
-  bool cpuReduce;
+  bool cpuReduce; // tracking rate for the current block
+  CoarseEstimateSchedule coarseSchedule;
+  int coarseEstimates;
+
+  double peak;
 
 public slots:
   void FreqOffsetEstimateSlot(double freq_offset_est);
   void CenterFreqChangedSlot(double freq_center);
   void DCDstatSlot(bool _dcd);
-  void dataReceived(const QByteArray &audio, quint32 sampleRate);
 };
 
 #endif // OQPSKDEMODULATOR_H
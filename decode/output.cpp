@@ -9,15 +9,125 @@ QString upperHex(T a, int fieldWidth, int base, QChar fillChar) {
   return QString("%1").arg(a, fieldWidth, base, fillChar).toUpper();
 }
 
-QString *toOutputFormat(OutputFormat fmt, const QString &station_id,
-                        bool disableReassembly, const ACARSItem &item) {
+static bool isAscii(const QByteArray &bytes) {
+  for (char c : bytes)
+    if ((uchar)c >= 0x80)
+      return false;
+  return true;
+}
+
+// Compact JSON appended straight to a byte array, strings escaped the way
+// QJsonDocument escapes them and Latin-1 encoded like the rest of the output
+class JsonWriter {
+public:
+  explicit JsonWriter(QByteArray &out) : out(out), first(true) {}
+
+  void beginObject(const char *key = nullptr) {
+    if (key != nullptr)
+      name(key);
+    out += '{';
+    first = true;
+  }
+  void endObject() {
+    out += '}';
+    first = false;
+  }
+
+  void field(const char *key, const QString &value) {
+    name(key);
+    string(value);
+    first = false;
+  }
+  void field(const char *key, const char *value) {
+    field(key, QString::fromLatin1(value));
+  }
+  void field(const char *key, qint64 value) {
+    name(key);
+    out += QByteArray::number(value);
+    first = false;
+  }
+
+  // the members of an already serialized object, added to the open one
+  void members(const QByteArray &object) {
+    const QByteArray trimmed = object.trimmed();
+    if (trimmed.size() < 2 || !trimmed.startsWith('{') ||
+        !trimmed.endsWith('}'))
+      return;
+
+    const QByteArray inner = trimmed.mid(1, trimmed.size() - 2).trimmed();
+    if (inner.isEmpty())
+      return;
+
+    if (!first)
+      out += ',';
+    // libacars writes UTF-8
+    out += isAscii(inner) ? inner : QString::fromUtf8(inner).toLatin1();
+    first = false;
+  }
+
+private:
+  void name(const char *key) {
+    if (!first)
+      out += ',';
+    out += '"';
+    out += key;
+    out += "\":";
+  }
+
+  void string(const QString &value) {
+    static const char hex[] = "0123456789abcdef";
+    const QByteArray latin1 = value.toLatin1();
+
+    out += '"';
+    for (char c : latin1) {
+      switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\b':
+        out += "\\b";
+        break;
+      case '\f':
+        out += "\\f";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if ((uchar)c < 0x20) {
+          out += "\\u00";
+          out += hex[(uchar)c >> 4];
+          out += hex[(uchar)c & 15];
+        } else {
+          out += c;
+        }
+      }
+    }
+    out += '"';
+  }
+
+  QByteArray &out;
+  bool first;
+};
+
+QByteArray toOutputFormat(OutputFormat fmt, const QString &station_id,
+                          bool disableReassembly, const ACARSItem &item) {
   switch (fmt) {
   case OutputFormat::Jaero:
   case OutputFormat::JsonDump:
   case OutputFormat::Text:
     break;
   default:
-    return nullptr;
+    return QByteArray();
   }
 
   QByteArray TAKstr;
@@ -46,64 +156,77 @@ QString *toOutputFormat(OutputFormat fmt, const QString &station_id,
     message.replace("\n", "\n\t");
 
     if (fmt == OutputFormat::JsonDump) {
-      QJsonObject app;
-      app["name"] = QCoreApplication::applicationName();
-      app["ver"] = QCoreApplication::applicationVersion();
-      root["app"] = QJsonValue(app);
-
-      QJsonObject isu;
-
-      QJsonObject aes;
-      aes["type"] = "Aircraft Earth Station";
-      aes["addr"] = upperHex(item.isuitem.AESID, 6, 16, QChar('0'));
+      // written out directly so libacars' JSON goes in as it is. Our own keys
+      // are in the sorted order QJsonDocument used to give them, libacars'
+      // come after them at the end of the acars object
+      QByteArray out;
+      // room for the newline the forwarder adds
+      out.reserve(512 + 2 * message.size() + item.parsedJson.size() + 1);
+      JsonWriter json(out);
+      json.beginObject();
 
-      QJsonObject ges;
-      ges["type"] = "Ground Earth Station";
-      ges["addr"] = upperHex(item.isuitem.GESID, 2, 16, QChar('0'));
+      json.beginObject("app");
+      json.field("name", QCoreApplication::applicationName());
+      json.field("ver", QCoreApplication::applicationVersion());
+      json.endObject();
 
+      json.beginObject("isu");
       if (!item.nonacars) {
-        QJsonObject acars;
-        acars["mode"] = (QString)item.MODE;
-        acars["ack"] = (QString)TAKstr;
-        acars["blk_id"] = QString((QChar)item.BI);
-        acars["label"] =
-            QString("%1%2").arg(QChar(item.LABEL[0])).arg(QChar(label1));
-        acars["reg"] = (QString)item.PLANEREG;
-
+        json.beginObject("acars");
+        json.field("ack", (QString)TAKstr);
+        json.field("blk_id", QString((QChar)item.BI));
+        if (!message.isEmpty() && item.downlink)
+          json.field("flight", message.mid(4, 6));
+        json.field(
+            "label",
+            QString("%1%2").arg(QChar(item.LABEL[0])).arg(QChar(label1)));
+        json.field("mode", (QString)item.MODE);
         if (!message.isEmpty()) {
           if (item.downlink) {
-            acars["msg_num"] = message.mid(0, 3);
-            acars["msg_num_seq"] = message.mid(3, 1);
-            acars["flight"] = message.mid(4, 6);
-            acars["msg_text"] = message.mid(4 + 6);
+            json.field("msg_num", message.mid(0, 3));
+            json.field("msg_num_seq", message.mid(3, 1));
+            json.field("msg_text", message.mid(4 + 6));
           } else {
-            acars["msg_text"] = message;
-          }
-
-          if (!item.parsed.isEmpty()) {
-            for (auto it = item.parsed.constBegin();
-                 it != item.parsed.constEnd(); it++) {
-              acars.insert(it.key(), it.value());
-            }
+            json.field("msg_text", message);
           }
         }
-
-        isu["acars"] = QJsonValue(acars);
+        json.field("reg", (QString)item.PLANEREG);
+        // la_acars_decode_apps returns a single application node, so this is
+        // one member named after its protocol (arinc622, media-adv, miam,
+        // ohma), none of which clash with the ACARS fields above
+        if (!message.isEmpty())
+          json.members(item.parsedJson);
+        json.endObject();
       }
 
-      isu["refno"] = upperHex(item.isuitem.REFNO, 2, 16, QChar('0'));
-      isu["qno"] = upperHex(item.isuitem.QNO, 2, 16, QChar('0'));
-      isu["src"] = QJsonValue(item.downlink ? aes : ges);
-      isu["dst"] = QJsonValue(item.downlink ? ges : aes);
+      const QString aesAddr = upperHex(item.isuitem.AESID, 6, 16, QChar('0'));
+      const QString gesAddr = upperHex(item.isuitem.GESID, 2, 16, QChar('0'));
+
+      json.beginObject("dst");
+      json.field("addr", item.downlink ? gesAddr : aesAddr);
+      json.field("type", item.downlink ? "Ground Earth Station"
+                                       : "Aircraft Earth Station");
+      json.endObject();
+      json.field("qno", upperHex(item.isuitem.QNO, 2, 16, QChar('0')));
+      json.field("refno", upperHex(item.isuitem.REFNO, 2, 16, QChar('0')));
+      json.beginObject("src");
+      json.field("addr", item.downlink ? aesAddr : gesAddr);
+      json.field("type", item.downlink ? "Aircraft Earth Station"
+                                       : "Ground Earth Station");
+      json.endObject();
+      json.endObject();
+
+      json.field("station", station_id);
 
-      QJsonObject t;
       QDateTime ts = time.toUTC();
-      t["sec"] = ts.toSecsSinceEpoch();
-      t["usec"] = (ts.toMSecsSinceEpoch() % 1000) * 1000;
-      root["t"] = QJsonValue(t);
+      json.beginObject("t");
+      json.field("sec", ts.toSecsSinceEpoch());
+      json.field("usec", (ts.toMSecsSinceEpoch() % 1000) * 1000);
+      json.endObject();
+
+      json.endObject();
 
-      root["isu"] = QJsonValue(isu);
-      root["station"] = station_id;
+      return out;
     } else if (fmt == OutputFormat::Jaero) {
       // add common things
       root["TIME"] = time.toSecsSinceEpoch();
@@ -126,46 +249,47 @@ QString *toOutputFormat(OutputFormat fmt, const QString &station_id,
       }
     }
 
-    return new QString(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return QString::fromUtf8(QJsonDocument(root).toJson(QJsonDocument::Compact))
+        .toLatin1();
   } else if (fmt == OutputFormat::Text) {
-    QString *out = new QString;
+    QString out;
     QString message = item.message;
     message.replace("\n", "\\n")
         .replace("\r", "\\r")
         .replace("\t", "\\t")
         .replace("\a", "\\a");
 
-    *out += QString("%1 AES:%2 GES:%3")
-                .arg(time.toUTC().toString("yyyy-MM-ddThh:mm:ssZ"))
-                .arg(upperHex(item.isuitem.AESID, 6, 16, QChar('0')))
-                .arg(upperHex(item.isuitem.GESID, 6, 16, QChar('0')));
+    out += QString("%1 AES:%2 GES:%3")
+               .arg(time.toUTC().toString("yyyy-MM-ddThh:mm:ssZ"))
+               .arg(upperHex(item.isuitem.AESID, 6, 16, QChar('0')))
+               .arg(upperHex(item.isuitem.GESID, 6, 16, QChar('0')));
 
     if (!item.nonacars) {
-      *out += QString(" [%1] ACK=%2 BLK=%3 ")
-                  .arg(item.PLANEREG, 7)
-                  .arg(QString(TAKstr), 1)
-                  .arg(QString((QChar)item.BI));
+      out += QString(" [%1] ACK=%2 BLK=%3 ")
+                 .arg(item.PLANEREG, 7)
+                 .arg(QString(TAKstr), 1)
+                 .arg(QString((QChar)item.BI));
 
       if (disableReassembly) {
-        *out += QString("M=%1 ").arg(item.moretocome ? "1" : "0");
+        out += QString("M=%1 ").arg(item.moretocome ? "1" : "0");
       }
 
-      *out += QString("LBL=%1%2 ").arg(QChar(item.LABEL[0])).arg(QChar(label1));
+      out += QString("LBL=%1%2 ").arg(QChar(item.LABEL[0])).arg(QChar(label1));
 
       if (!message.isEmpty()) {
         if (item.downlink) {
-          *out += QString("MSN=%1 FLT=%2 %3")
-                      .arg(message.mid(0, 4))
-                      .arg(message.mid(4, 6))
-                      .arg(message.mid(10));
+          out += QString("MSN=%1 FLT=%2 %3")
+                     .arg(message.mid(0, 4))
+                     .arg(message.mid(4, 6))
+                     .arg(message.mid(10));
         } else {
-          *out += QString("%1").arg(message);
+          out += QString("%1").arg(message);
         }
       }
     }
-    return out;
+    return out.toLatin1();
   } else {
     // NOTE: unreachable
-    return nullptr;
+    return QByteArray();
   }
 }
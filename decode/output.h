@@ -5,6 +5,9 @@
 #include "decode.h"
 #include <QJsonDocument>
 
-QString *toOutputFormat(OutputFormat fmt, const QString &station_id, bool disableReassembly, const ACARSItem &item);
+// The item encoded in a format, Latin-1 as it is sent to forwarders. Null if
+// the format has no encoding.
+QByteArray toOutputFormat(OutputFormat fmt, const QString &station_id,
+                          bool disableReassembly, const ACARSItem &item);
 
 #endif
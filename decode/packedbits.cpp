@@ -0,0 +1,90 @@
+#include "packedbits.h"
+
+#include <assert.h>
+
+// bit reversal of a byte, between MSB first and LSB first packing
+struct BitReverseTable {
+  uchar t[256];
+
+  BitReverseTable() {
+    for (int i = 0; i < 256; i++) {
+      uchar r = 0;
+      for (int k = 0; k < 8; k++)
+        r |= ((i >> k) & 1) << (7 - k);
+      t[i] = r;
+    }
+  }
+};
+
+static const BitReverseTable bitReverse;
+
+void PackedBits::resize(int n) {
+  assert(n >= 0);
+  const int oldbytes = bytes.size();
+  bytes.resize((n + 7) / 8 + 1);
+  for (int i = oldbytes; i < bytes.size(); i++)
+    bytes[i] = 0;
+  nbits = n;
+  clearTail();
+}
+
+void PackedBits::clearTail() {
+  uchar *d = data();
+  const int whole = nbits / 8;
+  if (nbits & 7)
+    d[whole] &= (1 << (nbits & 7)) - 1;
+  for (int i = (nbits + 7) / 8; i < bytes.size(); i++)
+    d[i] = 0;
+}
+
+void PackedBits::setFromMSBFirst(const uchar *src, int from, int n) {
+  resize(n);
+  uchar *d = data();
+  const int shift = from & 7;
+  src += from >> 3;
+  if (shift == 0) {
+    for (int j = 0; j < (n + 7) / 8; j++)
+      d[j] = bitReverse.t[src[j]];
+  } else {
+    // the last byte may only need its first few bits, so don't read past it
+    const int last = (shift + n - 1) >> 3;
+    for (int j = 0; j < (n + 7) / 8; j++) {
+      int v = src[j] << 8;
+      if (j + 1 <= last)
+        v |= src[j + 1];
+      d[j] = bitReverse.t[(v >> (8 - shift)) & 0xFF];
+    }
+  }
+  clearTail();
+}
+
+void PackedBits::append(const PackedBits &other) {
+  assert(&other != this);
+  const int pos = nbits;
+  const int shift = pos & 7;
+  resize(nbits + other.nbits);
+  uchar *d = data() + (pos >> 3);
+  const uchar *s = other.constData();
+  const int n = (other.nbits + 7) / 8;
+  if (shift == 0) {
+    for (int j = 0; j < n; j++)
+      d[j] = s[j];
+  } else {
+    for (int j = 0; j < n; j++) {
+      d[j] |= s[j] << shift;
+      d[j + 1] |= s[j] >> (8 - shift);
+    }
+  }
+}
+
+void PackedBits::mid(int pos, int n, PackedBits &out) const {
+  assert(&out != this);
+  assert(pos >= 0 && n >= 0 && pos + n <= nbits);
+  out.resize(n);
+  uchar *d = out.data();
+  const uchar *s = constData() + (pos >> 3);
+  const int shift = pos & 7;
+  for (int j = 0; j < (n + 7) / 8; j++)
+    d[j] = (s[j] | (s[j + 1] << 8)) >> shift;
+  out.clearTail();
+}
@@ -0,0 +1,42 @@
+#ifndef PACKEDBITS_H
+#define PACKEDBITS_H
+
+#include <QByteArray>
+
+// Hard bits packed eight to a byte LSB first, the order AeroL builds its
+// information field bytes in. Bits past size() are kept zero and there is
+// always a spare zero byte at the end, so bit ranges can be shifted out a
+// byte at a time without bounds checks.
+class PackedBits {
+public:
+  PackedBits() : nbits(0) { bytes.fill(0, 1); }
+
+  int size() const { return nbits; }
+  // grows with zeros
+  void resize(int n);
+  int at(int i) const {
+    return (((const uchar *)bytes.constData())[i >> 3] >> (i & 7)) & 1;
+  }
+
+  // the bits as bytes, size() / 8 whole ones then any partial one
+  const uchar *constData() const { return (const uchar *)bytes.constData(); }
+  uchar *data() { return (uchar *)bytes.data(); }
+  // just the whole bytes
+  QByteArray wholeBytes() const { return bytes.left(nbits / 8); }
+
+  // replaces the contents with n bits of an MSB first buffer, such as
+  // libcorrect's output, starting at bit from
+  void setFromMSBFirst(const uchar *src, int from, int n);
+  void append(const PackedBits &other);
+  // n bits from bit pos on into out
+  void mid(int pos, int n, PackedBits &out) const;
+
+private:
+  // zeros the bits past nbits in the last byte
+  void clearTail();
+
+  QByteArray bytes;
+  int nbits;
+};
+
+#endif // PACKEDBITS_H
@@ -0,0 +1,78 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <QtGlobal>
+
+class ACARSItem;
+
+// Data plane of a channel: demodulator stage -> soft bit sink -> frame sink.
+// Stages are wired once by Channel and called directly on the channel thread
+// with buffers owned by the producer, which are only valid for the duration
+// of the call. Qt signals are kept for control plane events only (signal
+// status, DCD, frequency changes).
+
+// Soft bits are 1..255 with 128 as the decision point, one byte each so a
+// block of them is what the Viterbi decoder reads. 0 marks the start of a
+// burst.
+typedef quint8 SoftBit;
+const SoftBit SOFT_BIT_BURST_START = 0;
+
+class SoftBitSink {
+public:
+  virtual ~SoftBitSink() {}
+
+  virtual void processSoftBits(const SoftBit *bits, int count) = 0;
+};
+
+class FrameSink {
+public:
+  virtual ~FrameSink() {}
+
+  virtual void processFrame(ACARSItem &item) = 0;
+};
+
+// When the continuous demodulators run the coarse frequency estimator
+enum CoarseEstimatePolicy {
+  CoarseFull,     // 75% overlapped windows all the time
+  CoarseAdaptive, // full rate until DCD has held, then the tracking rate
+  CoarseTracking  // about one window a second all the time
+};
+
+// Snapshot of a demodulator's state, pulled on demand instead of the GUI
+// feeds JAERO pushed every 150 ms
+struct DemodMetrics {
+  double peak;  // largest input sample magnitude since the last snapshot
+  double ebno;  // dB
+  double mse;   // constellation error, below the signal threshold when locked
+  double freq;  // Hz, carrier being tracked
+
+  // coarse estimator windows run since the last snapshot
+  int coarseEstimates;
+
+  DemodMetrics() : peak(0), ebno(0), mse(0), freq(0), coarseEstimates(0) {}
+};
+
+class DemodulatorStage {
+public:
+  DemodulatorStage() : softBitSink(nullptr) {}
+  virtual ~DemodulatorStage() {}
+
+  // Samples are little endian int16 PCM
+  virtual void processAudio(const char *data, qint64 len,
+                            quint32 sampleRate) = 0;
+
+  // Call on the channel thread, resets the peak and counters
+  virtual DemodMetrics getMetrics() = 0;
+
+  // Burst demodulators estimate the carrier per burst so only the
+  // continuous ones have an estimator to schedule
+  virtual void setCoarseEstimatePolicy(CoarseEstimatePolicy) {}
+  virtual void setCoarseEstimateDCD(bool) {}
+
+  void setSoftBitSink(SoftBitSink *sink) { softBitSink = sink; }
+
+protected:
+  SoftBitSink *softBitSink;
+};
+
+#endif
@@ -0,0 +1,140 @@
+// Checks the in tree Viterbi decoder for the Aero code against libcorrect,
+// which still decodes every other code. Blocks are encoded by libcorrect,
+// turned into noisy soft bits, some with runs of erasures, and decoded by
+// libcorrect and by ViterbiK7 with each kernel this CPU can run. Every kernel
+// has to give libcorrect's bits exactly.
+
+#include "viterbikernel.h"
+
+extern "C" {
+#include "correct.h"
+}
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// soft bits per encoded bit, 0 a certain 0 and 255 a certain 1
+const double SOFT_ONE = 255.0;
+const unsigned char SOFT_ERASURE = 128;
+
+struct CheckCase {
+  const char *name;
+  int blocks;
+  int bytes;       // message length, the encoder adds the zero tail
+  double sigma;    // gaussian noise in soft bit units
+  int erasureRuns; // runs of erasures dropped at random in each block
+  int erasureLen;
+  int tailErasures; // erased bits at the end, as Decode_Continuous pads
+};
+
+// libcorrect traces back whole blocks of up to 140 sets, as ViterbiK7 always
+// does, but decides longer ones in windows from the best state 35 sets back.
+// The two only have to agree there while the survivors merge within that, so
+// heavy noise and long erasure runs are checked on 16 byte blocks.
+static const CheckCase cases[] = {
+    {"clean", 25, 64, 0, 0, 0, 0},
+    {"noisy", 25, 300, 50, 0, 0, 0},
+    {"short erasure runs", 25, 300, 40, 8, 12, 0},
+    {"very noisy", 200, 16, 100, 0, 0, 0},
+    {"long erasure runs", 200, 16, 50, 1, 64, 0},
+    {"erased tail", 200, 16, 50, 0, 0, 96},
+};
+
+static int bitAt(const std::vector<unsigned char> &bytes, int i) {
+  return (bytes[i >> 3] >> (7 - (i & 7))) & 1;
+}
+
+static std::vector<unsigned char>
+makeSoft(const CheckCase &c, const std::vector<unsigned char> &enc, int nbits,
+         std::mt19937 &rng) {
+  std::normal_distribution<double> noise(0.0, c.sigma > 0 ? c.sigma : 1.0);
+  std::vector<unsigned char> soft(nbits);
+  for (int i = 0; i < nbits; i++) {
+    double v = bitAt(enc, i) * SOFT_ONE;
+    if (c.sigma > 0)
+      v += noise(rng);
+    soft[i] = (unsigned char)std::lround(std::min(SOFT_ONE, std::max(0.0, v)));
+  }
+
+  for (int i = std::max(0, nbits - c.tailErasures); i < nbits; i++)
+    soft[i] = SOFT_ERASURE;
+
+  std::uniform_int_distribution<int> start(0, nbits - c.erasureLen);
+  for (int r = 0; r < c.erasureRuns; r++) {
+    const int s = start(rng);
+    for (int i = s; i < s + c.erasureLen; i++)
+      soft[i] = SOFT_ERASURE;
+  }
+
+  return soft;
+}
+
+int main() {
+  const std::vector<KernelVariant<ViterbiK7Kernel>> &kernels =
+      viterbiK7Kernels().variants();
+
+  correct_convolutional_polynomial_t poly[2] = {VITERBI_K7_POLY_A,
+                                                VITERBI_K7_POLY_B};
+  correct_convolutional *conv = correct_convolutional_create(2, 7, poly);
+
+  std::mt19937 rng(20240917);
+  std::uniform_int_distribution<int> byte(0, 255);
+  int failures = 0;
+
+  for (const CheckCase &c : cases) {
+    std::vector<int> differing(kernels.size(), 0);
+    int referenceErrors = 0;
+
+    for (int block = 0; block < c.blocks; block++) {
+      std::vector<unsigned char> msg(c.bytes);
+      for (unsigned char &b : msg)
+        b = (unsigned char)byte(rng);
+
+      const int nbits =
+          (int)correct_convolutional_encode_len(conv, msg.size());
+      std::vector<unsigned char> enc((nbits + 7) / 8);
+      correct_convolutional_encode(conv, msg.data(), msg.size(), enc.data());
+
+      const std::vector<unsigned char> soft = makeSoft(c, enc, nbits, rng);
+
+      std::vector<unsigned char> expected(nbits / 2 / 8 + 1);
+      correct_convolutional_decode_soft(conv, soft.data(), nbits,
+                                        expected.data());
+      for (int i = 0; i < c.bytes * 8; i++)
+        referenceErrors += bitAt(expected, i) != bitAt(msg, i);
+
+      for (size_t k = 0; k < kernels.size(); k++) {
+        ViterbiK7 viterbi(kernels[k].kernel);
+        std::vector<unsigned char> out((nbits / 2 + 7) / 8);
+        viterbi.decodeSoft(soft.data(), nbits, out.data());
+        for (int i = 0; i < c.bytes * 8; i++)
+          differing[k] += bitAt(out, i) != bitAt(expected, i);
+      }
+    }
+
+    // a clean block that libcorrect gets wrong means the check itself is
+    // broken, not the decoder
+    if (c.sigma == 0 && c.erasureRuns == 0 && c.tailErasures == 0 &&
+        referenceErrors != 0) {
+      printf("FAIL %s: libcorrect decoded %d bits wrong\n", c.name,
+             referenceErrors);
+      failures++;
+    }
+
+    for (size_t k = 0; k < kernels.size(); k++) {
+      const bool ok = differing[k] == 0;
+      printf("%s %s, %s kernel: %d of %d bits differ from libcorrect "
+             "(%d bit errors)\n",
+             ok ? "ok  " : "FAIL", c.name, cpuFeatureName(kernels[k].feature),
+             differing[k], c.blocks * c.bytes * 8, referenceErrors);
+      if (!ok)
+        failures++;
+    }
+  }
+
+  correct_convolutional_destroy(conv);
+  return failures == 0 ? 0 : 1;
+}
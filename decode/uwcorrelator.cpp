@@ -0,0 +1,339 @@
+#include "uwcorrelator.h"
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define UWCORRELATOR_X86
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define UWCORRELATOR_NEON
+#endif
+
+// the low len bits
+static inline uint64_t lengthMask(int len) {
+  return len >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << len) - 1;
+}
+
+// the 64 bits of words from bit q on
+static inline uint64_t bitsFrom(const uint64_t *words, int q) {
+  const int w = q >> 6;
+  const int sh = q & 63;
+  return (words[w] >> sh) | ((words[w + 1] << 1) << (63 - sh));
+}
+
+// the even bits of x packed into the low half
+static inline uint64_t evenBits(uint64_t x) {
+  x &= 0x5555555555555555ULL;
+  x = (x | (x >> 1)) & 0x3333333333333333ULL;
+  x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+  x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+  x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+  x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+  return x;
+}
+
+static void hardBitPackScalar(const unsigned char *soft, int n,
+                              uint64_t *words) {
+  memset(words, 0, sizeof(uint64_t) * ((n + 63) / 64));
+  for (int i = 0; i < n; i++)
+    words[i >> 6] |= (uint64_t)(soft[i] >> 7) << (i & 63);
+}
+
+// windows are the arm bits 64 + k - len + 1 to 64 + k, the first word of the
+// arm buffer being the bits from before
+static void uwDistancesScalar(const uint64_t *words, int n, int len,
+                              uint64_t pattern, uint8_t *dist) {
+  const uint64_t mask = lengthMask(len);
+  for (int k = 0; k < n; k++) {
+    const uint64_t win = bitsFrom(words, 64 + k - len + 1);
+    dist[k] = __builtin_popcountll((win ^ pattern) & mask);
+  }
+}
+
+#ifdef UWCORRELATOR_X86
+
+// the sign bit of each byte is its hard decision, so movemask packs them
+__attribute__((target("sse2"))) static void
+hardBitPackSSE(const unsigned char *soft, int n, uint64_t *words) {
+  int i = 0;
+  for (; i + 64 <= n; i += 64) {
+    uint64_t w = 0;
+    for (int k = 0; k < 4; k++) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(soft + i + 16 * k));
+      w |= (uint64_t)(uint16_t)_mm_movemask_epi8(v) << (16 * k);
+    }
+    words[i >> 6] = w;
+  }
+  if (i < n)
+    hardBitPackScalar(soft + i, n - i, words + (i >> 6));
+}
+
+__attribute__((target("avx2"))) static void
+hardBitPackAVX2(const unsigned char *soft, int n, uint64_t *words) {
+  int i = 0;
+  for (; i + 64 <= n; i += 64) {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)(soft + i));
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)(soft + i + 32));
+    words[i >> 6] = (uint64_t)(uint32_t)_mm256_movemask_epi8(v0) |
+                    (uint64_t)(uint32_t)_mm256_movemask_epi8(v1) << 32;
+  }
+  if (i < n)
+    hardBitPackScalar(soft + i, n - i, words + (i >> 6));
+}
+
+// without popcnt __builtin_popcountll is a library call per window
+__attribute__((target("popcnt"))) static void
+uwDistancesPopcnt(const uint64_t *words, int n, int len, uint64_t pattern,
+                  uint8_t *dist) {
+  const uint64_t mask = lengthMask(len);
+  for (int k = 0; k < n; k++) {
+    const uint64_t win = bitsFrom(words, 64 + k - len + 1);
+    dist[k] = __builtin_popcountll((win ^ pattern) & mask);
+  }
+}
+
+#endif
+
+#ifdef UWCORRELATOR_NEON
+
+// sign bits weighted by their place in each half and summed across
+static void hardBitPackNEON(const unsigned char *soft, int n,
+                            uint64_t *words) {
+  static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                      1, 2, 4, 8, 16, 32, 64, 128};
+  const uint8x16_t wt = vld1q_u8(weights);
+  int i = 0;
+  for (; i + 64 <= n; i += 64) {
+    uint64_t w = 0;
+    for (int k = 0; k < 4; k++) {
+      int8x16_t v = vreinterpretq_s8_u8(vld1q_u8(soft + i + 16 * k));
+      uint8x16_t b = vandq_u8(vreinterpretq_u8_s8(vshrq_n_s8(v, 7)), wt);
+      w |= (uint64_t)vaddv_u8(vget_low_u8(b)) << (16 * k);
+      w |= (uint64_t)vaddv_u8(vget_high_u8(b)) << (16 * k + 8);
+    }
+    words[i >> 6] = w;
+  }
+  if (i < n)
+    hardBitPackScalar(soft + i, n - i, words + (i >> 6));
+}
+
+#endif
+
+const KernelDispatch<HardBitPackKernel> &hardBitPackKernels() {
+  static const KernelDispatch<HardBitPackKernel> kernels("hard bit pack", {
+#if defined(UWCORRELATOR_X86)
+    {CPU_AVX2, hardBitPackAVX2},
+    {CPU_SSE2, hardBitPackSSE},
+#elif defined(UWCORRELATOR_NEON)
+    {CPU_NEON, hardBitPackNEON},
+#endif
+    {CPU_SCALAR, hardBitPackScalar}
+  });
+  return kernels;
+}
+
+static const KernelDispatch<UWDistanceKernel> &uwDistanceKernels() {
+  static const KernelDispatch<UWDistanceKernel> kernels("UW distance", {
+#if defined(UWCORRELATOR_X86)
+    {CPU_POPCNT, uwDistancesPopcnt},
+#endif
+    {CPU_SCALAR, uwDistancesScalar}
+  });
+  return kernels;
+}
+
+UWCorrelator::UWCorrelator() {
+  patterns[0] = patterns[1] = 0;
+  npatterns = 1;
+  len = 1;
+  arms = 1;
+  tollerence = 0;
+  invariant = false;
+  clearonhit = false;
+  reset();
+
+  pack = hardBitPackKernels().best();
+  distances = uwDistanceKernels().best();
+}
+
+// LSB first with the oldest bit in bit 0, the order the hard bits are packed
+static uint64_t lsbFirst(quint64 bitpattern, int len) {
+  uint64_t pattern = 0;
+  for (int j = 0; j < len; j++)
+    if ((bitpattern >> (len - 1 - j)) & 1)
+      pattern |= (uint64_t)1 << j;
+  return pattern;
+}
+
+bool UWCorrelator::setPattern(quint64 bitpattern, int _len) {
+  if (_len < 1 || _len > UW_MAX_LENGTH)
+    return false;
+  const uint64_t pattern = lsbFirst(bitpattern, _len);
+  if (npatterns == 1 && len == _len && patterns[0] == pattern)
+    return true;
+  patterns[0] = pattern;
+  npatterns = 1;
+  len = _len;
+  reset();
+  return true;
+}
+
+bool UWCorrelator::setPatterns(quint64 bitpattern1, quint64 bitpattern2,
+                               int _len) {
+  if (_len < 1 || _len > UW_MAX_LENGTH)
+    return false;
+  const uint64_t pattern1 = lsbFirst(bitpattern1, _len);
+  const uint64_t pattern2 = lsbFirst(bitpattern2, _len);
+  if (npatterns == 2 && len == _len && patterns[0] == pattern1 &&
+      patterns[1] == pattern2)
+    return true;
+  patterns[0] = pattern1;
+  patterns[1] = pattern2;
+  npatterns = 2;
+  len = _len;
+  reset();
+  return true;
+}
+
+void UWCorrelator::setArms(int _arms) {
+  _arms = qBound(1, _arms, UW_MAX_ARMS);
+  if (_arms == arms)
+    return;
+  arms = _arms;
+  reset();
+}
+
+void UWCorrelator::setTollerence(int _tollerence) {
+  tollerence = _tollerence;
+}
+
+void UWCorrelator::setPhaseInvariant(bool _invariant) {
+  invariant = _invariant;
+}
+
+void UWCorrelator::setClearOnHit(bool clear) { clearonhit = clear; }
+
+void UWCorrelator::reset() {
+  for (int a = 0; a < UW_MAX_ARMS; a++)
+    history[a] = 0;
+}
+
+const QVector<UWHit> &UWCorrelator::search(const SoftBit *bits, int count,
+                                           int firstarm) {
+  hits.clear();
+  if (count <= 0)
+    return hits;
+
+  // markers only come at the start of bursts, so it's cheaper to look for
+  // them first than to skip them while packing
+  const SoftBit *src = bits;
+  int n = count;
+  posmap.clear();
+  if (memchr(bits, SOFT_BIT_BURST_START, count)) {
+    compact.resize(count);
+    posmap.resize(count);
+    n = 0;
+    for (int i = 0; i < count; i++) {
+      if (bits[i] == SOFT_BIT_BURST_START)
+        continue;
+      compact[n] = bits[i];
+      posmap[n] = i;
+      n++;
+    }
+    src = compact.constData();
+  }
+  if (n == 0)
+    return hits;
+
+  const int nwords = (n + 63) / 64;
+  words.resize(nwords + 1);
+  words[nwords] = 0;
+  pack(src, n, words.data());
+
+  if (arms == 1) {
+    // one spare word in front for the history and one behind so windows can
+    // always read two
+    armwords.resize(nwords + 2);
+    armwords[0] = history[0];
+    memcpy(armwords.data() + 1, words.constData(), sizeof(uint64_t) * nwords);
+    armwords[nwords + 1] = 0;
+    searchArm(0, n, 0, 1);
+  } else {
+    for (int arm = 0; arm < 2; arm++) {
+      // bits 2k + offset of the buffer are on this arm
+      const int offset = (arm - firstarm) & 1;
+      const int nbits = (n - offset + 1) / 2;
+      const int narmwords = (nbits + 63) / 64;
+      armwords.resize(narmwords + 2);
+      armwords[0] = history[arm];
+      for (int j = 0; j < narmwords; j++) {
+        const uint64_t lo = evenBits(words.at(2 * j) >> offset);
+        const uint64_t hi = 2 * j + 1 < nwords
+                                ? evenBits(words.at(2 * j + 1) >> offset)
+                                : 0;
+        armwords[j + 1] = lo | (hi << 32);
+      }
+      armwords[narmwords + 1] = 0;
+      if (nbits > 0)
+        searchArm(arm, nbits, offset, 2);
+    }
+    std::sort(hits.begin(), hits.end(),
+              [](const UWHit &a, const UWHit &b) { return a.pos < b.pos; });
+  }
+
+  if (!posmap.isEmpty()) {
+    for (int h = 0; h < hits.size(); h++)
+      hits[h].pos = posmap.at(hits.at(h).pos);
+  }
+
+  return hits;
+}
+
+void UWCorrelator::searchArm(int arm, int nbits, int offset, int stride) {
+  uint64_t *a = armwords.data();
+  for (int p = 0; p < npatterns; p++) {
+    dist[p].resize(nbits);
+    distances(a, nbits, len, patterns[p], dist[p].data());
+  }
+
+  const int maxinverted = len - tollerence;
+  for (int k = 0; k < nbits; k++) {
+    UWHit hit;
+    hit.pattern = -1;
+    for (int p = 0; p < npatterns && hit.pattern < 0; p++) {
+      const int d = dist[p].at(k);
+      if (invariant && d >= maxinverted) {
+        hit.pattern = p;
+        hit.inverted = true;
+        hit.errors = len - d;
+      } else if (d <= tollerence) {
+        hit.pattern = p;
+        hit.inverted = false;
+        hit.errors = d;
+      }
+    }
+    if (hit.pattern < 0)
+      continue;
+
+    hit.pos = offset + stride * k;
+    hit.arm = arm;
+    hits.push_back(hit);
+
+    if (clearonhit) {
+      // zero the unique word's bits and redo the windows that overlap it
+      const int b = 64 + k;
+      a[b >> 6] &= ~((2ULL << (b & 63)) - 1);
+      a[(b >> 6) - 1] = 0;
+      const uint64_t mask = lengthMask(len);
+      for (int j = k + 1; j < qMin(k + len, nbits); j++) {
+        const uint64_t win = bitsFrom(a, 64 + j - len + 1);
+        for (int p = 0; p < npatterns; p++)
+          dist[p][j] = __builtin_popcountll((win ^ patterns[p]) & mask);
+      }
+    }
+  }
+
+  history[arm] = bitsFrom(a, nbits);
+}
@@ -0,0 +1,89 @@
+#ifndef UWCORRELATOR_H
+#define UWCORRELATOR_H
+
+#include "cpudispatch.h"
+#include "pipeline.h"
+#include <QVector>
+#include <stdint.h>
+
+// unique words are held in one 64 bit register
+const int UW_MAX_LENGTH = 64;
+// OQPSK carries its unique words on the I and Q bits separately
+const int UW_MAX_ARMS = 2;
+
+// Packs the hard decisions of n soft bits, 1 for 128 and up, LSB first into
+// (n + 63) / 64 words
+typedef void (*HardBitPackKernel)(const unsigned char *soft, int n,
+                                  uint64_t *words);
+
+// The hard bit packers built for this CPU
+const KernelDispatch<HardBitPackKernel> &hardBitPackKernels();
+
+// Distance of each of n windows to pattern, see uwcorrelator.cpp
+typedef void (*UWDistanceKernel)(const uint64_t *words, int n, int len,
+                                 uint64_t pattern, uint8_t *dist);
+
+struct UWHit {
+  int pos;       // index of the last bit of the unique word in the buffer
+  int arm;       // arm the unique word was found on
+  int pattern;   // 0 for the first unique word, 1 for the second
+  bool inverted; // the complement matched so the arm's bits are inverted
+  int errors;
+};
+
+// Unique word search over whole buffers of soft bits. The hard decisions are
+// packed 64 to a word and every window is compared against the unique words
+// with a single popcount, which gives the distance to the inverted word for
+// free, so there is no per bit shift register and nearly no branching. The
+// last bits of each arm are kept so unique words spanning buffers are found.
+class UWCorrelator {
+public:
+  UWCorrelator();
+
+  // oldest bit in the MSB, as with PreambleDetector
+  bool setPattern(quint64 bitpattern, int len);
+  bool setPatterns(quint64 bitpattern1, quint64 bitpattern2, int len);
+  // 1 for BPSK and MSK, 2 for OQPSK where every other bit is on the same arm
+  void setArms(int arms);
+  // number of bit errors a unique word may have
+  void setTollerence(int tollerence);
+  // also match the complement of the unique words
+  void setPhaseInvariant(bool invariant);
+  // forget the bits of a unique word once found, so it can't overlap the
+  // next one
+  void setClearOnHit(bool clear);
+  void reset();
+
+  // Finds all unique words ending in bits[0..count), in order. Burst start
+  // markers are skipped as they are not bits, and firstarm is the arm of the
+  // first bit that isn't one. At most one hit is given per bit, the first
+  // unique word taking precedence and an inverted match over a normal one.
+  const QVector<UWHit> &search(const SoftBit *bits, int count,
+                               int firstarm = 0);
+
+private:
+  void searchArm(int arm, int nbits, int offset, int stride);
+
+  uint64_t patterns[2];
+  int npatterns;
+  int len;
+  int arms;
+  int tollerence;
+  bool invariant;
+  bool clearonhit;
+
+  // the last 64 bits of each arm, newest in the MSB
+  uint64_t history[UW_MAX_ARMS];
+
+  HardBitPackKernel pack;
+  UWDistanceKernel distances;
+
+  QVector<SoftBit> compact;
+  QVector<int> posmap;
+  QVector<uint64_t> words;
+  QVector<uint64_t> armwords;
+  QVector<uint8_t> dist[2];
+  QVector<UWHit> hits;
+};
+
+#endif // UWCORRELATOR_H
@@ -0,0 +1,290 @@
+#include "viterbikernel.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VITERBIKERNEL_X86
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define VITERBIKERNEL_NEON
+#endif
+
+// sum of the branch metrics of a pair of complementary outputs
+const int BRANCH_SUM = 2 * 255;
+
+// start metric of the states a block can't be in yet, larger than the spread
+// of 6 branches so the warm up only ever extends paths out of state 0
+const int16_t UNREACHED_METRIC = 4096;
+
+// The states are the last 6 input bits, newest in the LSB. States 2j and
+// 2j + 1 are both entered from j and j + 32, and as both polynomials tap the
+// newest and oldest bits the four branches of such a butterfly only take two
+// outputs, complements of each other. a and b hold the outputs of the branch
+// from j into 2j as 0 or 255, so the branch metric is (y0 ^ a) + (y1 ^ b)
+struct ViterbiK7Branches {
+  int16_t a[VITERBI_K7_STATES / 2];
+  int16_t b[VITERBI_K7_STATES / 2];
+
+  ViterbiK7Branches() {
+    for (int j = 0; j < VITERBI_K7_STATES / 2; j++) {
+      a[j] = __builtin_parity((2 * j) & VITERBI_K7_POLY_A) ? 255 : 0;
+      b[j] = __builtin_parity((2 * j) & VITERBI_K7_POLY_B) ? 255 : 0;
+    }
+  }
+};
+
+static const ViterbiK7Branches branches;
+
+// metrics only matter relative to each other, so they are pulled back to
+// state 0 every 16 sets to keep them well inside 16 bits
+static inline bool renormalize(int t, int sets) {
+  return (t & 15) == 15 || t == sets - 1;
+}
+
+void viterbiK7Scalar(const unsigned char *soft, int sets, int16_t *metrics,
+                     uint64_t *decisions) {
+  int16_t next[VITERBI_K7_STATES];
+
+  for (int t = 0; t < sets; t++) {
+    const int y0 = soft[2 * t];
+    const int y1 = soft[2 * t + 1];
+    uint64_t dec = 0;
+
+    for (int j = 0; j < VITERBI_K7_STATES / 2; j++) {
+      const int d = (y0 ^ branches.a[j]) + (y1 ^ branches.b[j]);
+      const int dc = BRANCH_SUM - d;
+      const int m0 = metrics[j];
+      const int m1 = metrics[j + VITERBI_K7_STATES / 2];
+
+      const int e0 = m0 + d, e1 = m1 + dc;
+      const int o0 = m0 + dc, o1 = m1 + d;
+      next[2 * j] = e1 < e0 ? e1 : e0;
+      next[2 * j + 1] = o1 < o0 ? o1 : o0;
+      dec |= (uint64_t)(e1 < e0) << (2 * j);
+      dec |= (uint64_t)(o1 < o0) << (2 * j + 1);
+    }
+
+    const int16_t base = renormalize(t, sets) ? next[0] : 0;
+    for (int s = 0; s < VITERBI_K7_STATES; s++)
+      metrics[s] = next[s] - base;
+    decisions[t] = dec;
+  }
+}
+
+#ifdef VITERBIKERNEL_X86
+
+// eight butterflies per register: the new metrics come out as even and odd
+// states, which interleave back into state order for the next set
+__attribute__((target("sse2"))) static void
+viterbiK7SSE(const unsigned char *soft, int sets, int16_t *metrics,
+             uint64_t *decisions) {
+  __m128i a[4], b[4], m[8], next[8];
+  for (int k = 0; k < 4; k++) {
+    a[k] = _mm_loadu_si128((const __m128i *)(branches.a + 8 * k));
+    b[k] = _mm_loadu_si128((const __m128i *)(branches.b + 8 * k));
+  }
+  for (int k = 0; k < 8; k++)
+    m[k] = _mm_loadu_si128((const __m128i *)(metrics + 8 * k));
+  const __m128i sum = _mm_set1_epi16(BRANCH_SUM);
+
+  for (int t = 0; t < sets; t++) {
+    const __m128i y0 = _mm_set1_epi16(soft[2 * t]);
+    const __m128i y1 = _mm_set1_epi16(soft[2 * t + 1]);
+    uint64_t dec = 0;
+
+    for (int k = 0; k < 4; k++) {
+      __m128i d =
+          _mm_add_epi16(_mm_xor_si128(y0, a[k]), _mm_xor_si128(y1, b[k]));
+      __m128i dc = _mm_sub_epi16(sum, d);
+
+      __m128i e0 = _mm_add_epi16(m[k], d), e1 = _mm_add_epi16(m[k + 4], dc);
+      __m128i o0 = _mm_add_epi16(m[k], dc), o1 = _mm_add_epi16(m[k + 4], d);
+      __m128i e = _mm_min_epi16(e0, e1), o = _mm_min_epi16(o0, o1);
+      __m128i de = _mm_cmpgt_epi16(e0, e1), dO = _mm_cmpgt_epi16(o0, o1);
+
+      next[2 * k] = _mm_unpacklo_epi16(e, o);
+      next[2 * k + 1] = _mm_unpackhi_epi16(e, o);
+      __m128i bits = _mm_packs_epi16(_mm_unpacklo_epi16(de, dO),
+                                     _mm_unpackhi_epi16(de, dO));
+      dec |= (uint64_t)(unsigned)_mm_movemask_epi8(bits) << (16 * k);
+    }
+
+    if (renormalize(t, sets)) {
+      __m128i base = _mm_shufflelo_epi16(next[0], 0);
+      base = _mm_unpacklo_epi64(base, base);
+      for (int k = 0; k < 8; k++)
+        m[k] = _mm_sub_epi16(next[k], base);
+    } else {
+      for (int k = 0; k < 8; k++)
+        m[k] = next[k];
+    }
+    decisions[t] = dec;
+  }
+
+  for (int k = 0; k < 8; k++)
+    _mm_storeu_si128((__m128i *)(metrics + 8 * k), m[k]);
+}
+
+// sixteen butterflies per register. The unpacks interleave within 128 bit
+// lanes, so the metrics are put back in state order with a lane permute while
+// the decisions already pack into state order
+__attribute__((target("avx2"))) static void
+viterbiK7AVX2(const unsigned char *soft, int sets, int16_t *metrics,
+              uint64_t *decisions) {
+  __m256i a[2], b[2], m[4], next[4];
+  for (int k = 0; k < 2; k++) {
+    a[k] = _mm256_loadu_si256((const __m256i *)(branches.a + 16 * k));
+    b[k] = _mm256_loadu_si256((const __m256i *)(branches.b + 16 * k));
+  }
+  for (int k = 0; k < 4; k++)
+    m[k] = _mm256_loadu_si256((const __m256i *)(metrics + 16 * k));
+  const __m256i sum = _mm256_set1_epi16(BRANCH_SUM);
+
+  for (int t = 0; t < sets; t++) {
+    const __m256i y0 = _mm256_set1_epi16(soft[2 * t]);
+    const __m256i y1 = _mm256_set1_epi16(soft[2 * t + 1]);
+    uint64_t dec = 0;
+
+    for (int k = 0; k < 2; k++) {
+      __m256i d = _mm256_add_epi16(_mm256_xor_si256(y0, a[k]),
+                                   _mm256_xor_si256(y1, b[k]));
+      __m256i dc = _mm256_sub_epi16(sum, d);
+
+      __m256i e0 = _mm256_add_epi16(m[k], d);
+      __m256i e1 = _mm256_add_epi16(m[k + 2], dc);
+      __m256i o0 = _mm256_add_epi16(m[k], dc);
+      __m256i o1 = _mm256_add_epi16(m[k + 2], d);
+      __m256i e = _mm256_min_epi16(e0, e1), o = _mm256_min_epi16(o0, o1);
+      __m256i de = _mm256_cmpgt_epi16(e0, e1);
+      __m256i dO = _mm256_cmpgt_epi16(o0, o1);
+
+      __m256i lo = _mm256_unpacklo_epi16(e, o);
+      __m256i hi = _mm256_unpackhi_epi16(e, o);
+      next[2 * k] = _mm256_permute2x128_si256(lo, hi, 0x20);
+      next[2 * k + 1] = _mm256_permute2x128_si256(lo, hi, 0x31);
+      __m256i bits = _mm256_packs_epi16(_mm256_unpacklo_epi16(de, dO),
+                                        _mm256_unpackhi_epi16(de, dO));
+      dec |= (uint64_t)(uint32_t)_mm256_movemask_epi8(bits) << (32 * k);
+    }
+
+    if (renormalize(t, sets)) {
+      __m256i base = _mm256_broadcastw_epi16(_mm256_castsi256_si128(next[0]));
+      for (int k = 0; k < 4; k++)
+        m[k] = _mm256_sub_epi16(next[k], base);
+    } else {
+      for (int k = 0; k < 4; k++)
+        m[k] = next[k];
+    }
+    decisions[t] = dec;
+  }
+
+  for (int k = 0; k < 4; k++)
+    _mm256_storeu_si256((__m256i *)(metrics + 16 * k), m[k]);
+}
+
+#endif
+
+#ifdef VITERBIKERNEL_NEON
+
+static void viterbiK7NEON(const unsigned char *soft, int sets,
+                          int16_t *metrics, uint64_t *decisions) {
+  static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                      1, 2, 4, 8, 16, 32, 64, 128};
+  const uint8x16_t weight = vld1q_u8(weights);
+
+  int16x8_t a[4], b[4], m[8], next[8];
+  for (int k = 0; k < 4; k++) {
+    a[k] = vld1q_s16(branches.a + 8 * k);
+    b[k] = vld1q_s16(branches.b + 8 * k);
+  }
+  for (int k = 0; k < 8; k++)
+    m[k] = vld1q_s16(metrics + 8 * k);
+  const int16x8_t sum = vdupq_n_s16(BRANCH_SUM);
+
+  for (int t = 0; t < sets; t++) {
+    const int16x8_t y0 = vdupq_n_s16(soft[2 * t]);
+    const int16x8_t y1 = vdupq_n_s16(soft[2 * t + 1]);
+    uint64_t dec = 0;
+
+    for (int k = 0; k < 4; k++) {
+      int16x8_t d = vaddq_s16(veorq_s16(y0, a[k]), veorq_s16(y1, b[k]));
+      int16x8_t dc = vsubq_s16(sum, d);
+
+      int16x8_t e0 = vaddq_s16(m[k], d), e1 = vaddq_s16(m[k + 4], dc);
+      int16x8_t o0 = vaddq_s16(m[k], dc), o1 = vaddq_s16(m[k + 4], d);
+      int16x8_t e = vminq_s16(e0, e1), o = vminq_s16(o0, o1);
+      uint16x8_t de = vcgtq_s16(e0, e1), dO = vcgtq_s16(o0, o1);
+
+      next[2 * k] = vzip1q_s16(e, o);
+      next[2 * k + 1] = vzip2q_s16(e, o);
+      uint8x16_t bits = vcombine_u8(vmovn_u16(vzip1q_u16(de, dO)),
+                                    vmovn_u16(vzip2q_u16(de, dO)));
+      bits = vandq_u8(bits, weight);
+      uint64_t lo = vaddv_u8(vget_low_u8(bits));
+      uint64_t hi = vaddv_u8(vget_high_u8(bits));
+      dec |= (lo | hi << 8) << (16 * k);
+    }
+
+    if (renormalize(t, sets)) {
+      int16x8_t base = vdupq_laneq_s16(next[0], 0);
+      for (int k = 0; k < 8; k++)
+        m[k] = vsubq_s16(next[k], base);
+    } else {
+      for (int k = 0; k < 8; k++)
+        m[k] = next[k];
+    }
+    decisions[t] = dec;
+  }
+
+  for (int k = 0; k < 8; k++)
+    vst1q_s16(metrics + 8 * k, m[k]);
+}
+
+#endif
+
+const KernelDispatch<ViterbiK7Kernel> &viterbiK7Kernels() {
+  static const KernelDispatch<ViterbiK7Kernel> kernels("Viterbi", {
+#if defined(VITERBIKERNEL_X86)
+    {CPU_AVX2, viterbiK7AVX2},
+    {CPU_SSE2, viterbiK7SSE},
+#elif defined(VITERBIKERNEL_NEON)
+    {CPU_NEON, viterbiK7NEON},
+#endif
+    {CPU_SCALAR, viterbiK7Scalar}
+  });
+  return kernels;
+}
+
+ViterbiK7::ViterbiK7() { kernel = viterbiK7Kernels().best(); }
+
+ViterbiK7::ViterbiK7(ViterbiK7Kernel kernel) : kernel(kernel) {}
+
+int ViterbiK7::decodeSoft(const unsigned char *soft, int nsoft,
+                          unsigned char *out) {
+  const int sets = nsoft / 2;
+  if (sets <= 0)
+    return 0;
+  if ((int)decisions.size() < sets)
+    decisions.resize(sets);
+
+  int16_t metrics[VITERBI_K7_STATES];
+  metrics[0] = 0;
+  for (int s = 1; s < VITERBI_K7_STATES; s++)
+    metrics[s] = UNREACHED_METRIC;
+  kernel(soft, sets, metrics, decisions.data());
+
+  // the tail brings the encoder back to state 0, so trace back from there.
+  // Each state's LSB is the bit that entered it, its decision the bit that
+  // dropped out the other end
+  memset(out, 0, (sets + 7) / 8);
+  int state = 0;
+  for (int t = sets - 1; t >= 0; t--) {
+    if (state & 1)
+      out[t >> 3] |= 0x80 >> (t & 7);
+    const int oldest = (decisions[t] >> state) & 1;
+    state = (state >> 1) | (oldest << 5);
+  }
+
+  return sets;
+}
@@ -0,0 +1,47 @@
+#ifndef VITERBIKERNEL_H
+#define VITERBIKERNEL_H
+
+#include "cpudispatch.h"
+#include <stdint.h>
+#include <vector>
+
+// The K=7 rate 1/2 convolutional code of the Aero standard, generator
+// polynomials 109 and 79 with the first output bit from 109
+const int VITERBI_K7_STATES = 64;
+const int VITERBI_K7_POLY_A = 109;
+const int VITERBI_K7_POLY_B = 79;
+
+// Add-compare-select over all 64 states for sets soft bit pairs. metrics holds
+// the 64 path metrics in and out, and decisions[t] gets one bit per state,
+// set when the state was entered from its predecessor with the oldest bit 1.
+// Soft bits run from 0 for a certain 0 to 255 for a certain 1 and branch
+// metrics are their linear distance, the same as libcorrect's soft decoder.
+typedef void (*ViterbiK7Kernel)(const unsigned char *soft, int sets,
+                                int16_t *metrics, uint64_t *decisions);
+
+// The add-compare-select builds for this CPU
+const KernelDispatch<ViterbiK7Kernel> &viterbiK7Kernels();
+
+void viterbiK7Scalar(const unsigned char *soft, int sets, int16_t *metrics,
+                     uint64_t *decisions);
+
+// Block Viterbi decoder for the Aero code. Each block starts in state 0 and is
+// traced back from state 0, so as with libcorrect the last 6 bits of a block
+// are taken to be the zero tail of the code.
+class ViterbiK7 {
+public:
+  ViterbiK7();
+  // runs the given kernel rather than the best one, to check them against
+  // each other
+  explicit ViterbiK7(ViterbiK7Kernel kernel);
+
+  // Decodes nsoft / 2 bits from nsoft soft bits into out, packed MSB first.
+  // out must hold (nsoft / 2 + 7) / 8 bytes. Returns the number of bits.
+  int decodeSoft(const unsigned char *soft, int nsoft, unsigned char *out);
+
+private:
+  std::vector<uint64_t> decisions;
+  ViterbiK7Kernel kernel;
+};
+
+#endif // VITERBIKERNEL_H
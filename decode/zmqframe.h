@@ -0,0 +1,37 @@
+#ifndef ZMQFRAME_H
+#define ZMQFRAME_H
+
+#include <QMetaType>
+#include <QSharedPointer>
+#include <zmq.h>
+
+// Owns one received ZeroMQ message part. The samples part of every VFO frame
+// is received straight into one of these and shared with the channel thread,
+// so the payload is never copied out of the buffer ZeroMQ allocated for it.
+class ZmqFrame {
+public:
+  ZmqFrame() : sampleRate(0) { ::zmq_msg_init(&msg); }
+  ZmqFrame(const ZmqFrame &) = delete;
+  ~ZmqFrame() { ::zmq_msg_close(&msg); }
+
+  ZmqFrame &operator=(const ZmqFrame &) = delete;
+
+  zmq_msg_t *message() { return &msg; }
+
+  const char *data() const {
+    return (const char *)::zmq_msg_data(const_cast<zmq_msg_t *>(&msg));
+  }
+  int size() const {
+    return (int)::zmq_msg_size(const_cast<zmq_msg_t *>(&msg));
+  }
+
+  quint32 sampleRate;
+
+private:
+  zmq_msg_t msg;
+};
+
+typedef QSharedPointer<ZmqFrame> ZmqFramePtr;
+Q_DECLARE_METATYPE(ZmqFramePtr)
+
+#endif
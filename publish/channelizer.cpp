@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cmath>
+
+#include "channelizer.h"
+#include "firfilter.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846264338327950288
+#endif
+
+ChannelizerFFT::ChannelizerFFT(int nfft) : nfft(nfft) {
+  int n = nfft;
+  int p = 4;
+  int limit = (int)std::floor(std::sqrt((double)n));
+
+  // factor as radix 4 first, then 2, then odd radices
+  while (n > 1) {
+    while (n % p) {
+      if (p == 4)
+        p = 2;
+      else if (p == 2)
+        p = 3;
+      else
+        p += 2;
+      if (p > limit)
+        p = n;
+    }
+    n /= p;
+    factors.push_back(p);
+    factors.push_back(n);
+  }
+
+  twiddles.resize(nfft);
+  for (int i = 0; i < nfft; i++) {
+    double phase = 2.0 * M_PI * i / nfft;
+    twiddles[i] = cpx_typef(std::cos(phase), std::sin(phase));
+  }
+
+  int maxRadix = 0;
+  for (size_t i = 0; i < factors.size(); i += 2)
+    maxRadix = std::max(maxRadix, factors[i]);
+  scratch.resize(maxRadix);
+}
+
+void ChannelizerFFT::transform(const cpx_typef *in, cpx_typef *out) {
+  work(out, in, 1, factors.data());
+}
+
+void ChannelizerFFT::work(cpx_typef *out, const cpx_typef *in, int fstride,
+                          const int *factors) {
+  const int p = factors[0];
+  const int m = factors[1];
+
+  if (m == 1) {
+    for (int i = 0; i < p; i++)
+      out[i] = in[i * fstride];
+  } else {
+    for (int i = 0; i < p; i++)
+      work(out + i * m, in + i * fstride, fstride * p, factors + 2);
+  }
+
+  // generic radix p butterfly over the p sub transforms of length m
+  for (int u = 0; u < m; u++) {
+    for (int q = 0, k = u; q < p; q++, k += m)
+      scratch[q] = out[k];
+
+    for (int q1 = 0, k = u; q1 < p; q1++, k += m) {
+      int twidx = 0;
+      cpx_typef sum = scratch[0];
+      for (int q = 1; q < p; q++) {
+        twidx += fstride * k;
+        if (twidx >= nfft)
+          twidx -= nfft;
+        sum += scratch[q] * twiddles[twidx];
+      }
+      out[k] = sum;
+    }
+  }
+}
+
+Channelizer::Channelizer(int sampleRate, int channels)
+    : sampleRate(sampleRate), channels(channels), decimation(channels / 2),
+      fft(channels) {
+  firfilter filt;
+  const double spacing = (double)sampleRate / channels;
+
+  // pass band reaches past the channel edge so a VFO anywhere in the channel
+  // keeps its bandwidth; what folds back at the 2x output rate lands beyond
+  // the residual offset range the VFO tunes in
+  QVector<float> coeff =
+      filt.low_pass(1, sampleRate, spacing, spacing / 2,
+                    firfilter::win_type::WIN_BLACKMAN, 0);
+
+  tapsPerBranch = (coeff.length() + channels - 1) / channels;
+  taps.assign(tapsPerBranch * channels, 0.0f);
+  for (int i = 0; i < coeff.length(); i++)
+    taps[i] = coeff[i];
+
+  history.assign(taps.size() - 1, cpx_typef(0, 0));
+  branch.resize(channels);
+  spectrum.resize(channels);
+  outputs.resize(channels);
+
+  hopOffset = 0;
+  hopCount = 0;
+}
+
+int Channelizer::channelForOffset(double offset, double &residual) const {
+  const double spacing = getChannelSpacing();
+  long index = std::lround(offset / spacing);
+
+  residual = offset - index * spacing;
+
+  index %= channels;
+  if (index < 0)
+    index += channels;
+
+  return (int)index;
+}
+
+void Channelizer::enableChannel(int channel) {
+  for (int c : enabled)
+    if (c == channel)
+      return;
+
+  enabled.push_back(channel);
+}
+
+void Channelizer::process(const std::vector<cpx_typef> &in) {
+  const int length = (int)taps.size();
+  const int keep = length - 1;
+
+  // delay line followed by the new block, so every hop reads back `length`
+  // samples without wrapping
+  history.resize(keep + in.size());
+  std::copy(in.begin(), in.end(), history.begin() + keep);
+
+  for (int c : enabled)
+    outputs[c].clear();
+
+  int pos = hopOffset;
+  for (; pos < (int)in.size(); pos += decimation) {
+    const cpx_typef *x = history.data() + keep + pos;
+
+    for (int k = 0; k < channels; k++) {
+      cpx_typef acc(0, 0);
+      for (int i = k; i < length; i += channels)
+        acc += taps[i] * x[-i];
+      branch[k] = acc;
+    }
+
+    fft.transform(branch.data(), spectrum.data());
+
+    // with a hop of half the branch count the odd channels come out of the
+    // FFT modulated by (-1)^n
+    for (int c : enabled) {
+      if ((c & 1) && (hopCount & 1))
+        outputs[c].push_back(-spectrum[c]);
+      else
+        outputs[c].push_back(spectrum[c]);
+    }
+
+    hopCount++;
+  }
+  hopOffset = pos - (int)in.size();
+
+  std::copy(history.end() - keep, history.end(), history.begin());
+  history.resize(keep);
+}
@@ -0,0 +1,76 @@
+#ifndef CHANNELIZER_H
+#define CHANNELIZER_H
+
+#include <complex>
+#include <vector>
+
+typedef std::complex<float> cpx_typef;
+
+// Mixed radix (4, 2, 3, 5, ...) complex FFT for the non power of two sizes
+// the channelizer needs, e.g. 80 channels at 1.92 Msps. Unscaled, with a
+// positive exponent so bin c holds the signal at +c * Fs / N.
+class ChannelizerFFT {
+public:
+  explicit ChannelizerFFT(int nfft);
+
+  void transform(const cpx_typef *in, cpx_typef *out);
+
+private:
+  void work(cpx_typef *out, const cpx_typef *in, int fstride,
+            const int *factors);
+
+  int nfft;
+  std::vector<int> factors;
+  std::vector<cpx_typef> twiddles;
+  std::vector<cpx_typef> scratch;
+};
+
+// Oversampled (2x) polyphase analysis filter bank. The wideband stream is
+// split once into `channels` evenly spaced channels, each coming out at
+// 2 * Fs / channels, so per VFO work is reduced to fine tuning and the final
+// decimation instead of mixing and decimating the full rate stream.
+class Channelizer {
+public:
+  Channelizer(int sampleRate, int channels);
+  Channelizer(const Channelizer &) = delete;
+
+  Channelizer &operator=(const Channelizer &) = delete;
+
+  int getChannelCount() const { return channels; }
+  int getChannelRate() const { return 2 * sampleRate / channels; }
+  int getDecimation() const { return decimation; }
+  double getChannelSpacing() const { return (double)sampleRate / channels; }
+
+  // Channel holding a signal at `offset` Hz from the center frequency, with
+  // the residual offset from the channel center stored in `residual`
+  int channelForOffset(double offset, double &residual) const;
+
+  // Only enabled channels are copied out of the FFT
+  void enableChannel(int channel);
+
+  void process(const std::vector<cpx_typef> &in);
+  const std::vector<cpx_typef> &output(int channel) const {
+    return outputs[channel];
+  }
+
+private:
+  int sampleRate;
+  int channels;
+  int decimation;
+  int tapsPerBranch;
+
+  std::vector<float> taps;
+  std::vector<cpx_typef> history;
+  std::vector<cpx_typef> branch;
+  std::vector<cpx_typef> spectrum;
+
+  std::vector<int> enabled;
+  std::vector<std::vector<cpx_typef>> outputs;
+
+  ChannelizerFFT fft;
+
+  int hopOffset;
+  long long hopCount;
+};
+
+#endif // CHANNELIZER_H
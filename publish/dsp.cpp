@@ -50,6 +50,9 @@ FIR::FIR(int _NumberOfPoints, int queuesz) {
   for (i = 0; i < queuesz + NumberOfPoints; i++)
     queue[i] = 0;
   queuePtr = _NumberOfPoints;
+
+  blockBuff.assign(NumberOfPoints, 0);
+  blockKernel = firBlockKernels().best();
 }
 
 FIR::~FIR() {
@@ -171,6 +174,18 @@ void FIR::FIRQueueBackToFront() {
   queuePtr = NumberOfPoints;
 }
 
+void FIR::FIRProcessBlock(const float *in, float *out, int n) {
+  // like FIRUpdateAndProcess the window ends one sample before the newest
+  blockBuff.resize(NumberOfPoints + n);
+  std::copy(in, in + n, blockBuff.begin() + NumberOfPoints);
+
+  blockKernel(blockBuff.data(), out, n, points, NumberOfPoints, 1);
+
+  std::copy(blockBuff.end() - NumberOfPoints, blockBuff.end(),
+            blockBuff.begin());
+  blockBuff.resize(NumberOfPoints);
+}
+
 void FIR::FIRSetPoint(int point, float value) {
 
   if ((point < 0) || (point >= NumberOfPoints))
@@ -212,6 +227,27 @@ FIRHilbert::FIRHilbert(int len, int Fs) {
   for (int i = 0; i < len; i++) {
     points[i] = tempCoeffs[len - i - 1] / gain;
   }
+
+  // every other tap is zero, keep the others for the block path
+  blockFirst = ((len - 1 - len / 2) % 2 == 1) ? 0 : 1;
+  for (int i = blockFirst; i < len; i += 2)
+    blockPoints.push_back(points[i]);
+
+  blockBuff.assign(len - 1, 0);
+  blockKernel = firBlockKernels().best();
+}
+
+void FIRHilbert::FIRProcessBlock(const float *in, float *out, int n) {
+  const int history = NumberOfPoints - 1;
+
+  blockBuff.resize(history + n);
+  std::copy(in, in + n, blockBuff.begin() + history);
+
+  blockKernel(blockBuff.data() + blockFirst, out, n, blockPoints.data(),
+              (int)blockPoints.size(), 2);
+
+  std::copy(blockBuff.end() - history, blockBuff.end(), blockBuff.begin());
+  blockBuff.resize(history);
 }
 double FIRHilbert::FIRUpdateAndProcess(float sig) {
   buff[ptr] = sig;
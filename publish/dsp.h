@@ -30,6 +30,8 @@ SOFTWARE.*/
 #include <math.h>
 #include <vector>
 
+#include "firkernel.h"
+
 class FIR {
 public:
   FIR(int _NumberOfPoints, int queuesz);
@@ -54,6 +56,12 @@ public:
   void FIRQueueBackToFront();
   float *queue;
   int queuePtr;
+
+  // Same response as FIRUpdateAndProcess over a whole block, in may equal
+  // out. Keeps its own history, so don't mix with the per sample calls.
+  void FIRProcessBlock(const float *in, float *out, int n);
+  std::vector<float> blockBuff;
+  FirBlockKernel blockKernel;
 };
 
 class FIRHilbert {
@@ -69,6 +77,13 @@ public:
   int ptr;
   int M;
   float outsum;
+
+  // Block version skipping the zero taps, same rules as FIR::FIRProcessBlock
+  void FIRProcessBlock(const float *in, float *out, int n);
+  std::vector<float> blockBuff;
+  std::vector<float> blockPoints;
+  int blockFirst;
+  FirBlockKernel blockKernel;
 };
 
 template <class T> class DelayThing {
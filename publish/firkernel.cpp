@@ -0,0 +1,101 @@
+#include "firkernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FIRKERNEL_X86
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FIRKERNEL_NEON
+#endif
+
+void firBlockScalar(const float *x, float *y, int n, const float *taps,
+                    int ntaps, int stride) {
+  for (int q = 0; q < n; q++) {
+    float acc = 0;
+    for (int t = 0; t < ntaps; t++)
+      acc += taps[t] * x[q + t * stride];
+    y[q] = acc;
+  }
+}
+
+#ifdef FIRKERNEL_X86
+
+__attribute__((target("sse2"))) static void
+firBlockSSE(const float *x, float *y, int n, const float *taps, int ntaps,
+            int stride) {
+  int q = 0;
+
+  for (; q + 8 <= n; q += 8) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    const float *p = x + q;
+    for (int t = 0; t < ntaps; t++, p += stride) {
+      __m128 tap = _mm_set1_ps(taps[t]);
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(tap, _mm_loadu_ps(p)));
+      acc1 = _mm_add_ps(acc1, _mm_mul_ps(tap, _mm_loadu_ps(p + 4)));
+    }
+    _mm_storeu_ps(y + q, acc0);
+    _mm_storeu_ps(y + q + 4, acc1);
+  }
+
+  firBlockScalar(x + q, y + q, n - q, taps, ntaps, stride);
+}
+
+__attribute__((target("avx2,fma"))) static void
+firBlockAVX2(const float *x, float *y, int n, const float *taps, int ntaps,
+             int stride) {
+  int q = 0;
+
+  for (; q + 16 <= n; q += 16) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    const float *p = x + q;
+    for (int t = 0; t < ntaps; t++, p += stride) {
+      __m256 tap = _mm256_set1_ps(taps[t]);
+      acc0 = _mm256_fmadd_ps(tap, _mm256_loadu_ps(p), acc0);
+      acc1 = _mm256_fmadd_ps(tap, _mm256_loadu_ps(p + 8), acc1);
+    }
+    _mm256_storeu_ps(y + q, acc0);
+    _mm256_storeu_ps(y + q + 8, acc1);
+  }
+
+  firBlockSSE(x + q, y + q, n - q, taps, ntaps, stride);
+}
+
+#endif
+
+#ifdef FIRKERNEL_NEON
+
+static void firBlockNEON(const float *x, float *y, int n, const float *taps,
+                         int ntaps, int stride) {
+  int q = 0;
+
+  for (; q + 8 <= n; q += 8) {
+    float32x4_t acc0 = vdupq_n_f32(0);
+    float32x4_t acc1 = vdupq_n_f32(0);
+    const float *p = x + q;
+    for (int t = 0; t < ntaps; t++, p += stride) {
+      acc0 = vmlaq_n_f32(acc0, vld1q_f32(p), taps[t]);
+      acc1 = vmlaq_n_f32(acc1, vld1q_f32(p + 4), taps[t]);
+    }
+    vst1q_f32(y + q, acc0);
+    vst1q_f32(y + q + 4, acc1);
+  }
+
+  firBlockScalar(x + q, y + q, n - q, taps, ntaps, stride);
+}
+
+#endif
+
+const KernelDispatch<FirBlockKernel> &firBlockKernels() {
+  static const KernelDispatch<FirBlockKernel> kernels("FIR", {
+#if defined(FIRKERNEL_X86)
+    {CPU_AVX2_FMA, firBlockAVX2},
+    {CPU_SSE2, firBlockSSE},
+#elif defined(FIRKERNEL_NEON)
+    {CPU_NEON, firBlockNEON},
+#endif
+    {CPU_SCALAR, firBlockScalar}
+  });
+  return kernels;
+}
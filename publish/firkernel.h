@@ -0,0 +1,18 @@
+#ifndef FIRKERNEL_H
+#define FIRKERNEL_H
+
+#include "cpudispatch.h"
+
+// Block FIR over a linear buffer: y[q] = sum_t taps[t] * x[q + t * stride]
+// for q in [0, n). A stride of 2 over interleaved I/Q filters both arms in
+// one pass, or skips the zero taps of half-band and Hilbert filters.
+typedef void (*FirBlockKernel)(const float *x, float *y, int n,
+                               const float *taps, int ntaps, int stride);
+
+// The block FIRs built for this CPU
+const KernelDispatch<FirBlockKernel> &firBlockKernels();
+
+void firBlockScalar(const float *x, float *y, int n, const float *taps,
+                    int ntaps, int stride);
+
+#endif // FIRKERNEL_H
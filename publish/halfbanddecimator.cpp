@@ -1,60 +1,66 @@
 #include "halfbanddecimator.h"
 
 HalfBandDecimator::HalfBandDecimator(int taps, int inlen) {
-
-  fir_i = new FIR(taps, inlen);
-  fir_q = new FIR(taps, inlen);
+  const float *points = nullptr;
 
   switch (taps) {
 
   case 51:
-    for (int i = 0; i < taps; i++) {
-      fir_i->FIRSetPoint(i, hbcoeff51[i]);
-      fir_q->FIRSetPoint(i, hbcoeff51[i]);
-    }
+    points = hbcoeff51;
     break;
   case 11:
-    for (int i = 0; i < taps; i++) {
-      fir_i->FIRSetPoint(i, hbcoeff11[i]);
-      fir_q->FIRSetPoint(i, hbcoeff11[i]);
-    }
+    points = hbcoeff11;
     break;
   case 23:
-    for (int i = 0; i < taps; i++) {
-      fir_i->FIRSetPoint(i, hbcoeff23[i]);
-      fir_q->FIRSetPoint(i, hbcoeff23[i]);
-    }
+    points = hbcoeff23;
     break;
   }
+
+  // taps is 4k + 3, so the center tap is odd and every even tap is used
+  halfTaps = (taps + 1) / 2;
+  coeff.assign(halfTaps, 0.0f);
+  center = 0;
+
+  if (points != nullptr) {
+    for (int i = 0; i < halfTaps; i++)
+      coeff[i] = points[2 * i];
+    center = points[(taps - 1) / 2];
+  }
+
+  evenHistory = 2 * (halfTaps - 1);
+  oddHistory = 2 * (halfTaps / 2);
+
+  even.assign(evenHistory + inlen, 0.0f);
+  odd.assign(oddHistory + inlen, 0.0f);
+
+  fir = firBlockKernels().best();
 }
-HalfBandDecimator::~HalfBandDecimator() {
-  delete fir_i;
-  delete fir_q;
-}
+HalfBandDecimator::~HalfBandDecimator() {}
 
 void HalfBandDecimator::decimate(const std::vector<cpx_typef> &in,
                                  std::vector<cpx_typef> &out) {
-  int step = 0;
-  // decimate half band 1
-  int size = (int)in.size();
-  for (int i = 0; i < size; ++i) {
-
-    cpx_typef curr;
+  const int outlen = (int)in.size() / 2;
+  const float *x = (const float *)in.data();
+  float *y = (float *)out.data();
 
-    if (i % 2 == 0) {
-      curr = cpx_typef(fir_i->FIRUpdateAndProcessHalfBandQueue(in[i].real()),
-                       fir_q->FIRUpdateAndProcessHalfBandQueue(in[i].imag()));
-      out[step] = curr;
+  even.resize(evenHistory + 2 * outlen);
+  odd.resize(oddHistory + 2 * outlen);
 
-      step++;
+  float *e = even.data() + evenHistory;
+  float *o = odd.data() + oddHistory;
+  for (int j = 0; j < outlen; j++) {
+    e[2 * j] = x[4 * j];
+    e[2 * j + 1] = x[4 * j + 1];
+    o[2 * j] = x[4 * j + 2];
+    o[2 * j + 1] = x[4 * j + 3];
+  }
 
-    } else {
+  // stride 2 keeps I and Q apart while filtering both in the same pass
+  fir(even.data(), y, 2 * outlen, coeff.data(), halfTaps, 2);
 
-      fir_i->FIRUpdateQueue(in[i].real());
-      fir_q->FIRUpdateQueue(in[i].imag());
-    }
-  }
+  for (int q = 0; q < 2 * outlen; q++)
+    y[q] += center * odd[q];
 
-  fir_i->FIRQueueBackToFront();
-  fir_q->FIRQueueBackToFront();
+  std::copy(even.end() - evenHistory, even.end(), even.begin());
+  std::copy(odd.end() - oddHistory, odd.end(), odd.begin());
 }
@@ -3,21 +3,36 @@
 
 #include "complex.h"
 #include "dsp.h"
+#include "firkernel.h"
 #include <QVector>
 
 typedef std::complex<float> cpx_typef;
 
+// Decimates by two with one pass over interleaved I/Q. The input is split
+// into even and odd samples: the non zero even taps form a short FIR over
+// the even samples and the odd samples only meet the center tap.
 class HalfBandDecimator {
 
 public:
   HalfBandDecimator(int taps, int inlen);
   ~HalfBandDecimator();
 
+  // in must hold an even number of samples, out at least half of them
   void decimate(const std::vector<cpx_typef> &in, std::vector<cpx_typef> &out);
 
 private:
-  FIR *fir_i;
-  FIR *fir_q;
+  int halfTaps;
+  float center;
+  std::vector<float> coeff;
+
+  // interleaved I/Q, each after the history the filter needs from the
+  // previous block
+  std::vector<float> even;
+  std::vector<float> odd;
+  int evenHistory;
+  int oddHistory;
+
+  FirBlockKernel fir;
 
   float hbcoeff51[51]{0.0010175926971811044,  0.0,
                       -0.0013058886799502411, 0.0,
@@ -0,0 +1,123 @@
+#include "iqfile.h"
+#include "logger.h"
+#include <cmath>
+
+IQFile::IQFile() { format = None; }
+
+IQFile::~IQFile() { close(); }
+
+IQFile::Format IQFile::parseFormat(const QString &format) {
+  const QString lower = format.toLower();
+
+  if (lower == "cf32")
+    return CF32;
+  else if (lower == "cs16")
+    return CS16;
+  else if (lower == "cs8")
+    return CS8;
+
+  return None;
+}
+
+int IQFile::bytesPerSample() const {
+  switch (format) {
+  case CF32:
+    return 2 * sizeof(float);
+  case CS16:
+    return 2 * sizeof(qint16);
+  case CS8:
+    return 2 * sizeof(qint8);
+  default:
+    return 0;
+  }
+}
+
+bool IQFile::open(const QString &path, Format format,
+                  QIODevice::OpenMode mode) {
+  close();
+
+  if (format == None) {
+    CRIT("Invalid IQ file format for %s", path.toStdString().c_str());
+    return false;
+  }
+
+  this->format = format;
+
+  file.setFileName(path);
+  if (!file.open(mode)) {
+    CRIT("Failed to open IQ file %s: %s", path.toStdString().c_str(),
+         file.errorString().toStdString().c_str());
+    return false;
+  }
+
+  return true;
+}
+
+void IQFile::close() {
+  if (file.isOpen()) {
+    file.close();
+  }
+}
+
+bool IQFile::write(const float *data, int samples) {
+  const qint64 size = (qint64)samples * bytesPerSample();
+  const char *out = (const char *)data;
+
+  if (format == CS16) {
+    scratch.resize(size);
+    qint16 *dst = (qint16 *)scratch.data();
+    for (int i = 0; i < 2 * samples; i++) {
+      float v = qBound(-1.0f, data[i], 1.0f);
+      dst[i] = (qint16)lrintf(v * CS16_FULL_SCALE);
+    }
+    out = scratch.data();
+  } else if (format == CS8) {
+    scratch.resize(size);
+    qint8 *dst = (qint8 *)scratch.data();
+    for (int i = 0; i < 2 * samples; i++) {
+      float v = qBound(-1.0f, data[i], 1.0f);
+      dst[i] = (qint8)lrintf(v * CS8_FULL_SCALE);
+    }
+    out = scratch.data();
+  }
+
+  if (file.write(out, size) != size) {
+    CRIT("Failed to write IQ samples: %s",
+         file.errorString().toStdString().c_str());
+    return false;
+  }
+
+  return true;
+}
+
+int IQFile::read(float *data, int maxSamples) {
+  const int width = bytesPerSample();
+  qint64 size = (qint64)maxSamples * width;
+  char *in = (char *)data;
+
+  if (format != CF32) {
+    scratch.resize(size);
+    in = scratch.data();
+  }
+
+  size = file.read(in, size);
+  if (size < 0) {
+    CRIT("Failed to read IQ samples: %s",
+         file.errorString().toStdString().c_str());
+    return -1;
+  }
+
+  int samples = (int)(size / width);
+
+  if (format == CS16) {
+    const qint16 *src = (const qint16 *)scratch.data();
+    for (int i = 0; i < 2 * samples; i++)
+      data[i] = src[i] * (1.0f / CS16_FULL_SCALE);
+  } else if (format == CS8) {
+    const qint8 *src = (const qint8 *)scratch.data();
+    for (int i = 0; i < 2 * samples; i++)
+      data[i] = src[i] * (1.0f / CS8_FULL_SCALE);
+  }
+
+  return samples;
+}
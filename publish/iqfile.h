@@ -0,0 +1,45 @@
+#ifndef IQFILE_H
+#define IQFILE_H
+
+#include <QFile>
+#include <QString>
+#include <vector>
+
+// Full scale of the integer formats, used both ways and rounded to nearest so
+// a replay reproduces the recording as closely as the format allows
+const float CS16_FULL_SCALE = 32767.0f;
+const float CS8_FULL_SCALE = 127.0f;
+
+// Raw interleaved IQ recording in one of the SoapySDR sample formats, without
+// any header so captures can be exchanged with other SDR tools. Samples are
+// always CF32 in memory; CS16 and CS8 are scaled to full scale on disk.
+class IQFile {
+public:
+  enum Format { None, CF32, CS16, CS8 };
+
+  IQFile();
+  IQFile(const IQFile &) = delete;
+  ~IQFile();
+
+  IQFile &operator=(const IQFile &) = delete;
+
+  static Format parseFormat(const QString &format);
+
+  bool open(const QString &path, Format format, QIODevice::OpenMode mode);
+  void close();
+
+  // Counts are complex samples, data is interleaved I/Q floats
+  bool write(const float *data, int samples);
+  int read(float *data, int maxSamples);
+
+  Format getFormat() const { return format; }
+  int bytesPerSample() const;
+
+private:
+  QFile file;
+  Format format;
+
+  std::vector<char> scratch;
+};
+
+#endif
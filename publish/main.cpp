@@ -1,6 +1,7 @@
 #include <QCommandLineParser>
 #include <QCoreApplication>
 #include <QList>
+#include <QThread>
 #include <QTimer>
 #include <SoapySDR/Logger.hpp>
 
@@ -22,6 +23,27 @@ int main(int argc, char *argv[]) {
                                       "Show verbose output"));
   parser.addOption(QCommandLineOption("enable-biast", "Enable Bias-T"));
   parser.addOption(QCommandLineOption("enable-dcc", "Enable DC correction"));
+  parser.addOption(QCommandLineOption(
+      "channelizer",
+      "Split the band once with a polyphase filter bank instead of mixing and "
+      "decimating the full rate stream per VFO"));
+  parser.addOption(QCommandLineOption(
+      "threads",
+      "Number of worker threads VFOs are processed on (default: number of CPU "
+      "cores)",
+      "threads"));
+  parser.addOption(QCommandLineOption(
+      "record", "Record the raw SDR IQ stream to a file while publishing",
+      "record"));
+  parser.addOption(QCommandLineOption(
+      "replay",
+      "Publish from an IQ recording as fast as possible instead of the SDR",
+      "replay"));
+  parser.addOption(QCommandLineOption(
+      "iq-format",
+      "Sample format of --record and --replay files; valid: cf32 (default), "
+      "cs16, cs8",
+      "iq-format"));
   parser.addPositionalArgument(
       "settings", "Path to SDRReceiver compliant satellite settings INI file");
   parser.process(core);
@@ -33,13 +55,42 @@ int main(int argc, char *argv[]) {
 
   bool enableBiast = parser.isSet("enable-biast");
   bool enableDcc = parser.isSet("enable-dcc");
+  bool enableChannelizer = parser.isSet("channelizer");
+
+  const QString recordPath = parser.value("record");
+  const QString replayPath = parser.value("replay");
 
   const QString deviceStr = parser.value("device");
-  if (deviceStr.isEmpty()) {
+  if (deviceStr.isEmpty() && replayPath.isEmpty()) {
     CRIT("Required device option missing; example: -d driver=rtlsdr");
     return 1;
   }
 
+  if (!recordPath.isEmpty() && !replayPath.isEmpty()) {
+    CRIT("--record and --replay cannot be used together");
+    return 1;
+  }
+
+  IQFile::Format iqFormat = IQFile::CF32;
+  if (parser.isSet("iq-format")) {
+    iqFormat = IQFile::parseFormat(parser.value("iq-format"));
+    if (iqFormat == IQFile::None) {
+      CRIT("Invalid IQ format provided: %s",
+           parser.value("iq-format").toStdString().c_str());
+      return 1;
+    }
+  }
+
+  int threads = QThread::idealThreadCount();
+  if (parser.isSet("threads")) {
+    threads = parser.value("threads").toInt();
+    if (threads < 1) {
+      CRIT("Invalid number of worker threads: %s",
+           parser.value("threads").toStdString().c_str());
+      return 1;
+    }
+  }
+
   const QStringList args = parser.positionalArguments();
   if (args.isEmpty()) {
     CRIT("Required settings path missing; please provide the path to a "
@@ -48,7 +99,15 @@ int main(int argc, char *argv[]) {
   }
 
   EventNotifier notifier;
-  Publisher publisher(deviceStr, enableBiast, enableDcc, args.at(0));
+  Publisher publisher(replayPath.isEmpty() ? deviceStr : QString(),
+                      enableBiast, enableDcc, enableChannelizer, args.at(0));
+  publisher.setWorkerThreads(threads);
+
+  if (!recordPath.isEmpty() && !publisher.setRecordFile(recordPath, iqFormat))
+    return 1;
+
+  if (!replayPath.isEmpty() && !publisher.setReplayFile(replayPath, iqFormat))
+    return 1;
 
   QObject::connect(&notifier, SIGNAL(hangup()), &publisher, SLOT(handleHup()));
   QObject::connect(&notifier, SIGNAL(interrupt()), &publisher,
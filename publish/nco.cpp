@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cmath>
+
+#include "cpudispatch.h"
+#include "nco.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NCO_X86
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NCO_NEON
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846264338327950288
+#endif
+
+// out[k] = in[k] * start * table[k] over interleaved I/Q
+static void mixScalar(const float *in, const float *table, cpx_typef start,
+                      float *out, int n) {
+  const float sr = start.real();
+  const float si = start.imag();
+
+  for (int k = 0; k < n; k++) {
+    const float pr = sr * table[2 * k] - si * table[2 * k + 1];
+    const float pi = sr * table[2 * k + 1] + si * table[2 * k];
+    const float ir = in[2 * k];
+    const float ii = in[2 * k + 1];
+
+    out[2 * k] = ir * pr - ii * pi;
+    out[2 * k + 1] = ir * pi + ii * pr;
+  }
+}
+
+#ifdef NCO_X86
+
+__attribute__((target("avx2,fma"))) static inline __m256
+cpxMulAVX2(__m256 a, __m256 b) {
+  const __m256 bre = _mm256_moveldup_ps(b);
+  const __m256 bim = _mm256_movehdup_ps(b);
+  const __m256 swap = _mm256_permute_ps(a, 0xB1);
+
+  return _mm256_fmaddsub_ps(a, bre, _mm256_mul_ps(swap, bim));
+}
+
+__attribute__((target("avx2,fma"))) static void
+mixAVX2(const float *in, const float *table, cpx_typef start, float *out,
+        int n) {
+  const __m256 s = _mm256_setr_ps(start.real(), start.imag(), start.real(),
+                                  start.imag(), start.real(), start.imag(),
+                                  start.real(), start.imag());
+  int k = 0;
+
+  for (; k + 4 <= n; k += 4) {
+    __m256 p = cpxMulAVX2(_mm256_loadu_ps(table + 2 * k), s);
+    _mm256_storeu_ps(out + 2 * k, cpxMulAVX2(_mm256_loadu_ps(in + 2 * k), p));
+  }
+
+  mixScalar(in + 2 * k, table + 2 * k, start, out + 2 * k, n - k);
+}
+
+#endif
+
+#ifdef NCO_NEON
+
+static void mixNEON(const float *in, const float *table, cpx_typef start,
+                    float *out, int n) {
+  const float sr = start.real();
+  const float si = start.imag();
+  int k = 0;
+
+  for (; k + 4 <= n; k += 4) {
+    float32x4x2_t t = vld2q_f32(table + 2 * k);
+    float32x4x2_t x = vld2q_f32(in + 2 * k);
+    float32x4x2_t y;
+
+    float32x4_t pr = vmlsq_n_f32(vmulq_n_f32(t.val[0], sr), t.val[1], si);
+    float32x4_t pi = vmlaq_n_f32(vmulq_n_f32(t.val[1], sr), t.val[0], si);
+
+    y.val[0] = vmlsq_f32(vmulq_f32(x.val[0], pr), x.val[1], pi);
+    y.val[1] = vmlaq_f32(vmulq_f32(x.val[0], pi), x.val[1], pr);
+    vst2q_f32(out + 2 * k, y);
+  }
+
+  mixScalar(in + 2 * k, table + 2 * k, start, out + 2 * k, n - k);
+}
+
+#endif
+
+static const KernelDispatch<NCO::MixKernel> &mixKernels() {
+  static const KernelDispatch<NCO::MixKernel> kernels("NCO mix", {
+#if defined(NCO_X86)
+    {CPU_AVX2_FMA, mixAVX2},
+#elif defined(NCO_NEON)
+    {CPU_NEON, mixNEON},
+#endif
+    {CPU_SCALAR, mixScalar}
+  });
+  return kernels;
+}
+
+NCO::NCO(double sampleRate, double frequency) {
+  const double step = 2.0 * M_PI * frequency / sampleRate;
+
+  table.resize(NCO_CHUNK);
+  for (int k = 0; k < NCO_CHUNK; k++)
+    table[k] = cpx_typef(std::cos(step * k), std::sin(step * k));
+
+  chunkStep = std::fmod(step * NCO_CHUNK, 2.0 * M_PI);
+  phase = 0;
+  start = cpx_typef(1.0f, 0);
+  pos = 0;
+
+  kernel = mixKernels().best();
+}
+
+void NCO::mix(const cpx_typef *in, cpx_typef *out, int n) {
+  int done = 0;
+
+  while (done < n) {
+    const int count = std::min(n - done, NCO_CHUNK - pos);
+
+    kernel((const float *)(in + done), (const float *)(table.data() + pos),
+           start, (float *)(out + done), count);
+
+    done += count;
+    pos += count;
+
+    if (pos == NCO_CHUNK) {
+      phase = std::fmod(phase + chunkStep, 2.0 * M_PI);
+      start = cpx_typef(std::cos(phase), std::sin(phase));
+      pos = 0;
+    }
+  }
+}
@@ -0,0 +1,38 @@
+#ifndef NCO_H
+#define NCO_H
+
+#include <complex>
+#include <vector>
+
+typedef std::complex<float> cpx_typef;
+
+// Samples mixed per phasor chunk
+const int NCO_CHUNK = 256;
+
+// Block mixer multiplying a buffer by exp(j 2 pi f n / Fs). Phasors come from
+// a one chunk table rotated by a start phasor that is recomputed per chunk
+// from a double precision phase accumulator, so memory doesn't scale with
+// the sample rate and the phase never drifts or wraps.
+class NCO {
+public:
+  typedef void (*MixKernel)(const float *in, const float *table,
+                            cpx_typef start, float *out, int n);
+
+  NCO(double sampleRate, double frequency);
+
+  // in may equal out
+  void mix(const cpx_typef *in, cpx_typef *out, int n);
+
+private:
+  std::vector<cpx_typef> table;
+  double phase;
+  double chunkStep;
+
+  // phasor at the start of the current chunk and the position within it
+  cpx_typef start;
+  int pos;
+
+  MixKernel kernel;
+};
+
+#endif // NCO_H
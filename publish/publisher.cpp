@@ -1,7 +1,9 @@
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QSettings>
 #include <SoapySDR/Constants.h>
 #include <SoapySDR/Device.hpp>
+#include <SoapySDR/Errors.h>
 #include <SoapySDR/Formats.hpp>
 #include <qglobal.h>
 #include <sys/socket.h>
@@ -11,19 +13,36 @@
 #include "publisher.h"
 
 Publisher::Publisher(const QString &deviceStr, bool enableBiast, bool enableDcc,
-                     const QString &settingsPath, QObject *parent)
+                     bool enableChannelizer, const QString &settingsPath,
+                     QObject *parent)
     : QObject(parent) {
   this->enableBiast = enableBiast;
   this->enableDcc = enableDcc;
+  this->enableChannelizer = enableChannelizer;
 
   tuner_gain = 496;
   running = false;
+  recording = false;
+  replaying = false;
+
+  device = nullptr;
+  stream = nullptr;
+  channelizer = nullptr;
+  pool = nullptr;
+  ring = nullptr;
+  workerThreads = QThread::idealThreadCount();
 
   if (!loadSettings(settingsPath)) {
     CRIT("[ERROR] failed to parse and load settings");
     return;
   }
 
+  // no device when replaying a recording
+  if (deviceStr.isEmpty()) {
+    running = true;
+    return;
+  }
+
   device = SoapySDR::Device::make(deviceStr.toStdString());
   if (device == nullptr) {
     CRIT("[ERROR] failed to find device: %s", deviceStr.toStdString().c_str());
@@ -41,6 +60,8 @@ Publisher::Publisher(const QString &deviceStr, bool enableBiast, bool enableDcc,
 }
 
 Publisher::~Publisher() {
+  mainReader.waitForFinished();
+
   if (stream != nullptr) {
     device->deactivateStream(stream);
     device->closeStream(stream);
@@ -50,6 +71,10 @@ Publisher::~Publisher() {
     device->writeSetting("biastee", "false");
     SoapySDR::Device::unmake(device);
   }
+
+  delete ring;
+  delete pool;
+  delete channelizer;
 }
 
 bool Publisher::loadSettings(const QString &settingsPath) {
@@ -108,6 +133,21 @@ bool Publisher::loadSettings(const QString &settingsPath) {
 
   QString zmq_address = settings.value("zmq_address").toString();
 
+  if (enableChannelizer) {
+    // 2x oversampled channels at 48 kHz, the highest VFO output rate
+    channelizer = new Channelizer(Fs, 2 * Fs / 48000);
+
+    if ((buflen / 2) % channelizer->getDecimation() != 0) {
+      CRIT("Channelizer decimation %d does not divide the %d sample buffers",
+           channelizer->getDecimation(), buflen / 2);
+      return false;
+    }
+
+    INF("Channelizer: %d channels %.0f Hz apart at %d Hz",
+        channelizer->getChannelCount(), channelizer->getChannelSpacing(),
+        channelizer->getChannelRate());
+  }
+
   this->enableDcc =
       enableDcc ||
       (settings.value("correct_dc_bias").toString() == "1" ? true : false);
@@ -125,6 +165,12 @@ bool Publisher::loadSettings(const QString &settingsPath) {
     QString output_connect = settings.value("zmq_address").toString();
     QString out_topic = settings.value("zmq_topic").toString();
 
+    // with the channelizer a main VFO only matters when it publishes IQ
+    if (channelizer != nullptr && (output_connect == "" || out_topic == "")) {
+      delete pVFO;
+      continue;
+    }
+
     int compscale = settings.value("compress_scale").toInt();
 
     if (compscale > 0) {
@@ -143,7 +189,8 @@ bool Publisher::loadSettings(const QString &settingsPath) {
     pVFO->setDemodUSB(false);
     pVFO->setCompressonStyle(1);
     pVFO->init(buflen / 2, false);
-    pVFO->setVFOs(&VFOsub[i]);
+    if (channelizer == nullptr)
+      pVFO->setVFOs(&VFOsub[i]);
     VFOmain.push_back(pVFO);
   }
 
@@ -176,6 +223,44 @@ bool Publisher::loadSettings(const QString &settingsPath) {
     }
 
     int filterbw = settings.value("filter_bandwidth").toInt();
+
+    pVFO->setZmqTopic(settings.value("topic").toString());
+    pVFO->setZmqAddress(zmq_address);
+    pVFO->setFilterBandwidth(filterbw);
+    pVFO->setGain((float)settings.value("gain").toFloat() / 100);
+    pVFO->setCompressonStyle(1);
+
+    // the filter bank channel already did the coarse tuning and decimation,
+    // the VFO only mixes out the residual offset and decimates to out_rate
+    if (channelizer != nullptr) {
+      int offset = vfo_freq - center_frequency;
+      int channel_rate = channelizer->getChannelRate();
+      double residual = 0;
+
+      if (std::abs(offset) >= Fs / 2 || out_rate <= 0 ||
+          out_rate > channel_rate) {
+        CRIT("VFO %s at %d Hz with out_rate %d cannot be channelized",
+             settings.value("topic").toString().toStdString().c_str(),
+             vfo_freq, out_rate);
+        delete pVFO;
+        return false;
+      }
+
+      int channel = channelizer->channelForOffset(offset, residual);
+      channelizer->enableChannel(channel);
+
+      pVFO->setDecimationCount(int(log2(channel_rate / out_rate)));
+      pVFO->setMixerFreq(-residual);
+      pVFO->setFs(channel_rate);
+      pVFO->init((buflen / 2) / channelizer->getDecimation(), true);
+
+      VFOchannel.push_back(pVFO);
+      VFOchannelIdx.push_back(channel);
+
+      vfo_str.push_back(settings.value("topic").toString());
+      continue;
+    }
+
     int main_vfo_freq = 0;
     int main_vfo_out_rate = Fs;
     int main_idx = 0;
@@ -192,9 +277,6 @@ bool Publisher::loadSettings(const QString &settingsPath) {
       }
     }
 
-    pVFO->setZmqTopic(settings.value("topic").toString());
-    pVFO->setZmqAddress(zmq_address);
-
     int lateDecimate = 0;
     if ((main_vfo_out_rate / 48000) == 5) {
       pVFO->setDecimationCount(int(log2(main_vfo_out_rate / (5 * out_rate))));
@@ -209,11 +291,8 @@ bool Publisher::loadSettings(const QString &settingsPath) {
                                int(log2(Fs / main_vfo_out_rate)));
     }
 
-    pVFO->setFilterBandwidth(filterbw);
-    pVFO->setGain((float)settings.value("gain").toFloat() / 100);
     pVFO->setMixerFreq((center_frequency - main_vfo_freq) - vfo_freq);
     pVFO->setFs(main_vfo_out_rate);
-    pVFO->setCompressonStyle(1);
     pVFO->init(main_vfo_out_rate / bufsplit, true, lateDecimate);
 
     VFOsub[main_idx].push_back(pVFO);
@@ -223,31 +302,76 @@ bool Publisher::loadSettings(const QString &settingsPath) {
 
   settings.endArray();
 
+  for (int a = 0; a < VFOmain.length(); a++) {
+    vfo *pvfo = VFOmain.at(a);
+
+    if (pvfo->mpVFOs == 0)
+      continue;
+
+    for (int b = 0; b < pvfo->mpVFOs->length(); b++) {
+      VFOpooled.push_back(pvfo->mpVFOs->at(b));
+      VFOpooledIn.push_back(&pvfo->getOutput());
+    }
+  }
+
+  for (int a = 0; a < VFOchannel.length(); a++) {
+    VFOpooled.push_back(VFOchannel.at(a));
+    VFOpooledIn.push_back(&channelizer->output(VFOchannelIdx.at(a)));
+  }
+
   return true;
 }
 
+bool Publisher::setRecordFile(const QString &path, IQFile::Format format) {
+  recording = recordFile.open(path, format,
+                              QIODevice::WriteOnly | QIODevice::Truncate);
+  return recording;
+}
+
+bool Publisher::setReplayFile(const QString &path, IQFile::Format format) {
+  replaying = replayFile.open(path, format, QIODevice::ReadOnly);
+  return replaying;
+}
+
 void Publisher::run() {
-  DBG("Starting concurrent reader publishing thread");
-  mainReader = QtConcurrent::run([this] { return readerThread(); });
+  if (workerThreads > 1 && VFOpooled.length() > 1) {
+    pool = new WorkerPool(qMin(workerThreads, (int)VFOpooled.length()));
+    DBG("Processing %lld VFOs on %d worker threads", VFOpooled.length(),
+        pool->size());
+  }
+
+  if (replaying) {
+    DBG("Starting concurrent replay publishing thread");
+    mainReader = QtConcurrent::run([this] { return replayThread(); });
+  } else {
+    ring = new SampleRing(RING_BLOCKS, buflen / 2);
+
+    DBG("Starting concurrent reader publishing thread");
+    mainReader = QtConcurrent::run([this] { return readerThread(); });
+  }
 }
 
 void Publisher::readerThread() {
   int flags = 0;
   int samplesRead = 0;
+  int filled = 0;
   long long timeNs = 0;
-  float *samplesBuf = (float *)::malloc(buflen * sizeof(float));
+  bool dropping = false;
+  float *block = nullptr;
+  QFuture<void> dsp;
 
-  void *sampleBuffers[] = {samplesBuf};
+  // the SDR keeps being drained into here while the ring is full
+  std::vector<float> overflowBuf(buflen);
+
+  void *sampleBuffers[] = {nullptr};
   SoapySDR::Kwargs streamArgs{{"buffers", std::to_string(24)},
                               {"bufflen", std::to_string(buflen)}};
 
   if (!running)
     goto Exit;
 
-  if (samplesBuf == nullptr) {
-    CRIT("Memory allocation failed for samplesBuf: out of memory when "
-         "attempting to allocate %lu bytes",
-         buflen * sizeof(float));
+  if (device == nullptr) {
+    CRIT("No SoapySDR device to read from");
     goto Exit;
   }
 
@@ -263,15 +387,146 @@ void Publisher::readerThread() {
     goto Exit;
   }
 
+  acquiring = 1;
+  dsp = QtConcurrent::run([this] { return dspThread(); });
+
+  // reads are assembled into whole ring blocks, the DSP never waits on the
+  // SDR mid buffer and the SDR never waits on the DSP
   while (running) {
-    samplesRead =
-        device->readStream(stream, sampleBuffers, buflen, flags, timeNs, 1e7);
+    if (block == nullptr) {
+      block = ring->acquireWrite();
+      if (block == nullptr) {
+        if (!dropping) {
+          WARN("DSP is %d buffers behind the SDR, dropping samples",
+               ring->capacity());
+        }
+        dropping = true;
+        droppedBlocks.ref();
+        block = overflowBuf.data();
+      } else {
+        dropping = false;
+      }
+      filled = 0;
+    }
+
+    sampleBuffers[0] = block + 2 * filled;
+    samplesRead = device->readStream(stream, sampleBuffers,
+                                     ring->getBlockSamples() - filled, flags,
+                                     timeNs, 1e7);
+    if (samplesRead == SOAPY_SDR_OVERFLOW) {
+      // the driver lost samples before they could be read
+      sdrOverflows.ref();
+      continue;
+    }
+
     if (samplesRead <= 0) {
       CRIT("SoapySDR could not read stream from SDR");
       break;
     }
 
+    filled += samplesRead;
+    if (filled < ring->getBlockSamples())
+      continue;
+
+    if (block != overflowBuf.data())
+      ring->commitWrite();
+    block = nullptr;
+  }
+
+  acquiring = 0;
+  dsp.waitForFinished();
+
+  logRingStats();
+
+Exit:
+  emit completed();
+}
+
+void Publisher::dspThread() {
+  const float *block = nullptr;
+  bool behind = false; // blocks were waiting behind the one being processed
+  int depth = 0;
+
+  for (;;) {
+    block = ring->acquireRead();
+    if (block == nullptr) {
+      // drain whatever was read before the reader stopped
+      if (!acquiring)
+        break;
+
+      // an empty ring is normal when the DSP keeps up, only count it having
+      // worked off a backlog
+      if (behind)
+        backlogs.ref();
+      behind = false;
+
+      QThread::msleep(RING_POLL_MS);
+      continue;
+    }
+
+    depth = ring->depth();
+    if (depth > 1)
+      behind = true;
+    if (depth > maxDepth.loadRelaxed())
+      maxDepth.storeRelaxed(depth);
+
+    // a failed write only stops the recording, publishing carries on
+    if (recording && !recordFile.write(block, ring->getBlockSamples())) {
+      WARN("Stopped recording IQ samples");
+      recording = false;
+      recordFile.close();
+    }
+
+    demodData(block, ring->getBlockSamples() * 2);
+    ring->commitRead();
+  }
+}
+
+void Publisher::logRingStats() {
+  if (ring == nullptr)
+    return;
+
+  INF("SDR overflows: %d, dropped buffers: %d, ring backlogs: %d, ring "
+      "depth: %d/%d (max %d)",
+      sdrOverflows.loadRelaxed(), droppedBlocks.loadRelaxed(),
+      backlogs.loadRelaxed(), ring->depth(), ring->capacity(),
+      maxDepth.loadRelaxed());
+}
+
+void Publisher::replayThread() {
+  int samplesRead = 0;
+  qint64 totalSamples = 0;
+  double seconds = 0;
+  QElapsedTimer elapsed;
+  float *samplesBuf = (float *)::malloc(buflen * sizeof(float));
+
+  if (!running)
+    goto Exit;
+
+  if (samplesBuf == nullptr) {
+    CRIT("Memory allocation failed for samplesBuf: out of memory when "
+         "attempting to allocate %lu bytes",
+         buflen * sizeof(float));
+    goto Exit;
+  }
+
+  elapsed.start();
+
+  // the VFO chains are sized for whole SDR buffers, so a trailing partial
+  // buffer at the end of the recording is dropped
+  while (running &&
+         (samplesRead = replayFile.read(samplesBuf, buflen / 2)) == buflen / 2) {
     demodData(samplesBuf, samplesRead * 2);
+    totalSamples += samplesRead;
+  }
+
+  seconds = elapsed.nsecsElapsed() / 1e9;
+
+  if (seconds > 0) {
+    INF("Replayed %lld samples (%.1f s of IQ) in %.3f s: %.0f samples/s, "
+        "%.1fx real time",
+        totalSamples, totalSamples / (double)Fs, seconds,
+        totalSamples / seconds, totalSamples / (double)Fs / seconds);
   }
 
 Exit:
@@ -298,6 +553,39 @@ void Publisher::demodData(const float *data, int len) {
     demodSamples[i] = curr;
   }
 
+  if (pool != nullptr) {
+    // main VFOs and the channelizer produce the input of the pooled VFOs, and
+    // both stages finish before the SDR buffer is reused
+    pool->run(VFOmain.length() + (channelizer != nullptr ? 1 : 0),
+              [this](int a) {
+                if (a == VFOmain.length()) {
+                  channelizer->process(demodSamples);
+                  return;
+                }
+
+                vfo *pvfo = VFOmain.at(a);
+                if (pvfo->mpVFOs != 0 && pvfo->mpVFOs->length() > 0)
+                  pvfo->mixDecimate(demodSamples);
+                else
+                  pvfo->process(demodSamples);
+              });
+
+    pool->run(VFOpooled.length(), [this](int a) {
+      VFOpooled.at(a)->process(*VFOpooledIn.at(a));
+    });
+    return;
+  }
+
+  if (channelizer != nullptr) {
+    channelizer->process(demodSamples);
+
+    for (int a = 0; a < VFOchannel.length(); a++) {
+      vfo *pvfo = VFOchannel.at(a);
+
+      pvfo->process(channelizer->output(VFOchannelIdx.at(a)));
+    }
+  }
+
   for (int a = 0; a < VFOmain.length(); a++) {
     vfo *pvfo = VFOmain.at(a);
 
@@ -308,7 +596,7 @@ void Publisher::demodData(const float *data, int len) {
 void Publisher::handleHup() {
   DBG("Got SIGHUP signal from EventNotifier");
 
-  // TODO: do debug dump for debugging?
+  logRingStats();
 }
 
 void Publisher::handleInterrupt() {
@@ -7,14 +7,25 @@
 #include <QtConcurrent>
 #include <SoapySDR/Device.hpp>
 
+#include "channelizer.h"
+#include "iqfile.h"
+#include "samplering.h"
 #include "vfo.h"
+#include "workerpool.h"
+
+// SDR buffers the reader can get ahead of the DSP before dropping samples
+const int RING_BLOCKS = 8;
+
+// How long the DSP thread sleeps when it finds the ring empty
+const int RING_POLL_MS = 1;
 
 class Publisher : public QObject {
   Q_OBJECT
 
 public:
   Publisher(const QString &deviceStr, bool enableBiast, bool enableDcc,
-            const QString &settingsPath, QObject *parent = nullptr);
+            bool enableChannelizer, const QString &settingsPath,
+            QObject *parent = nullptr);
   Publisher(const Publisher &) = delete;
   Publisher(Publisher &&) noexcept = delete;
   ~Publisher();
@@ -24,18 +35,41 @@ public:
   
   bool isRunning() const { return running; }
 
+  void setWorkerThreads(int workerThreads) {
+    this->workerThreads = workerThreads;
+  }
+
+  // Record the raw SDR stream while publishing, or publish from a recording
+  // instead of the SDR
+  bool setRecordFile(const QString &path, IQFile::Format format);
+  bool setReplayFile(const QString &path, IQFile::Format format);
+
 private:
   bool loadSettings(const QString &settingsPath);
   void readerThread();
+  void dspThread();
+  void replayThread();
+  void logRingStats();
   void demodData(const float *data, int len);
 
   const QList<int> validSampleRates = {288000, 1536000, 1920000};
 
   QFuture<void> mainReader;
 
+  // SDR reader to DSP hand over and its health counters
+  SampleRing *ring;
+  QAtomicInt acquiring;
+  QAtomicInt sdrOverflows;
+  QAtomicInt droppedBlocks;
+  QAtomicInt backlogs; // times the DSP fell behind and caught up again
+  QAtomicInt maxDepth;
+
   bool running;
   bool enableBiast;
   bool enableDcc;
+  bool enableChannelizer;
+  bool recording;
+  bool replaying;
 
   int Fs;
   int center_frequency;
@@ -50,8 +84,22 @@ private:
   QVector<vfo *> VFOsub[3];
   QVector<vfo *> VFOmain;
 
+  // channelizer mode: VFOs fed straight from a filter bank channel
+  Channelizer *channelizer;
+  QVector<vfo *> VFOchannel;
+  QVector<int> VFOchannelIdx;
+
+  // VFOs run on the worker pool once their input has been produced
+  int workerThreads;
+  WorkerPool *pool;
+  QVector<vfo *> VFOpooled;
+  QVector<const std::vector<cpx_typef> *> VFOpooledIn;
+
   std::vector<cpx_typef> demodSamples;
 
+  IQFile recordFile;
+  IQFile replayFile;
+
   SoapySDR::Device *device;
   SoapySDR::Stream *stream;
 
@@ -0,0 +1,32 @@
+#include "samplering.h"
+
+SampleRing::SampleRing(int blocks, int blockSamples)
+    : blocks(blocks), blockSamples(blockSamples),
+      storage((size_t)blocks * blockSamples * 2), head(0), tail(0) {}
+
+float *SampleRing::acquireWrite() {
+  const unsigned int h = head.loadRelaxed();
+
+  if (h - (unsigned int)tail.loadAcquire() >= (unsigned int)blocks)
+    return nullptr;
+
+  return storage.data() + (size_t)(h % blocks) * blockSamples * 2;
+}
+
+void SampleRing::commitWrite() { head.fetchAndAddRelease(1); }
+
+const float *SampleRing::acquireRead() {
+  const unsigned int t = tail.loadRelaxed();
+
+  if ((unsigned int)head.loadAcquire() == t)
+    return nullptr;
+
+  return storage.data() + (size_t)(t % blocks) * blockSamples * 2;
+}
+
+void SampleRing::commitRead() { tail.fetchAndAddRelease(1); }
+
+int SampleRing::depth() const {
+  return (int)((unsigned int)head.loadAcquire() -
+               (unsigned int)tail.loadAcquire());
+}
@@ -0,0 +1,40 @@
+#ifndef SAMPLERING_H
+#define SAMPLERING_H
+
+#include <QAtomicInt>
+#include <vector>
+
+// Single producer, single consumer ring of whole SDR buffers between the
+// reader and the DSP thread. Every block is allocated up front and the two
+// indices are the only shared state, so neither side ever takes a lock.
+class SampleRing {
+public:
+  // blockSamples is in complex samples, blocks hold interleaved I/Q floats
+  SampleRing(int blocks, int blockSamples);
+  SampleRing(const SampleRing &) = delete;
+
+  SampleRing &operator=(const SampleRing &) = delete;
+
+  // Producer side: the next free block, nullptr when the ring is full
+  float *acquireWrite();
+  void commitWrite();
+
+  // Consumer side: the oldest filled block, nullptr when the ring is empty
+  const float *acquireRead();
+  void commitRead();
+
+  int depth() const;
+  int capacity() const { return blocks; }
+  int getBlockSamples() const { return blockSamples; }
+
+private:
+  int blocks;
+  int blockSamples;
+  std::vector<float> storage;
+
+  // free running block counters, only ever advanced by their own side
+  QAtomicInt head;
+  QAtomicInt tail;
+};
+
+#endif
@@ -57,7 +57,7 @@ vfo::~vfo() {
 void vfo::init(int samplesPerBuffer, bool bind, int lateDecimate) {
 
   firfilter filt;
-  osc_mix = new Oscillator(Fs, mixer_freq);
+  osc_mix = new NCO(Fs, mixer_freq);
 
   int targetRate = Fs / (pow(2, decimateCount));
   int samplesOut = samplesPerBuffer / (pow(2, decimateCount));
@@ -87,7 +87,7 @@ void vfo::init(int samplesPerBuffer, bool bind, int lateDecimate) {
     }
   }
   outputRate = targetRate;
-  osc_bfo = new Oscillator(outputRate, offsetbw);
+  osc_bfo = new NCO(outputRate, offsetbw);
 
   if (filterbw > 0) {
 
@@ -125,6 +125,10 @@ void vfo::init(int samplesPerBuffer, bool bind, int lateDecimate) {
     decimate[a].resize(decimate[a - 1].size() / 2);
   }
 
+  demod_re.resize(decimate[decimateCount].size());
+  demod_im.resize(decimate[decimateCount].size());
+  demod_usb.resize(decimate[decimateCount].size());
+
   if (!vfo::bind_publisher.connected && bind) {
     vfo::bind_publisher.setAddress(zmqAddress);
     vfo::bind_publisher.setBind(bind);
@@ -151,18 +155,18 @@ void vfo::setFilterBandwidth(double bw) { filterbw = bw; }
 
 void vfo::setGain(float g) { gain = g; }
 
-void vfo::process(const std::vector<cpx_typef> &samples) {
-  for (long unsigned int i = 0; i < samples.size(); ++i) {
-    // mix
-    cpx_typef curr = osc_mix->_vector * samples.at(i);
-    osc_mix->tick();
+void vfo::mixDecimate(const std::vector<cpx_typef> &samples) {
+  // mix
+  osc_mix->mix(samples.data(), decimate[0].data(), (int)samples.size());
 
-    decimate[0][i] = curr;
-  }
   // decimate
   for (int i = 0; i < decimateCount; i++) {
     hdecimator[i]->decimate(decimate[i], decimate[i + 1]);
   }
+}
+
+void vfo::process(const std::vector<cpx_typef> &samples) {
+  mixDecimate(samples);
 
   if (mpVFOs != 0 && mpVFOs->length() > 0) {
     for (int a = 0; a < mpVFOs->length(); a++) {
@@ -186,59 +190,42 @@ void vfo::process(const std::vector<cpx_typef> &samples) {
 }
 
 void vfo::usb_demod() {
+  std::vector<cpx_typef> &in = decimate[decimateCount];
+  const int n = (int)in.size();
 
-  for (long unsigned int i = 0; i < decimate[decimateCount].size(); i++) {
-
-    cpx_typef curr = decimate[decimateCount][i];
-
-    if (offsetbw > 1) {
-      curr = osc_bfo->_vector * curr;
-      osc_bfo->tick();
-    }
-
-    float usb = 0;
-
-    if (filterbw > 0) {
-      usb = fir_usb->FIRUpdateAndProcess(
-          delayT.update_dont_touch(curr.real()) -
-          philbert->FIRUpdateAndProcess(curr.imag()));
-    }
+  if (offsetbw > 1) {
+    osc_bfo->mix(in.data(), in.data(), n);
+  }
 
-    else {
-      usb = delayT.update_dont_touch(curr.real()) -
-            philbert->FIRUpdateAndProcess(curr.imag());
-    }
+  for (int i = 0; i < n; i++) {
+    cpx_typef curr = in[i];
 
-    transmit_usb[i] = usb * gain * 32768.0;
+    demod_re[i] = curr.real();
+    demod_im[i] = curr.imag();
   }
+
+  usb_block(n);
 }
 
 void vfo::usb_decimdemod() {
 
   int mark = 0;
   int check = 0;
+
+  if (offsetbw > 1) {
+    osc_bfo->mix(decimate[decimateCount].data(),
+                 decimate[decimateCount].data(),
+                 (int)decimate[decimateCount].size());
+  }
+
   for (long unsigned int i = 0; i < decimate[decimateCount].size(); i++) {
     cpx_typef curr = decimate[decimateCount][i];
 
     // low pass
-
-    if (offsetbw > 1) {
-      curr = osc_bfo->_vector * curr;
-      osc_bfo->tick();
-    }
-
     if (check == 0) {
-      curr = cpx_typef(fir_decI->FIRUpdateAndProcess(curr.real()),
-                       fir_decQ->FIRUpdateAndProcess(curr.imag()));
+      demod_re[mark] = fir_decI->FIRUpdateAndProcess(curr.real());
+      demod_im[mark] = fir_decQ->FIRUpdateAndProcess(curr.imag());
 
-      float usb = delayT.update_dont_touch(curr.real()) -
-                  philbert->FIRUpdateAndProcess(curr.imag());
-
-      if (filterbw > 0) {
-        usb = fir_usb->FIRUpdateAndProcess(usb);
-      }
-
-      transmit_usb[mark] = usb * gain * 32768.0;
       mark++;
       check++;
 
@@ -255,6 +242,25 @@ void vfo::usb_decimdemod() {
       check++;
     }
   }
+
+  usb_block(mark);
+}
+
+void vfo::usb_block(int n) {
+  // upper side band: delayed I minus Hilbert transformed Q
+  philbert->FIRProcessBlock(demod_im.data(), demod_im.data(), n);
+
+  for (int i = 0; i < n; i++) {
+    demod_usb[i] = delayT.update_dont_touch(demod_re[i]) - demod_im[i];
+  }
+
+  if (filterbw > 0) {
+    fir_usb->FIRProcessBlock(demod_usb.data(), demod_usb.data(), n);
+  }
+
+  for (int i = 0; i < n; i++) {
+    transmit_usb[i] = demod_usb[i] * gain * 32768.0;
+  }
 }
 
 void vfo::compress() {
@@ -4,7 +4,7 @@
 #include "qstring.h"
 #include "zmqpublisher.h"
 #include "halfbanddecimator.h"
-#include "oscillator.h"
+#include "nco.h"
 
 
 
@@ -20,6 +20,8 @@ public:
 
     void init(int samplesPerBuffer, bool bind, int lateDecimate = 0);
     void process(const std::vector<cpx_typef> & samples);
+    void mixDecimate(const std::vector<cpx_typef> & samples);
+    const std::vector<cpx_typef> & getOutput() const { return decimate[decimateCount]; }
     void setZmqAddress(QString bind);
     void setZmqTopic(QString topic);
     void setScaleComp(int scale);
@@ -65,6 +67,11 @@ private:
 
     QVector<cpx_typef> out;
 
+    // USB demodulator scratch, one buffer at a time
+    std::vector<float> demod_re;
+    std::vector<float> demod_im;
+    std::vector<float> demod_usb;
+
     std::vector<short> transmit_usb;
     std::vector<signed char> transmit_iq;
 
@@ -80,8 +87,8 @@ private:
     uint32_t outputRate;
 
     //WaveTable * mix_bfo;
-    Oscillator * osc_bfo;
-    Oscillator * osc_mix;
+    NCO * osc_bfo;
+    NCO * osc_mix;
 
     float gain;
 
@@ -89,6 +96,7 @@ private:
     double bandwidth;
     void usb_demod();
     void usb_decimdemod();
+    void usb_block(int n);
     void compress();
     void transmitData();
 
@@ -0,0 +1,56 @@
+#include "workerpool.h"
+
+WorkerPool::WorkerPool(int threads) {
+  job = nullptr;
+  count = 0;
+  stopping = 0;
+
+  for (int i = 0; i < qMax(threads, 1); i++) {
+    Worker *worker = new Worker(this, i);
+    worker->start();
+    workers.append(worker);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  stopping = 1;
+
+  for (Worker *worker : workers) {
+    worker->wake.release();
+    worker->wait();
+  }
+
+  qDeleteAll(workers);
+}
+
+void WorkerPool::run(int count, const std::function<void(int)> &job) {
+  const int active = qMin(count, workers.size());
+
+  if (active == 0)
+    return;
+
+  this->job = &job;
+  this->count = count;
+
+  // the semaphores order the job hand over and the results for the caller
+  for (int i = 0; i < active; i++)
+    workers.at(i)->wake.release();
+
+  done.acquire(active);
+
+  this->job = nullptr;
+}
+
+void WorkerPool::Worker::run() {
+  for (;;) {
+    wake.acquire();
+
+    if (pool->stopping)
+      break;
+
+    for (int i = index; i < pool->count; i += pool->workers.size())
+      (*pool->job)(i);
+
+    pool->done.release();
+  }
+}
@@ -0,0 +1,49 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QSemaphore>
+#include <QThread>
+#include <functional>
+
+// Fixed set of DSP threads. Job i of a stage always runs on worker
+// i % size(), so as long as the job list is stable every VFO keeps its
+// filter state on the same core. run() is the barrier: it only returns once
+// all workers are done with the stage.
+class WorkerPool {
+public:
+  explicit WorkerPool(int threads);
+  WorkerPool(const WorkerPool &) = delete;
+  ~WorkerPool();
+
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  int size() const { return workers.size(); }
+
+  void run(int count, const std::function<void(int)> &job);
+
+private:
+  class Worker : public QThread {
+  public:
+    Worker(WorkerPool *pool, int index) : pool(pool), index(index) {}
+
+    QSemaphore wake;
+
+  protected:
+    void run();
+
+  private:
+    WorkerPool *pool;
+    int index;
+  };
+
+  QList<Worker *> workers;
+  QSemaphore done;
+  QAtomicInt stopping;
+
+  const std::function<void(int)> *job;
+  int count;
+};
+
+#endif
@@ -66,6 +66,7 @@ void ZmqPublisher::publish(unsigned char *buf, uint32_t len, QString topic,
   memcpy(rate, &sampleRate, 4);
 
   if (len != 0) {
+    QMutexLocker locker(&mutex);
     zmq_send(publisher, topic_text.c_str(), 5, ZMQ_SNDMORE);
     zmq_send(publisher, rate, 4, ZMQ_SNDMORE);
     zmq_send(publisher, buf, len, 0);
@@ -1,6 +1,7 @@
 #ifndef ZMQPUBLISHER_H
 #define ZMQPUBLISHER_H
 
+#include "QMutex"
 #include "QString"
 #include "zmq.h"
 
@@ -22,6 +23,9 @@ private:
   QString bindAddress;
   int zmqStatus;
   bool bind;
+
+  // the bind publisher is shared by VFOs running on different threads
+  QMutex mutex;
 };
 
 #endif // ZMQPUBLISHER_H